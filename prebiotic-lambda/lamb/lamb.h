@@ -29,6 +29,8 @@
 #    include <unistd.h>
 #    include <sys/wait.h>
 #    include <sys/stat.h>
+#    include <sys/mman.h>
+#    include <pthread.h>
 #endif // _WIN32
 
 #if defined(__GNUC__) || defined(__clang__)
@@ -96,6 +98,12 @@ typedef struct {
     size_t capacity;
 } String_Builder;
 
+typedef struct {
+    uint8_t *items;
+    size_t count;
+    size_t capacity;
+} Bytes;
+
 typedef struct {
     // Displayed name of the symbol.
     const char *label;
@@ -115,10 +123,16 @@ typedef struct {
     size_t unwrap;
 } Expr_Index;
 
+typedef struct Lamb_Context Lamb_Context;
+
 typedef struct {
     Expr_Kind kind;
     bool visited;
     bool live;
+    bool old;         // Survived GC_PROMOTE_AGE collections and was promoted out of the nursery
+    uint8_t age;      // Collections survived in the nursery
+    uint32_t rc;      // Parents plus app roots pointing here (GC_MODE_REFCOUNT only)
+    uint64_t hash;    // expr_hash() of a closed term, 0 = not computed yet or open
     union {
         Symbol var;
         const char *mag;
@@ -197,24 +211,162 @@ typedef enum { EVAL_DONE, EVAL_LIMIT, EVAL_ERROR } Eval_Result;
 // Cosmic ray rate: probability = COSMIC_RAY_RATE / 100000 per empty cell per step
 // For 120x80 grid (~5000 empty cells at 50% density): rate 10 → ~0.5 spawns/step
 #define COSMIC_RAY_RATE 1  // 0.01% per cell → ~0.5 spawns/step on typical grid
+// Side of a storage block in the blocked layout (a power of two). 64 cells plus
+// their halo take a few KB, well inside L1.
+#define GRID_BLOCK 8
+// Side of an allocation tile of a sparse world
+#define GRID_SPARSE_TILE 64
 
+// What grid_step() reads of every cell, packed into 8 bytes
 typedef struct {
-    Expr_Index atom;
+    uint32_t atom;          // Index of the expression, see cell_atom()
+    uint16_t age;           // Steps survived
     bool occupied;
-    int age;          // Steps survived
-    int generation;   // How many ancestors
+    bool local;             // Atom lives in the heap of the worker updating the cell (parallel grid_step)
+} Cell;
+
+#define cell_atom(cell) ((Expr_Index){ (cell)->atom })
+
+// The rest of a cell, only touched by updates (Grid.info)
+typedef struct {
+    int generation;         // How many ancestors
+    uint32_t swept;         // steps + 1 of the creature's last sweep update, moves with it
+    uint64_t hash;          // expr_hash() of the atom, set whenever it changes
     // Cached values for visualization (avoids per-frame recomputation)
-    uint32_t cached_hash;   // Structural hash of expression
     size_t cached_mass;     // AST node count
     bool cache_valid;       // True if cache is up-to-date
-} Cell;
+} Cell_Info;
 
+// Species of a grid in a live histogram (see grid_species_count())
 typedef struct {
+    uint64_t hash;        // 0 = free
+    uint32_t count;       // 0 with a hash = deleted
+    int32_t prev, next;   // Species with the same count, -1 = none
+} Grid_Species_Slot;
+
+// Open addressing on the hash. Every count chains its species, newest first,
+// so the dominant one is the head of the max_freq chain.
+typedef struct {
+    Grid_Species_Slot *slots;
+    size_t capacity;      // 0 or a power of two
+    size_t used;          // Slots with a hash, deleted ones included
+    size_t unique;
+    size_t max_freq;
+    struct {
+        int32_t *items;   // First species of every count, -1 = none
+        size_t count;
+        size_t capacity;
+    } heads;
+} Grid_Histogram;
+
+// Connected patches of one species on a grid (4-neighbourhood, across the
+// wrap too), see grid_clusters()
+#define GRID_CLUSTER_BINS 8
+typedef struct {
+    size_t clusters;
+    size_t largest;       // Cells of the biggest cluster
+    size_t boundary;      // Sides of occupied cells facing an empty cell or another species
+    size_t sizes[GRID_CLUSTER_BINS];  // Clusters of 1, 2-3, 4-7, ... cells, the last bin open ended
+    // Union-find scratch reused by the next call, one entry per cell
+    struct { int32_t *items; size_t count; size_t capacity; } parent;
+} Grid_Clusters;
+
+typedef struct Grid_Workers Grid_Workers;
+typedef struct Grid_Record Grid_Record;
+typedef struct Grid_Kinetic Grid_Kinetic;
+
+// Storage slot of a sparse world, holding the cells of one tile
+typedef struct {
+    int tile;             // Position in the tile directory, -1 = free
+    int population;       // Occupied cells, the tile is released at 0
+    int rank;             // Position among the live tiles of the current step
+} Grid_Slot;
+
+// Run parameters kept in a grid event log
+typedef struct {
+    uint64_t seed;
+    size_t eval_steps;
+    size_t max_mass;
+    bool tiled;           // Parallel (checkerboard) schedule
+    bool blocked;         // Blocked cell layout
+    bool sparse;          // Sparse world
+    bool kinetic;         // Continuous-time engine
+} Grid_Record_Info;
+
+typedef struct {
+    Lamb_Context *ctx;    // Heap the cell atoms live in
+    Grid_Workers *workers; // Parallel update state, NULL = serial (see grid_set_threads())
+    Grid_Record *record;  // Event log being written or replayed, NULL = none (see grid_record_start())
+    // Continuous-time engine, NULL = sweeps (see grid_set_kinetic()). A step
+    // is then one unit of simulated time.
+    Grid_Kinetic *kinetic;
+    bool want_kinetic;    // Survives grid_init()
+    double time;          // Simulated time, steps when sweeping
     int width;
     int height;
     Cell *cells;
+    Cell_Info *info;      // Parallel to cells
+    // Cell layout. Row-major, or GRID_BLOCK x GRID_BLOCK blocks stored one after
+    // another (block rows first, rows within a block) when blocked is asked for
+    // with grid_set_layout() and both sides are multiples of GRID_BLOCK. Cell
+    // indices are storage positions, go through grid_idx() and grid_xy().
+    bool want_blocked;    // Survives grid_init()
+    bool blocked;
+    int blocks_x;
+    int *block_next;      // Neighbouring blocks, 4 per block (N, E, S, W)
+    int local_next[4][GRID_BLOCK * GRID_BLOCK];  // Neighbour inside the block, or -(position + 1) in the next one
+    // Sparse world (see grid_set_sparse()). The torus is cut into
+    // GRID_SPARSE_TILE tiles, which get a storage slot when a cell in them is
+    // first occupied and give it back at the end of the step that empties
+    // them. A cell index is slot * tile area + row-major position in the tile.
+    bool want_sparse;     // Survives grid_init()
+    bool sparse;
+    int tiles_x;
+    int tiles_y;
+    int *tile_slot;       // Tile directory: slot of every tile, -1 = not allocated
+    struct {
+        Grid_Slot *items;
+        size_t count;
+        size_t capacity;
+    } slots;
+    size_t slots_allocated;  // Slots the cell arrays have room for
+    struct {
+        int *items;
+        size_t count;
+        size_t capacity;
+    } free_slots;
+    // Allocated tiles of the current step in directory order
+    struct {
+        int *items;
+        size_t count;
+        size_t capacity;
+    } live;
+    int cell_count;       // Length of cells: width * height, or the slots' cells when sparse
+    // Occupied cells in no particular order, and the position of every cell
+    // in it (-1 when empty). grid_step() sweeps these instead of the area.
+    struct {
+        int *items;
+        size_t count;
+        size_t capacity;
+    } active;
+    int *active_slot;
+    // Snapshot of active taken by grid_step(), grouped by block when blocked
+    // (block i owns sweep[sweep_start[i]..sweep_start[i + 1]]). Kept to spare
+    // an allocation.
+    struct {
+        int *items;
+        size_t count;
+        size_t capacity;
+    } sweep;
+    struct {
+        size_t *items;
+        size_t count;
+        size_t capacity;
+    } sweep_start;
     long steps;
     int population;       // Cached population count (maintained incrementally)
+    Grid_Histogram histogram;  // Cells per species, kept up to date by every spawn, death and reaction
+    Grid_Clusters clusters;    // Last grid_clusters() of grid_export_log(), which reuses its scratch
     // Statistics
     long reactions_success;
     long reactions_diverged;
@@ -226,15 +378,59 @@ typedef struct {
     long evasions;        // Evasive: A(B) -> False, A moves away
 } Grid;
 
+typedef struct Gas_Batch Gas_Batch;
+typedef struct Gas_Islands Gas_Islands;
+
+// Turing gas: a well-mixed pool of combinators colliding pairwise
+typedef struct {
+    Lamb_Context *ctx;       // Heap the pool lives in
+    struct {
+        Expr_Index *items;
+        size_t count;
+        size_t capacity;
+    } pool;
+    long total_steps;        // Collisions run so far (soup metadata)
+    size_t converged;
+    size_t diverged;
+    size_t errors;
+    Gas_Batch *batch;        // Batched collisions, NULL = one at a time (see gas_set_batch())
+    Gas_Islands *islands;    // Island model, NULL = one well-mixed pool (see gas_set_islands())
+} Gas;
+
+// Species of a gas pool by printed form
+typedef struct {
+    size_t population;
+    size_t unique;
+    size_t max_freq;
+    double entropy;          // Shannon entropy of the species frequencies (nats)
+    char *dominant;          // First species with max_freq in sorted order
+} Gas_Census;
+
 // ============================================================================
 // GC CONTEXT (Named struct for external access)
 // ============================================================================
 
+typedef enum {
+    GC_MODE_STOP_THE_WORLD,  // Major collections run to completion inside gc()
+    GC_MODE_INCREMENTAL,     // Major collections run as time-budgeted gc_step() slices
+    GC_MODE_REFCOUNT,        // Nodes are freed as soon as their last reference goes away
+} Gc_Mode;
+
+typedef enum {
+    GC_PHASE_IDLE,
+    GC_PHASE_CLEAR,          // Whitening the old space
+    GC_PHASE_MARK,           // Draining the gray stack
+    GC_PHASE_SWEEP,          // Freeing white old nodes
+} Gc_Phase;
+
 typedef struct {
+    // Node heap. Lives in a reserved address range (see gc_arena_grow()), so it
+    // grows without copying and `items` never moves. Not a da: use alloc_expr().
     struct {
         Expr *items;
         size_t count;
-        size_t capacity;
+        size_t capacity;         // Committed nodes
+        size_t reserved;         // Nodes that fit in the reservation
     } slots;
 
     struct {
@@ -243,28 +439,177 @@ typedef struct {
         size_t capacity;
     } dead;
 
+    // Nursery: every node allocated since the last collection, plus the
+    // survivors that are not old enough for promotion yet.
     struct {
         Expr_Index *items;
         size_t count;
         size_t capacity;
-    } gens[2];
+    } young;
 
-    size_t gen_cur;
+    // Old space: nodes that survived GC_PROMOTE_AGE collections.
+    // Only traced and swept by major collections.
+    struct {
+        Expr_Index *items;
+        size_t count;
+        size_t capacity;
+    } old;
+
+    // Roots written since the last collection (see gc_remember()).
+    // Expressions are immutable and children are always older than their
+    // parents, so old nodes never point into the nursery and these plus the
+    // explicit roots are all a minor collection has to trace.
+    struct {
+        Expr_Index *items;
+        size_t count;
+        size_t capacity;
+    } remembered;
+
+    bool major;                  // Current collection traces the whole heap
+    size_t old_after_major;      // Old space size after the last major collection
+    size_t minor_collections;
+    size_t major_collections;
+
+    // Telemetry and triggering (see gc_should_collect())
+    size_t allocated;            // Nodes allocated since the last collection
+    size_t promoted;             // Nodes moved out of the nursery, in total
+    size_t live_after_gc;        // Live nodes right after the last collection
+    size_t peak_slots;           // High-water mark of slots.count
+    size_t heap_budget;          // Bytes of live nodes to stay under, 0 = unlimited
+
+    // Incremental tri-color marking (GC_MODE_INCREMENTAL).
+    // White: old node with !visited. Gray: visited and still on the gray stack.
+    // Black: visited and scanned. The constructors and gc_remember() shade the
+    // nodes they start pointing at while marking, so a black node never points
+    // to a white one.
+    Gc_Mode mode;
+    Gc_Phase phase;
+    struct {
+        Expr_Index *items;
+        size_t count;
+        size_t capacity;
+    } gray;
+    size_t *remap;               // Old index -> new index while gc_compact() runs
+    size_t cursor;               // Next old space index for CLEAR and SWEEP
+    size_t swept;                // Old space entries kept so far by SWEEP
+
+    // Reference counting (GC_MODE_REFCOUNT). The nursery doubles as the zero
+    // count table: a node starts with rc == 0 and is only freed if it is still
+    // unreferenced at the next gc(), so temporaries cost nothing until then.
+    // Dropped app roots (see gc_forget()) are decremented there as well.
+    struct {
+        Expr_Index *items;
+        size_t count;
+        size_t capacity;
+    } released;
+    // Explicit roots of the gc() in progress, held until gc_sweep()
+    struct {
+        Expr_Index *items;
+        size_t count;
+        size_t capacity;
+    } pinned;
 } GC_Context;
 
-extern GC_Context GC;
+// Major collection runs once the old space has grown by this factor since the
+// previous one (and holds at least GC_MAJOR_MIN_OLD nodes).
+#define GC_MAJOR_GROWTH 2
+#define GC_MAJOR_MIN_OLD 65536
+// Minor collections a node has to survive before it moves to old space. Most
+// of what survives one collection is a reduction in flight that dies soon
+// after, and only a major collection could reclaim it from old space.
+#define GC_PROMOTE_AGE 2
+
+// Address space reserved up front for the node heap (shrunk if the OS refuses) and
+// the granularity in which it is committed.
+#define GC_ARENA_RESERVE_BYTES ((size_t)64 << 30)
+#define GC_ARENA_COMMIT_BYTES ((size_t)4 << 20)
+
+
+// A collection is due once the nursery has allocated as many bytes as survived
+// the previous one (the heap may double), but not before GC_TRIGGER_MIN_BYTES,
+// and sooner when that would overshoot the heap budget.
+#define GC_TRIGGER_MIN_BYTES ((size_t)4 << 20)
+// Compaction is worth it once the arena is this big and at least half free
+#define GC_COMPACT_MIN_BYTES ((size_t)4 << 20)
+
+typedef struct {
+    size_t slots;                // Slots handed out, live or on the free list
+    size_t dead;                 // Slots on the free list
+    size_t live;                 // Live nodes right now
+    size_t live_after_gc;        // Live nodes right after the last collection
+    size_t peak_slots;           // High-water mark of slots
+    size_t bytes_allocated;      // Since the last collection
+    size_t bytes_promoted;       // Moved out of the nursery since startup
+    size_t bytes_committed;      // Arena memory currently committed
+    size_t heap_budget;          // 0 = unlimited
+    size_t minor_collections;
+    size_t major_collections;
+} Gc_Stats;
+
+// ============================================================================
+// LAMB CONTEXT
+// ============================================================================
+
+// xoshiro256** state. A zeroed stream behaves as if seeded with 0.
+typedef struct {
+    uint64_t s[4];
+} Lamb_Rng;
+
+// Visits one app root. Gets a pointer so gc_compact() can rewrite it in place.
+typedef void (*Gc_Visit)(Lamb_Context *ctx, Expr_Index *root);
+
+// Everything the interpreter keeps between calls. Contexts share nothing, so
+// independent simulations can run side by side, one per thread. A zeroed
+// context is ready to use; release it with lamb_context_free().
+struct Lamb_Context {
+    GC_Context gc;
+
+    // Interned labels. Symbols compare labels by address, so expressions
+    // (and Symbols) never travel between contexts as is.
+    struct {
+        const char **items;
+        size_t count;
+        size_t capacity;
+    } labels;
+    size_t fresh_counter;        // Last tag handed out by symbol_fresh()
+    Lamb_Rng rng;                // Stream of generate_rich_combinator() and the simulators
+
+    // expr_copy(): renamed tags of the source term and their new values, in pairs
+    struct {
+        size_t *items;
+        size_t count;
+        size_t capacity;
+    } copy_tags;
+
+    // Scratch space of the printing helpers
+    String_Builder trace_sb;     // trace_expr()
+    struct {
+        bool *items;
+        size_t count;
+        size_t capacity;
+    } ast_stack;                 // dump_expr_ast()
+
+    // App roots (grid cells, gas pool) for the collector
+    void (*roots)(Lamb_Context *ctx, Gc_Visit visit);
+    void *roots_data;            // Owner of those roots, for the callback
+};
+
+// Scratch contexts (parallel workers) hand out fresh tags from here up and
+// pass it to expr_copy() when moving terms back, so their tags never clash
+// with the ones of the context they work for.
+#define SCRATCH_FRESH_TAGS (SIZE_MAX / 2)
 
 // ============================================================================
 // MACROS FOR EXPR ACCESS
 // ============================================================================
 
-#define expr_slot(index) (                            \
-    GC.slots.items[                                   \
-        (assert((index).unwrap < GC.slots.count),     \
-         assert(GC.slots.items[(index).unwrap].live), \
+#define expr_slot(ctx, index) (                             \
+    (ctx)->gc.slots.items[                                  \
+        (assert((index).unwrap < (ctx)->gc.slots.count),    \
+         assert((ctx)->gc.slots.items[(index).unwrap].live), \
          (index).unwrap)])
 
-#define expr_slot_unsafe(index) GC.slots.items[(index).unwrap]
+#define expr_slot_unsafe(ctx, index) (ctx)->gc.slots.items[(index).unwrap]
 
 // ============================================================================
 // GLOBAL VARIABLE DECLARATIONS
@@ -281,48 +626,55 @@ char *copy_string(const char *s);
 char *copy_string_sized(const char *s, size_t n);
 int sb_appendf(String_Builder *sb, const char *fmt, ...) PRINTF_FORMAT(2, 3);
 int file_exists(const char *file_path);
+uint64_t time_now_us(void);
 bool read_entire_file(const char *path, String_Builder *sb);
 bool write_entire_file(const char *path, const void *data, size_t size);
+void bytes_put_varint(Bytes *b, uint64_t value);   // LEB128
+bool bytes_get_varint(const uint8_t **p, const uint8_t *end, uint64_t *value);
 
 // ============================================================================
 // FUNCTION PROTOTYPES - Symbols
 // ============================================================================
 
-const char *intern_label(const char *label);
-Symbol symbol(const char *label);
+const char *intern_label(Lamb_Context *ctx, const char *label);
+Symbol symbol(Lamb_Context *ctx, const char *label);
 bool symbol_eq(Symbol a, Symbol b);
-Symbol symbol_fresh(Symbol s);
+Symbol symbol_fresh(Lamb_Context *ctx, Symbol s);
 
 // ============================================================================
 // FUNCTION PROTOTYPES - Expression Management
 // ============================================================================
 
-Expr_Index alloc_expr(void);
-void free_expr(Expr_Index expr);
-Expr_Index var(Symbol name);
-Expr_Index magic(const char *label);
-Expr_Index fun(Symbol param, Expr_Index body);
-Expr_Index app(Expr_Index lhs, Expr_Index rhs);
+Expr_Index alloc_expr(Lamb_Context *ctx);
+void free_expr(Lamb_Context *ctx, Expr_Index expr);
+Expr_Index var(Lamb_Context *ctx, Symbol name);
+Expr_Index magic(Lamb_Context *ctx, const char *label);
+Expr_Index fun(Lamb_Context *ctx, Symbol param, Expr_Index body);
+Expr_Index app(Lamb_Context *ctx, Expr_Index lhs, Expr_Index rhs);
+Expr_Index expr_copy(Lamb_Context *dst, Lamb_Context *src, Expr_Index expr, size_t fresh_from);  // Rebuild a term of src in dst
+void expr_encode(Lamb_Context *ctx, Expr_Index expr, Bytes *out);  // Compact binary form, tags included
+bool expr_decode(Lamb_Context *ctx, const uint8_t **p, const uint8_t *end, Expr_Index *expr);
 
 // ============================================================================
 // FUNCTION PROTOTYPES - Expression Display
 // ============================================================================
 
-void expr_display(Expr_Index expr, String_Builder *sb);
-void expr_display_no_tags(Expr_Index expr, String_Builder *sb);
-void dump_expr_ast(Expr_Index expr);
-void trace_expr(Expr_Index expr);
-char *expr_to_string(Expr_Index expr);
-size_t expr_mass(Expr_Index expr);
+void expr_display(Lamb_Context *ctx, Expr_Index expr, String_Builder *sb);
+void expr_display_no_tags(Lamb_Context *ctx, Expr_Index expr, String_Builder *sb);
+void dump_expr_ast(Lamb_Context *ctx, Expr_Index expr);
+void trace_expr(Lamb_Context *ctx, Expr_Index expr);
+char *expr_to_string(Lamb_Context *ctx, Expr_Index expr);
+size_t expr_mass(Lamb_Context *ctx, Expr_Index expr);
+uint64_t expr_hash(Lamb_Context *ctx, Expr_Index expr);  // Alpha-invariant structural hash, never 0
 
 // ============================================================================
 // FUNCTION PROTOTYPES - Evaluation
 // ============================================================================
 
-bool is_var_free_there(Symbol name, Expr_Index there);
-Expr_Index replace(Symbol param, Expr_Index body, Expr_Index arg);
-bool eval1(Expr_Index expr, Expr_Index *expr1);
-Eval_Result eval_bounded(Expr_Index start, Expr_Index *out, size_t limit, size_t max_mass);
+bool is_var_free_there(Lamb_Context *ctx, Symbol name, Expr_Index there);
+Expr_Index replace(Lamb_Context *ctx, Symbol param, Expr_Index body, Expr_Index arg);
+bool eval1(Lamb_Context *ctx, Expr_Index expr, Expr_Index *expr1);
+Eval_Result eval_bounded(Lamb_Context *ctx, Expr_Index start, Expr_Index *out, size_t limit, size_t max_mass);
 
 // ============================================================================
 // FUNCTION PROTOTYPES - Lexer/Parser
@@ -341,9 +693,9 @@ bool lexer_next(Lexer *l);
 bool lexer_peek(Lexer *l);
 void report_unexpected(Lexer *l, Token_Kind expected);
 bool lexer_expect(Lexer *l, Token_Kind expected);
-bool parse_expr(Lexer *l, Expr_Index *expr);
-bool parse_fun(Lexer *l, Expr_Index *expr);
-bool parse_primary(Lexer *l, Expr_Index *expr);
+bool parse_expr(Lamb_Context *ctx, Lexer *l, Expr_Index *expr);
+bool parse_fun(Lamb_Context *ctx, Lexer *l, Expr_Index *expr);
+bool parse_primary(Lamb_Context *ctx, Lexer *l, Expr_Index *expr);
 
 // ============================================================================
 // FUNCTION PROTOTYPES - REPL Helpers
@@ -352,33 +704,96 @@ bool parse_primary(Lexer *l, Expr_Index *expr);
 bool command(Commands *commands, const char *input, const char *name, const char *signature, const char *description);
 void print_available_commands(Commands *commands);
 void create_binding(Bindings *bindings, Symbol name, Expr_Index body);
-bool create_bindings_from_file(const char *file_path, Bindings *bindings);
+bool create_bindings_from_file(Lamb_Context *ctx, const char *file_path, Bindings *bindings);
 void ctrl_c_handler(int signum);
 void replace_active_file_path_from_lexer_if_not_empty(Lexer l, char **active_file_path);
+void gc_command(Lamb_Context *ctx, Lexer *l);
 
 // ============================================================================
 // FUNCTION PROTOTYPES - GC
 // ============================================================================
 
-void gc_mark(Expr_Index root);
-void gc(Expr_Index root, Bindings bindings);
-void gc_compact(Bindings *bindings);  // Compact GC slots to reclaim memory
-size_t gc_slot_count(void);           // Get current slot count for diagnostics
-size_t gc_dead_count(void);           // Get dead slot count for diagnostics
+// Collection protocol behind gc():
+//   gc_begin();                      // picks minor/major, marks remembered roots
+//   gc_mark(root); ...               // explicit roots and bindings
+//   if (ctx->gc.major) gc_visit_roots(ctx, gc_mark_root);  // every app root (pools, grid cells)
+//   gc_sweep();                      // frees garbage, promotes nursery survivors
+// In GC_MODE_REFCOUNT the same calls pin the explicit roots, apply the deferred
+// decrements and free the unreferenced nursery, so gc() is cheap enough to be
+// called at every safe point.
+void lamb_context_free(Lamb_Context *ctx);
+void gc_begin(Lamb_Context *ctx);
+void gc_mark(Lamb_Context *ctx, Expr_Index root);
+void gc_sweep(Lamb_Context *ctx);
+void gc_remember(Lamb_Context *ctx, Expr_Index expr);    // Call whenever an app root starts pointing at expr
+void gc_forget(Lamb_Context *ctx, Expr_Index expr);      // Call whenever an app root stops pointing at expr
+void gc(Lamb_Context *ctx, Expr_Index root, Bindings bindings);
+void gc_mark_root(Lamb_Context *ctx, Expr_Index *root);  // gc_mark() as a Gc_Visit
+void gc_visit_roots(Lamb_Context *ctx, Gc_Visit visit);   // Runs ctx->roots, if any
+void gc_set_mode(Lamb_Context *ctx, Gc_Mode mode);
+const char *gc_mode_name(Gc_Mode mode);
+bool gc_mode_by_name(const char *name, Gc_Mode *mode);
+bool gc_step(Lamb_Context *ctx, Bindings bindings, uint64_t budget_us);  // Advance an incremental cycle, true when idle
+void gc_compact(Lamb_Context *ctx, Bindings *bindings);  // Compact GC slots to reclaim memory
+void gc_arena_trim(Lamb_Context *ctx);             // Return the pages past slots.count to the OS
+size_t gc_slot_count(Lamb_Context *ctx);           // Get current slot count for diagnostics
+size_t gc_dead_count(Lamb_Context *ctx);           // Get dead slot count for diagnostics
+Gc_Stats gc_stats(Lamb_Context *ctx);
+bool gc_should_collect(Lamb_Context *ctx);         // Allocation or budget says gc() is due
+bool gc_should_compact(Lamb_Context *ctx);         // Enough of the arena is free to gc_compact(), never when incremental
+void gc_set_heap_budget(Lamb_Context *ctx, size_t bytes);
+void gc_reset(Lamb_Context *ctx);                  // Drop every node of a scratch heap at once
+
+// ============================================================================
+// FUNCTION PROTOTYPES - Randomness and Threads
+// ============================================================================
+
+void rng_seed(Lamb_Rng *rng, uint64_t seed);
+uint64_t rng_next(Lamb_Rng *rng);
+uint32_t rng_below(Lamb_Rng *rng, uint32_t n);     // Unbiased draw in [0, n), n > 0
+double rng_double(Lamb_Rng *rng);                  // [0, 1)
+void rng_jump(Lamb_Rng *rng);                      // Skip 2^128 draws
+Lamb_Rng rng_split(Lamb_Rng *rng);                 // Stream of its own: the current one, then rng jumps past it
+uint64_t seed_from_time(void);                     // Default seed when none is given
+bool parse_seed(const char *text, uint64_t *seed);
+
+// Fixed set of worker threads. pool_run() hands out the indices [0, count) to
+// the workers (the calling thread is worker 0) and returns once all are done;
+// idle workers steal queued indices from busy ones. Without threads (_WIN32)
+// the pool has one worker and runs everything inline.
+typedef struct Thread_Pool Thread_Pool;
+typedef void (*Pool_Task)(void *data, size_t worker, size_t index);
+
+// Per worker, summed over every pool_run()
+typedef struct {
+    size_t tasks;                // Tasks run
+    size_t steals;               // Successful steals
+    size_t stolen;               // Tasks taken over by those steals
+    uint64_t busy_us;            // Time in tasks
+    uint64_t idle_us;            // Time in pool_run() without a task to run
+} Pool_Stats;
+
+size_t cpu_count(void);
+Thread_Pool *pool_create(size_t workers);          // 0 = one per CPU
+void pool_free(Thread_Pool *pool);
+size_t pool_workers(Thread_Pool *pool);
+void pool_run(Thread_Pool *pool, size_t count, Pool_Task task, void *data);
+Pool_Stats pool_stats(Thread_Pool *pool, size_t worker);
+void pool_print_stats(Thread_Pool *pool);
 
 // ============================================================================
 // FUNCTION PROTOTYPES - Combinator Generation
 // ============================================================================
 
-Expr_Index generate_rich_combinator(int current_depth, int max_depth, const char **env, int env_count);
-Expr_Index generate_ski_combinator(int depth);  // Generate random SKI combinator tree
-bool is_identity(Expr_Index expr);
+Expr_Index generate_rich_combinator(Lamb_Context *ctx, int current_depth, int max_depth, const char **env, int env_count);
+Expr_Index generate_ski_combinator(Lamb_Context *ctx, int depth);  // Generate random SKI combinator tree
+bool is_identity(Lamb_Context *ctx, Expr_Index expr);
 
 // Church boolean detection (for phenotypic behavior)
 // True  = λx.λy.x (selects first argument)
 // False = λx.λy.y (selects second argument)
-bool is_church_true(Expr_Index expr);
-bool is_church_false(Expr_Index expr);
+bool is_church_true(Lamb_Context *ctx, Expr_Index expr);
+bool is_church_false(Lamb_Context *ctx, Expr_Index expr);
 
 // ============================================================================
 // FUNCTION PROTOTYPES - Shared Helpers
@@ -386,19 +801,58 @@ bool is_church_false(Expr_Index expr);
 
 int compare_strings(const void *a, const void *b);
 
+// ============================================================================
+// FUNCTION PROTOTYPES - Turing Gas
+// ============================================================================
+
+void gas_init(Gas *gas, Lamb_Context *ctx);        // Makes the pool the roots of ctx
+void gas_free(Gas *gas);
+void gas_clear(Gas *gas);
+void gas_pool_set(Gas *gas, size_t index, Expr_Index expr);  // index == count appends
+void gas_seed(Gas *gas, size_t count, int depth);
+void gas_set_batch(Gas *gas, size_t size, int threads);  // 0 = one collision at a time
+size_t gas_batch_size(Gas *gas);
+int gas_threads(Gas *gas);
+void gas_set_islands(Gas *gas, size_t count, long interval, double fraction, int threads);  // count < 2 = one pool
+size_t gas_island_count(Gas *gas);
+long gas_run(Gas *gas, Bindings bindings, long iterations, int depth, size_t max_steps, FILE *log, bool progress);
+void gas_census(Gas *gas, Gas_Census *census);
+void gas_census_free(Gas_Census *census);
+void analyze_pool(Gas *gas, const char *stage_name);
+bool save_soup_to_file(Gas *gas, const char *filename, long step_count);
+
 // ============================================================================
 // FUNCTION PROTOTYPES - Grid / Spatial Simulation
 // ============================================================================
 
-void grid_init(Grid *g, int w, int h);
+void grid_init(Grid *g, Lamb_Context *ctx, int w, int h);
 void grid_free(Grid *g);
+int grid_idx(Grid *g, int x, int y);               // Wraps around the torus, allocates the tile of a sparse world
+void grid_xy(Grid *g, int idx, int *x, int *y);
+void grid_set_layout(Grid *g, bool blocked);       // Applies from the next grid_init()
+void grid_set_sparse(Grid *g, bool sparse);        // Applies from the next grid_init(), steps serially
+void grid_set_kinetic(Grid *g, bool kinetic);      // Applies from the next grid_init() of a dense grid, steps serially
 void grid_seed(Grid *g, int count, int depth);
+void grid_seed_colonies(Grid *g, int colonies, int radius, int density, int depth);  // Discs seeded at density%
 int grid_population(Grid *g);
 void grid_step(Grid *g, Bindings bindings, size_t eval_steps, size_t max_mass);
+void grid_set_threads(Grid *g, int threads);       // 1 = serial, 0 = one per CPU
+int grid_threads(Grid *g);
+size_t grid_species_count(Grid *g, uint64_t hash);  // Cells of the species right now, O(1)
+uint64_t grid_dominant(Grid *g);                   // Hash of a species with max_freq cells, 0 = empty grid
 size_t grid_analyze(Grid *g, bool verbose);
+void grid_clusters(Grid *g, Grid_Clusters *clusters);  // O(cells), reuses the scratch of clusters
+void grid_clusters_free(Grid_Clusters *clusters);
 void grid_render(Grid *g, bool clear_screen);
 bool grid_export_log(Grid *g, const char *filename, bool append);
 bool grid_save_soup(Grid *g, const char *filename);
+bool grid_save_checkpoint(Grid *g, const char *path);  // Binary, resumed exactly by grid_load_checkpoint()
+bool grid_load_checkpoint(Grid *g, Lamb_Context *ctx, const char *path);  // Maps the file and rebuilds the grid in ctx, g untouched on failure
+bool grid_record_start(Grid *g, const char *path, uint64_t seed, size_t eval_steps, size_t max_mass);  // Logs the grid as it is, then every grid_step()
+bool grid_replay_start(Grid *g, Lamb_Context *ctx, const char *path, bool fast, Grid_Record_Info *info);  // Rebuilds the logged grid, g untouched on failure
+bool grid_replay_pending(Grid *g);                 // Another logged step is left
+long grid_replay_mismatches(Grid *g);              // Reactions that came out differently than logged
+void grid_record_stop(Grid *g);                    // Also gives a replayed grid its workers back
 
 #endif // LAMB_H
 
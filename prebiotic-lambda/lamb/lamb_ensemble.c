@@ -0,0 +1,462 @@
+// ,---@>
+//  W-W'
+// LAMB ENSEMBLE - Replicas of grid and gas runs from a run matrix, in one process
+// cc -o lamb_ensemble lamb_ensemble.c lamb_grid.c lamb_gas.c lamb_lib.c -DLAMB_LIBRARY_MODE -lm -pthread
+#include "lamb.h"
+
+// ============================================================================
+// RUN MATRIX
+// ============================================================================
+
+// One line of the matrix, every parameter as in the :grid and :gas commands:
+//
+//   <name> grid <w> <h> <density%> <iterations> <depth> <steps> <replicas>
+//   <name> gas  <pool_size> <iterations> <depth> <steps> <replicas>
+//
+// Empty lines and lines starting with // or # are skipped.
+typedef enum {
+    RUN_GRID,
+    RUN_GAS,
+} Run_Kind;
+
+typedef struct {
+    char *name;
+    Run_Kind kind;
+    int width, height, density;  // RUN_GRID
+    long pool_size;              // RUN_GAS
+    long iterations;
+    int depth;
+    long max_steps;
+    int replicas;
+} Run;
+
+typedef struct {
+    Run *items;
+    size_t count;
+    size_t capacity;
+} Runs;
+
+// Result of one replica, filled by the worker that ran it
+typedef struct {
+    Run *run;
+    int replica;
+    uint64_t seed;
+    char log_path[512];
+    char soup_path[512];
+    bool interrupted;
+    double seconds;
+
+    long steps;
+    size_t population;
+    size_t unique;
+    size_t dominant_count;
+    char *dominant;              // Printed form of the most frequent species
+    double entropy;              // RUN_GAS
+
+    // RUN_GRID
+    long reactions_success;
+    long reactions_diverged;
+    long movements;
+    long deaths_age;
+    long cosmic_spawns;
+
+    // RUN_GAS
+    size_t converged;
+    size_t diverged;
+    size_t errors;
+} Replica;
+
+typedef struct {
+    Replica *items;
+    size_t count;
+    size_t capacity;
+} Replicas;
+
+static bool parse_long(const char *s, long min, long *out)
+{
+    if (!s) return false;
+    char *end;
+    long x = strtol(s, &end, 10);
+    if (*end != '\0' || x < min) return false;
+    *out = x;
+    return true;
+}
+
+static bool parse_matrix(const char *path, const char *source, Runs *runs)
+{
+    char *text = copy_string(source);
+    size_t line_no = 0;
+    bool ok = true;
+    for (char *line = text, *next; line && ok; line = next) {
+        next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+        line_no++;
+
+        const char *delims = " \t\r";
+        char *word = strtok(line, delims);
+        if (!word || word[0] == '#' || strncmp(word, "//", 2) == 0) continue;
+
+        Run run = { .name = copy_string(word) };
+        char *kind = strtok(NULL, delims);
+        long args[7] = {0};
+        size_t arity = 0;
+        if (kind && strcmp(kind, "grid") == 0) {
+            run.kind = RUN_GRID;
+            arity = 7;
+        } else if (kind && strcmp(kind, "gas") == 0) {
+            run.kind = RUN_GAS;
+            arity = 5;
+        } else {
+            fprintf(stderr, "%s:%zu: ERROR: expected run kind grid or gas\n", path, line_no);
+            free(run.name);
+            ok = false;
+            break;
+        }
+        for (size_t i = 0; i < arity && ok; ++i) {
+            ok = parse_long(strtok(NULL, delims), 1, &args[i]);
+        }
+        if (!ok || strtok(NULL, delims) != NULL) {
+            fprintf(stderr, "%s:%zu: ERROR: %s takes %zu positive integers\n", path, line_no, kind, arity);
+            free(run.name);
+            ok = false;
+            break;
+        }
+
+        if (run.kind == RUN_GRID) {
+            run.width = (int)args[0];
+            run.height = (int)args[1];
+            run.density = args[2] > 100 ? 100 : (int)args[2];
+            run.iterations = args[3];
+            run.depth = (int)args[4];
+            run.max_steps = args[5];
+            run.replicas = (int)args[6];
+        } else {
+            run.pool_size = args[0];
+            run.iterations = args[1];
+            run.depth = (int)args[2];
+            run.max_steps = args[3];
+            run.replicas = (int)args[4];
+        }
+        da_append(runs, run);
+    }
+    free(text);
+    return ok;
+}
+
+// ============================================================================
+// REPLICAS
+// ============================================================================
+
+// Distinct, well mixed seed for every replica of the ensemble
+static uint64_t replica_seed(uint64_t base, size_t index)
+{
+    uint64_t z = base + (index + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return (z ^ (z >> 31)) | 1;
+}
+
+static void run_grid_replica(Lamb_Context *ctx, Replica *r)
+{
+    Run *run = r->run;
+    Grid g = {0};
+    grid_init(&g, ctx, run->width, run->height);
+    grid_seed(&g, run->width * run->height * run->density / 100, run->depth);
+    grid_export_log(&g, r->log_path, false);
+
+    for (long it = 0; it < run->iterations; ++it) {
+        if (ctrl_c) {
+            r->interrupted = true;
+            break;
+        }
+        grid_step(&g, (Bindings){0}, (size_t)run->max_steps, 2000);
+        if ((it + 1) % 100 == 0) grid_export_log(&g, r->log_path, true);
+        if (grid_population(&g) == 0) break;
+    }
+    grid_save_soup(&g, r->soup_path);
+
+    uint64_t dominant = grid_dominant(&g);
+    r->steps = g.steps;
+    r->population = (size_t)g.population;
+    r->unique = g.histogram.unique;
+    r->dominant_count = g.histogram.max_freq;
+    for (int i = 0; i < g.cell_count && dominant != 0; ++i) {
+        if (g.cells[i].occupied && g.info[i].hash == dominant) {
+            r->dominant = expr_to_string(ctx, cell_atom(&g.cells[i]));
+            break;
+        }
+    }
+    r->reactions_success = g.reactions_success;
+    r->reactions_diverged = g.reactions_diverged;
+    r->movements = g.movements;
+    r->deaths_age = g.deaths_age;
+    r->cosmic_spawns = g.cosmic_spawns;
+
+    grid_free(&g);
+}
+
+static void run_gas_replica(Lamb_Context *ctx, Replica *r)
+{
+    Run *run = r->run;
+    Gas gas = {0};
+    gas_init(&gas, ctx);
+    gas_seed(&gas, (size_t)run->pool_size, run->depth);
+
+    FILE *log = fopen(r->log_path, "w");
+    if (!log) fprintf(stderr, "WARNING: Could not open %s for writing: %s\n", r->log_path, strerror(errno));
+    r->steps = gas_run(&gas, (Bindings){0}, run->iterations, run->depth, (size_t)run->max_steps, log, false);
+    r->interrupted = r->steps < run->iterations;
+    if (log) fclose(log);
+    save_soup_to_file(&gas, r->soup_path, gas.total_steps);
+
+    Gas_Census census;
+    gas_census(&gas, &census);
+    r->population = census.population;
+    r->unique = census.unique;
+    r->dominant_count = census.max_freq;
+    r->entropy = census.entropy;
+    r->dominant = census.dominant;
+    census.dominant = NULL;  // Moved to the replica
+    r->converged = gas.converged;
+    r->diverged = gas.diverged;
+    r->errors = gas.errors;
+
+    gas_census_free(&census);
+    gas_free(&gas);
+}
+
+// Pool task: one whole replica in its own context
+static void replica_task(void *data, size_t worker, size_t index)
+{
+    UNUSED(worker);
+    Replicas *replicas = data;
+    Replica *r = &replicas->items[index];
+    if (ctrl_c) {
+        r->interrupted = true;
+        return;
+    }
+
+    Lamb_Context ctx = {0};
+    rng_seed(&ctx.rng, r->seed);
+    uint64_t start = time_now_us();
+    if (r->run->kind == RUN_GRID) {
+        run_grid_replica(&ctx, r);
+    } else {
+        run_gas_replica(&ctx, r);
+    }
+    r->seconds = (time_now_us() - start) / 1e6;
+    lamb_context_free(&ctx);
+
+    fprintf(stderr, "%s r%d: %ld steps, %zu alive, %zu species, %.1fs%s\n",
+            r->run->name, r->replica, r->steps, r->population, r->unique, r->seconds,
+            r->interrupted ? " (interrupted)" : "");
+}
+
+// ============================================================================
+// SUMMARY
+// ============================================================================
+
+static void json_write_string(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for (; s && *s; ++s) {
+        if (*s == '\\' || *s == '"') fprintf(f, "\\%c", *s);
+        else if (*s == '\n') fprintf(f, "\\n");
+        else fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+// Field names follow the stats the Python runners used to scrape from stdout
+static bool write_summary(const char *path, Replicas *replicas, uint64_t base_seed)
+{
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "ERROR: Could not open %s for writing: %s\n", path, strerror(errno));
+        return false;
+    }
+    fprintf(f, "{\n  \"seed\": %llu,\n  \"runs\": [\n", (unsigned long long)base_seed);
+    for (size_t i = 0; i < replicas->count; ++i) {
+        Replica *r = &replicas->items[i];
+        Run *run = r->run;
+        fprintf(f, "    {\"name\": ");
+        json_write_string(f, run->name);
+        fprintf(f, ", \"kind\": \"%s\", \"replica\": %d, \"seed\": %llu,\n",
+                run->kind == RUN_GRID ? "grid" : "gas", r->replica, (unsigned long long)r->seed);
+        if (run->kind == RUN_GRID) {
+            fprintf(f, "     \"width\": %d, \"height\": %d, \"density\": %d,", run->width, run->height, run->density);
+        } else {
+            fprintf(f, "     \"pool_size\": %ld,", run->pool_size);
+        }
+        fprintf(f, " \"iterations\": %ld, \"depth\": %d, \"max_steps\": %ld,\n", run->iterations, run->depth, run->max_steps);
+        fprintf(f, "     \"log\": ");
+        json_write_string(f, r->log_path);
+        fprintf(f, ", \"soup\": ");
+        json_write_string(f, r->soup_path);
+        fprintf(f, ", \"seconds\": %.3f, \"interrupted\": %s,\n", r->seconds, r->interrupted ? "true" : "false");
+        fprintf(f, "     \"total_steps\": %ld, \"final_population\": %zu, \"final_unique_species\": %zu, ",
+                r->steps, r->population, r->unique);
+        fprintf(f, "\"final_diversity_pct\": %.2f,\n", r->population ? 100.0 * r->unique / r->population : 0.0);
+        if (run->kind == RUN_GRID) {
+            fprintf(f, "     \"reactions_success\": %ld, \"reactions_diverged\": %ld, \"movements\": %ld, "
+                       "\"deaths_age\": %ld, \"cosmic_spawns\": %ld,\n",
+                    r->reactions_success, r->reactions_diverged, r->movements, r->deaths_age, r->cosmic_spawns);
+        } else {
+            fprintf(f, "     \"converged_reactions\": %zu, \"diverged_reactions\": %zu, \"error_reactions\": %zu, "
+                       "\"entropy\": %.4f,\n",
+                    r->converged, r->diverged, r->errors, r->entropy);
+        }
+        fprintf(f, "     \"final_dominant_count\": %zu, \"final_dominant_expr\": ", r->dominant_count);
+        if (r->dominant) json_write_string(f, r->dominant);
+        else fprintf(f, "null");
+        fprintf(f, "}%s\n", i + 1 < replicas->count ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    return true;
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+static void usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [options] <matrix.txt | ->\n", program);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  -j, --jobs <n>    Replicas run at once (default 0 = one per CPU)\n");
+    fprintf(stderr, "  -o, --out <dir>   Output directory (default ensemble_out)\n");
+    fprintf(stderr, "  -s, --seed <n>    Base seed of the replica streams (default: time)\n");
+    fprintf(stderr, "Matrix lines:\n");
+    fprintf(stderr, "  <name> grid <w> <h> <density%%> <iterations> <depth> <steps> <replicas>\n");
+    fprintf(stderr, "  <name> gas  <pool_size> <iterations> <depth> <steps> <replicas>\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *program = argv[0];
+    const char *matrix_path = NULL;
+    const char *out_dir = "ensemble_out";
+    long jobs = 0;
+    uint64_t base_seed = seed_from_time();
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "-j") == 0 || strcmp(arg, "--jobs") == 0) {
+            if (!parse_long(value, 0, &jobs)) {
+                usage(program);
+                return 1;
+            }
+            i++;
+        } else if (strcmp(arg, "-o") == 0 || strcmp(arg, "--out") == 0) {
+            if (!value) {
+                usage(program);
+                return 1;
+            }
+            out_dir = value;
+            i++;
+        } else if (strcmp(arg, "-s") == 0 || strcmp(arg, "--seed") == 0) {
+            if (!value || !parse_seed(value, &base_seed)) {
+                usage(program);
+                return 1;
+            }
+            i++;
+        } else if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            usage(program);
+            return 0;
+        } else if (!matrix_path) {
+            matrix_path = arg;
+        } else {
+            usage(program);
+            return 1;
+        }
+    }
+    if (!matrix_path) {
+        usage(program);
+        return 1;
+    }
+
+#ifndef _WIN32
+    struct sigaction act = {0};
+    act.sa_handler = ctrl_c_handler;
+    sigaction(SIGINT, &act, NULL);
+#endif // _WIN32
+
+    // Read the matrix
+    String_Builder sb = {0};
+    if (strcmp(matrix_path, "-") == 0) {
+        int c;
+        while ((c = fgetc(stdin)) != EOF) da_append(&sb, (char)c);
+    } else if (!read_entire_file(matrix_path, &sb)) {
+        return 1;
+    }
+    sb_append_null(&sb);
+    Runs runs = {0};
+    if (!parse_matrix(matrix_path, sb.items, &runs)) return 1;
+    free(sb.items);
+
+#ifdef _WIN32
+    if (_mkdir(out_dir) != 0 && errno != EEXIST) {
+#else
+    if (mkdir(out_dir, 0755) != 0 && errno != EEXIST) {
+#endif // _WIN32
+        fprintf(stderr, "ERROR: Could not create %s: %s\n", out_dir, strerror(errno));
+        return 1;
+    }
+
+    // One entry per replica, in matrix order
+    Replicas replicas = {0};
+    for (size_t i = 0; i < runs.count; ++i) {
+        for (int k = 0; k < runs.items[i].replicas; ++k) {
+            Replica r = { .run = &runs.items[i], .replica = k };
+            da_append(&replicas, r);
+        }
+    }
+    for (size_t i = 0; i < replicas.count; ++i) {
+        Replica *r = &replicas.items[i];
+        r->seed = replica_seed(base_seed, i);
+        snprintf(r->log_path, sizeof(r->log_path), "%s/%s_r%d.csv", out_dir, r->run->name, r->replica);
+        snprintf(r->soup_path, sizeof(r->soup_path), "%s/%s_r%d.lamb", out_dir, r->run->name, r->replica);
+    }
+
+    Thread_Pool *pool = pool_create((size_t)jobs);
+    fprintf(stderr, "Running %zu replicas of %zu runs on %zu threads (seed %llu)\n",
+            replicas.count, runs.count, pool_workers(pool), (unsigned long long)base_seed);
+    uint64_t start = time_now_us();
+    pool_run(pool, replicas.count, replica_task, &replicas);
+    fprintf(stderr, "Ensemble done in %.1fs\n", (time_now_us() - start) / 1e6);
+    pool_free(pool);
+
+    char summary_path[512];
+    snprintf(summary_path, sizeof(summary_path), "%s/summary.json", out_dir);
+    bool ok = write_summary(summary_path, &replicas, base_seed);
+    if (ok) printf("Summary saved to %s\n", summary_path);
+
+    for (size_t i = 0; i < replicas.count; ++i) free(replicas.items[i].dominant);
+    free(replicas.items);
+    for (size_t i = 0; i < runs.count; ++i) free(runs.items[i].name);
+    free(runs.items);
+    return ok ? 0 : 1;
+}
+
+// Copyright 2025 Alexey Kutepov <reximkut@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
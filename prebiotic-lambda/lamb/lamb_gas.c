@@ -1,55 +1,78 @@
 // ,---@>
 //  W-W'
 // LAMB GAS - Turing Gas / Combinator Soup Simulation
-// cc -o lamb_gas lamb_gas.c lamb_lib.c -lm
+// cc -o lamb_gas lamb_gas.c lamb_lib.c -lm -pthread
 #include "lamb.h"
 
 // ============================================================================
 // TURING GAS / COMBINATOR SOUP
 // ============================================================================
 
-// Gas Pool: A dynamic array of expressions that serves as the "primordial soup"
-static struct {
-    Expr_Index *items;
-    size_t count;
-    size_t capacity;
-} gas_pool = {0};
-
-// Track total simulation steps for soup dump metadata
-static long gas_total_steps = 0;
+#ifndef LAMB_LIBRARY_MODE
+// Gas of the REPL
+static Gas active_gas = {0};
+#endif // LAMB_LIBRARY_MODE
 
 // ============================================================================
-// GC FUNCTION (with gas_pool marking)
+// GC ROOTS
 // ============================================================================
 
-void gc(Expr_Index root, Bindings bindings)
+// Every expression held by the gas pool (ctx->roots of its context)
+static void gas_visit_roots(Lamb_Context *ctx, Gc_Visit visit)
 {
-    for (size_t i = 0; i < GC.gens[GC.gen_cur].count; ++i) {
-        Expr_Index expr = GC.gens[GC.gen_cur].items[i];
-        expr_slot(expr).visited = false;
+    Gas *gas = ctx->roots_data;
+    for (size_t i = 0; i < gas->pool.count; ++i) {
+        visit(ctx, &gas->pool.items[i]);
     }
+}
 
-    gc_mark(root);
-    for (size_t i = 0; i < bindings.count; ++i) {
-        gc_mark(bindings.items[i].body);
-    }
-    
-    // Mark all expressions in the gas pool to prevent GC from sweeping them away
-    for (size_t i = 0; i < gas_pool.count; ++i) {
-        gc_mark(gas_pool.items[i]);
+// Store an expression into the gas pool (index == count appends)
+void gas_pool_set(Gas *gas, size_t index, Expr_Index expr)
+{
+    if (index == gas->pool.count) {
+        da_append(&gas->pool, expr);
+    } else {
+        gc_forget(gas->ctx, gas->pool.items[index]);
+        gas->pool.items[index] = expr;
     }
+    gc_remember(gas->ctx, expr);
+}
 
-    size_t next = 1 - GC.gen_cur;
-    GC.gens[next].count = 0;
-    for (size_t i = 0; i < GC.gens[GC.gen_cur].count; ++i) {
-        Expr_Index expr = GC.gens[GC.gen_cur].items[i];
-        if (expr_slot(expr).visited) {
-            da_append(&GC.gens[next], expr);
-        } else {
-            free_expr(expr);
-        }
+void gas_init(Gas *gas, Lamb_Context *ctx)
+{
+    gas_free(gas);
+    gas->ctx = ctx;
+    ctx->roots = gas_visit_roots;
+    ctx->roots_data = gas;
+}
+
+void gas_clear(Gas *gas)
+{
+    for (size_t i = 0; i < gas->pool.count; ++i) gc_forget(gas->ctx, gas->pool.items[i]);
+    gas->pool.count = 0;
+}
+
+void gas_free(Gas *gas)
+{
+    if (gas->ctx) gas_clear(gas);
+    gas_set_batch(gas, 0, 1);
+    gas_set_islands(gas, 0, 0, 0.0, 1);
+    free(gas->pool.items);
+    memset(gas, 0, sizeof(*gas));
+}
+
+// Fills the pool with count rich combinators, skipping identities (up to 10 tries)
+void gas_seed(Gas *gas, size_t count, int depth)
+{
+    for (size_t i = 0; i < count; ++i) {
+        Expr_Index expr;
+        int attempts = 0;
+        do {
+            expr = generate_rich_combinator(gas->ctx, 0, depth, NULL, 0);
+            attempts++;
+        } while (is_identity(gas->ctx, expr) && attempts < 10);
+        gas_pool_set(gas, gas->pool.count, expr);
     }
-    GC.gen_cur = next;
 }
 
 // ============================================================================
@@ -57,7 +80,7 @@ void gc(Expr_Index root, Bindings bindings)
 // ============================================================================
 
 // Save the gas pool to a .lamb file for later resumption
-bool save_soup_to_file(const char *filename, long step_count) {
+bool save_soup_to_file(Gas *gas, const char *filename, long step_count) {
     FILE *f = fopen(filename, "w");
     if (!f) {
         fprintf(stderr, "ERROR: Could not open file %s for writing: %s\n", filename, strerror(errno));
@@ -66,13 +89,13 @@ bool save_soup_to_file(const char *filename, long step_count) {
 
     fprintf(f, "// LAMB_SOUP_V1\n");
     fprintf(f, "// step=%ld\n", step_count);
-    fprintf(f, "// count=%zu\n\n", gas_pool.count);
+    fprintf(f, "// count=%zu\n\n", gas->pool.count);
 
     String_Builder sb = {0};
 
-    for (size_t i = 0; i < gas_pool.count; ++i) {
+    for (size_t i = 0; i < gas->pool.count; ++i) {
         sb.count = 0; // Reset builder
-        expr_display_no_tags(gas_pool.items[i], &sb);
+        expr_display_no_tags(gas->ctx, gas->pool.items[i], &sb);
         sb_append_null(&sb);
         
         fprintf(f, "soup_%zu = %s;\n", i, sb.items);
@@ -83,7 +106,9 @@ bool save_soup_to_file(const char *filename, long step_count) {
     return true;
 }
 
-// --- Graph Export Helpers ---
+// --- Graph Export Helpers (REPL only) ---
+
+#ifndef LAMB_LIBRARY_MODE
 
 typedef struct {
     char *label;
@@ -118,75 +143,588 @@ void escape_json_string(const char *input, FILE *f) {
     }
 }
 
-void analyze_pool(const char *stage_name) {
-    if (gas_pool.count == 0) return;
+static int compare_species_label(const void *a, const void *b) {
+    return strcmp((*(Species *const *)a)->label, (*(Species *const *)b)->label);
+}
 
-    // 1. Snapshot: Convert all expressions to strings
-    char **snapshots = malloc(gas_pool.count * sizeof(char*));
-    for (size_t i = 0; i < gas_pool.count; ++i) {
-        snapshots[i] = expr_to_string(gas_pool.items[i]);
-    }
+// Reaction matrix: matrix[i*count + j] is the id of the species that i
+// applied to j reduces to, -1 if it diverges or reduces to something else.
+// Each row is one task, every cell of it reacted in a freshly reset scratch
+// heap of the worker, so a row never holds more than one reduction.
+static struct {
+    Lamb_Context *ctx;
+    Species *species;
+    Species **by_label;          // species sorted by label, for the lookups
+    size_t count;
+    int *matrix;
+    Lamb_Context *heaps;
+    size_t first_row;            // First row of the current round
+} gas_matrix = {0};
 
-    // 2. Sort to group identical species
-    qsort(snapshots, gas_pool.count, sizeof(char*), compare_strings);
+static void gas_matrix_row(void *data, size_t worker, size_t index)
+{
+    UNUSED(data);
+    Lamb_Context *heap = &gas_matrix.heaps[worker];
+    size_t i = gas_matrix.first_row + index;
+    size_t n = gas_matrix.count;
+
+    for (size_t j = 0; j < n; ++j) {
+        gc_reset(heap);
+        Expr_Index A = expr_copy(heap, gas_matrix.ctx, gas_matrix.species[i].expr, SIZE_MAX);
+        Expr_Index B = expr_copy(heap, gas_matrix.ctx, gas_matrix.species[j].expr, SIZE_MAX);
+        Expr_Index result;
+        int result_id = -1;  // -1 implies "Waste" or "External"
+        if (eval_bounded(heap, app(heap, A, B), &result, 1000, 5000) == EVAL_DONE) {
+            Species key = { .label = expr_to_string(heap, result) };
+            Species *keyp = &key;
+            Species **found = bsearch(&keyp, gas_matrix.by_label, n, sizeof(*found), compare_species_label);
+            if (found) result_id = (*found)->id;
+            free(key.label);
+        }
+        gas_matrix.matrix[i*n + j] = result_id;
+    }
+}
 
-    // 3. Count unique species
-    size_t unique_count = 0;
-    size_t max_freq = 0;
-    char *most_common = NULL;
+// Fills the reaction matrix of species[0..count), the ids already assigned.
+// Progress goes to stderr. Returns false if interrupted by Ctrl-C.
+static bool gas_matrix_compute(Lamb_Context *ctx, Species *species, size_t count, int *matrix, int threads)
+{
+    Thread_Pool *pool = pool_create(threads > 0 ? (size_t)threads : 0);
+    size_t workers = pool_workers(pool);
+
+    gas_matrix.ctx = ctx;
+    gas_matrix.species = species;
+    gas_matrix.count = count;
+    gas_matrix.matrix = matrix;
+    gas_matrix.by_label = malloc(count * sizeof(*gas_matrix.by_label));
+    gas_matrix.heaps = calloc(workers, sizeof(*gas_matrix.heaps));
+    assert(gas_matrix.by_label != NULL && gas_matrix.heaps != NULL && "Buy more RAM lol");
+    for (size_t i = 0; i < count; ++i) gas_matrix.by_label[i] = &species[i];
+    qsort(gas_matrix.by_label, count, sizeof(*gas_matrix.by_label), compare_species_label);
+    for (size_t i = 0; i < workers; ++i) gas_matrix.heaps[i].fresh_counter = SCRATCH_FRESH_TAGS;
+
+    // Rows go out in rounds so the progress can be reported in between
+    size_t round = workers * 4;
+    uint64_t start = time_now_us();
+    bool ok = true;
+    ctrl_c = 0;
+    for (size_t row = 0; row < count; row += round) {
+        if (ctrl_c) {
+            fprintf(stderr, "\nReaction matrix interrupted by user.\n");
+            ok = false;
+            break;
+        }
+        size_t rows = count - row < round ? count - row : round;
+        gas_matrix.first_row = row;
+        pool_run(pool, rows, gas_matrix_row, NULL);
+
+        size_t done = row + rows;
+        double elapsed = (time_now_us() - start) / 1e6;
+        double eta = elapsed / done * (count - done);
+        fprintf(stderr, "\rReactions: %zu/%zu rows (%.1f%%), %.0fs elapsed, ETA %.0fs   ",
+                done, count, 100.0 * done / count, elapsed, eta);
+    }
+    fprintf(stderr, "\n");
+
+    for (size_t i = 0; i < workers; ++i) lamb_context_free(&gas_matrix.heaps[i]);
+    free(gas_matrix.heaps);
+    free(gas_matrix.by_label);
+    memset(&gas_matrix, 0, sizeof(gas_matrix));
+    pool_free(pool);
+    return ok;
+}
+#endif // LAMB_LIBRARY_MODE
 
-    if (gas_pool.count > 0) {
-        unique_count = 1;
-        size_t current_freq = 1;
-        
-        for (size_t i = 1; i < gas_pool.count; ++i) {
-            if (strcmp(snapshots[i], snapshots[i-1]) != 0) {
-                // New species found
-                unique_count++;
-                
-                // Check if previous was the most common
-                if (current_freq > max_freq) {
-                    max_freq = current_freq;
-                    most_common = snapshots[i-1];
-                }
-                current_freq = 1;
-            } else {
-                current_freq++;
-            }
+// Census of n printed species, sorted in place. Takes ownership of the strings.
+static void census_from_snapshots(Gas_Census *census, char **snapshots, size_t n)
+{
+    memset(census, 0, sizeof(*census));
+    census->population = n;
+    if (n == 0) return;
+
+    qsort(snapshots, n, sizeof(char*), compare_strings);
+
+    // Count the runs
+    size_t dominant = 0;
+    size_t run = 1;
+    for (size_t i = 1; i <= n; ++i) {
+        if (i < n && strcmp(snapshots[i], snapshots[i-1]) == 0) {
+            run++;
+            continue;
         }
-        // Check the last run
-        if (current_freq > max_freq) {
-            max_freq = current_freq;
-            most_common = snapshots[gas_pool.count-1];
+        double p = (double)run / n;
+        census->entropy -= p * log(p);
+        census->unique++;
+        if (run > census->max_freq) {
+            census->max_freq = run;
+            dominant = i - 1;
         }
+        run = 1;
     }
 
-    // 4. Report
-    printf("--- %s ---\n", stage_name);
-    printf("Population:   %zu\n", gas_pool.count);
-    printf("Unique Spec:  %zu (%.2f%% diversity)\n", unique_count, ((float)unique_count / gas_pool.count) * 100.0f);
-    if (most_common) {
-        printf("Dominant:     %s (Count: %zu, %.2f%%)\n", most_common, max_freq, ((float)max_freq / gas_pool.count) * 100.0f);
+    census->dominant = snapshots[dominant];
+    for (size_t i = 0; i < n; ++i) {
+        if (i != dominant) free(snapshots[i]);
+    }
+}
+
+// Species of the pool by printed form. dominant is NULL for an empty pool,
+// otherwise owned by the census (gas_census_free()).
+void gas_census(Gas *gas, Gas_Census *census)
+{
+    size_t n = gas->pool.count;
+    char **snapshots = malloc((n > 0 ? n : 1) * sizeof(char*));
+    assert(snapshots != NULL && "Buy more RAM lol");
+    for (size_t i = 0; i < n; ++i) {
+        snapshots[i] = expr_to_string(gas->ctx, gas->pool.items[i]);
     }
+    census_from_snapshots(census, snapshots, n);
+    free(snapshots);
+}
+
+void gas_census_free(Gas_Census *census)
+{
+    free(census->dominant);
+    memset(census, 0, sizeof(*census));
+}
+
+void analyze_pool(Gas *gas, const char *stage_name) {
+    if (gas->pool.count == 0) return;
+
+    Gas_Census census;
+    gas_census(gas, &census);
+
+    printf("--- %s ---\n", stage_name);
+    printf("Population:   %zu\n", census.population);
+    printf("Unique Spec:  %zu (%.2f%% diversity)\n", census.unique, ((float)census.unique / census.population) * 100.0f);
+    printf("Dominant:     %s (Count: %zu, %.2f%%)\n", census.dominant, census.max_freq, ((float)census.max_freq / census.population) * 100.0f);
     printf("----------------------------------\n");
 
-    // 5. Cleanup
-    for (size_t i = 0; i < gas_pool.count; ++i) {
-        free(snapshots[i]);
+    gas_census_free(&census);
+}
+
+// ============================================================================
+// COLLISIONS
+// ============================================================================
+
+// One collision: A = pool[idx_a] is applied to B = pool[idx_b]. A normal form
+// overwrites a random slot, a diverging A is replaced, an error replaces both.
+static Eval_Result gas_collide(Gas *gas, size_t max_steps, int depth)
+{
+    Lamb_Context *ctx = gas->ctx;
+    size_t idx_a = rng_below(&ctx->rng, (uint32_t)gas->pool.count);
+    size_t idx_b = rng_below(&ctx->rng, (uint32_t)gas->pool.count);
+
+    Expr_Index result;
+    Eval_Result res = eval_bounded(ctx, app(ctx, gas->pool.items[idx_a], gas->pool.items[idx_b]), &result, max_steps, 5000);
+
+    if (res == EVAL_DONE) {
+        size_t target_idx = rng_below(&ctx->rng, (uint32_t)gas->pool.count);
+        gas_pool_set(gas, target_idx, result);
+    } else if (res == EVAL_LIMIT) {
+        gas_pool_set(gas, idx_a, generate_rich_combinator(ctx, 0, depth, NULL, 0));
+    } else {
+        gas_pool_set(gas, idx_a, generate_rich_combinator(ctx, 0, depth, NULL, 0));
+        gas_pool_set(gas, idx_b, generate_rich_combinator(ctx, 0, depth, NULL, 0));
+    }
+    return res;
+}
+
+// Batched mode: K collisions are drawn up front, reacted in parallel against
+// the pool as it was when the batch was drawn, and applied in draw order.
+// Everything random about a collision comes from the draw, so the pool ends
+// up the same whatever the thread count.
+typedef struct {
+    size_t idx_a, idx_b;
+    size_t target;           // Slot taken by a normal form
+    uint64_t seed;           // Stream for the replacement combinators
+    Eval_Result res;
+    size_t worker;           // Scratch heap holding the terms below
+    Expr_Index result;       // Normal form, or the replacement for A
+    Expr_Index fresh_b;      // Replacement for B after an error
+} Gas_Collision;
+
+struct Gas_Batch {
+    Gas *gas;
+    size_t size;             // Collisions per batch
+    Thread_Pool *pool;
+    Lamb_Context *heaps;     // One scratch heap per worker
+    size_t heap_count;
+
+    // Batch being applied
+    struct {
+        Gas_Collision *items;
+        size_t count;
+        size_t capacity;
+    } collisions;
+    size_t next;
+    size_t max_steps;
+    int depth;
+};
+
+void gas_set_batch(Gas *gas, size_t size, int threads)
+{
+    Gas_Batch *batch = gas->batch;
+    if (batch) {
+        pool_free(batch->pool);
+        for (size_t i = 0; i < batch->heap_count; ++i) lamb_context_free(&batch->heaps[i]);
+        free(batch->heaps);
+        free(batch->collisions.items);
+        free(batch);
+        gas->batch = NULL;
+    }
+    if (size == 0) return;
+
+    batch = calloc(1, sizeof(*batch));
+    assert(batch != NULL && "Buy more RAM lol");
+    batch->gas = gas;
+    batch->size = size;
+    batch->pool = pool_create(threads > 0 ? (size_t)threads : 0);
+    batch->heap_count = pool_workers(batch->pool);
+    batch->heaps = calloc(batch->heap_count, sizeof(*batch->heaps));
+    assert(batch->heaps != NULL && "Buy more RAM lol");
+    for (size_t i = 0; i < batch->heap_count; ++i) {
+        batch->heaps[i].fresh_counter = SCRATCH_FRESH_TAGS;
+    }
+    gas->batch = batch;
+}
+
+size_t gas_batch_size(Gas *gas)
+{
+    return gas->batch ? gas->batch->size : 0;
+}
+
+int gas_threads(Gas *gas)
+{
+    return gas->batch ? (int)gas->batch->heap_count : 1;
+}
+
+static void gas_batch_task(void *data, size_t worker, size_t index)
+{
+    Gas_Batch *batch = data;
+    Lamb_Context *heap = &batch->heaps[worker];
+    Gas_Collision *c = &batch->collisions.items[index];
+    Gas *gas = batch->gas;
+
+    Expr_Index A = expr_copy(heap, gas->ctx, gas->pool.items[c->idx_a], SIZE_MAX);
+    Expr_Index B = expr_copy(heap, gas->ctx, gas->pool.items[c->idx_b], SIZE_MAX);
+    c->worker = worker;
+    c->res = eval_bounded(heap, app(heap, A, B), &c->result, batch->max_steps, 5000);
+    if (c->res == EVAL_DONE) return;
+
+    rng_seed(&heap->rng, c->seed);
+    c->result = generate_rich_combinator(heap, 0, batch->depth, NULL, 0);
+    if (c->res == EVAL_ERROR) c->fresh_b = generate_rich_combinator(heap, 0, batch->depth, NULL, 0);
+}
+
+// Next collision of the current batch, drawing and reacting a new batch of at
+// most `remaining` collisions when it is used up
+static Eval_Result gas_batch_next(Gas *gas, long remaining, size_t max_steps, int depth)
+{
+    Gas_Batch *batch = gas->batch;
+    Lamb_Context *ctx = gas->ctx;
+    if (batch->next == batch->collisions.count) {
+        for (size_t i = 0; i < batch->heap_count; ++i) gc_reset(&batch->heaps[i]);
+
+        size_t count = (long)batch->size < remaining ? batch->size : (size_t)remaining;
+        batch->collisions.count = 0;
+        for (size_t i = 0; i < count; ++i) {
+            Gas_Collision c = {0};
+            c.idx_a = rng_below(&ctx->rng, (uint32_t)gas->pool.count);
+            c.idx_b = rng_below(&ctx->rng, (uint32_t)gas->pool.count);
+            c.target = rng_below(&ctx->rng, (uint32_t)gas->pool.count);
+            c.seed = rng_next(&ctx->rng);
+            da_append(&batch->collisions, c);
+        }
+        batch->next = 0;
+        batch->max_steps = max_steps;
+        batch->depth = depth;
+        pool_run(batch->pool, count, gas_batch_task, batch);
+    }
+
+    Gas_Collision *c = &batch->collisions.items[batch->next++];
+    Lamb_Context *heap = &batch->heaps[c->worker];
+    Expr_Index result = expr_copy(ctx, heap, c->result, SCRATCH_FRESH_TAGS);
+    if (c->res == EVAL_DONE) {
+        gas_pool_set(gas, c->target, result);
+    } else {
+        gas_pool_set(gas, c->idx_a, result);
+        if (c->res == EVAL_ERROR) gas_pool_set(gas, c->idx_b, expr_copy(ctx, heap, c->fresh_b, SCRATCH_FRESH_TAGS));
+    }
+    return c->res;
+}
+
+// ============================================================================
+// ISLANDS
+// ============================================================================
+
+// Island model: for the length of a gas_run() the pool is dealt round-robin
+// onto N islands, each with a private heap and RNG, that collide on their own
+// in parallel. Every `interval` collisions per island a `fraction` of each
+// island is copied to the next one around the ring, overwriting random slots.
+// At the end every molecule goes back to the slot it was dealt from. Each
+// island only draws from its own stream, so results don't depend on the
+// thread count.
+typedef struct {
+    Lamb_Context ctx;
+    Gas gas;
+    long quota;              // Collisions to run this epoch
+    long done;
+    struct {
+        Expr_Index *items;   // Arrivals, already in ctx
+        size_t count;
+        size_t capacity;
+    } migrants;
+} Gas_Island;
+
+struct Gas_Islands {
+    size_t count;
+    long interval;           // Collisions per island between migrations
+    double fraction;         // Share of an island sent on each migration
+    Thread_Pool *pool;
+    Gas_Island *items;
+
+    // Run in progress
+    size_t active;           // Islands in use (no more than molecules)
+    size_t max_steps;
+    int depth;
+};
+
+void gas_set_islands(Gas *gas, size_t count, long interval, double fraction, int threads)
+{
+    Gas_Islands *islands = gas->islands;
+    if (islands) {
+        pool_free(islands->pool);
+        for (size_t i = 0; i < islands->count; ++i) free(islands->items[i].migrants.items);
+        free(islands->items);
+        free(islands);
+        gas->islands = NULL;
+    }
+    if (count < 2) return;
+
+    islands = calloc(1, sizeof(*islands));
+    assert(islands != NULL && "Buy more RAM lol");
+    islands->count = count;
+    islands->interval = interval > 0 ? interval : 1;
+    islands->fraction = fraction < 0.0 ? 0.0 : fraction > 1.0 ? 1.0 : fraction;
+    islands->pool = pool_create(threads > 0 ? (size_t)threads : 0);
+    islands->items = calloc(count, sizeof(*islands->items));
+    assert(islands->items != NULL && "Buy more RAM lol");
+    gas->islands = islands;
+}
+
+size_t gas_island_count(Gas *gas)
+{
+    return gas->islands ? gas->islands->count : 1;
+}
+
+static void gas_island_task(void *data, size_t worker, size_t index)
+{
+    UNUSED(worker);
+    Gas_Islands *islands = data;
+    Gas_Island *island = &islands->items[index];
+    Gas *gas = &island->gas;
+    Bindings none = {0};
+
+    island->done = 0;
+    while (island->done < island->quota && !ctrl_c) {
+        Eval_Result res = gas_collide(gas, islands->max_steps, islands->depth);
+        if (res == EVAL_DONE) gas->converged++;
+        else if (res == EVAL_LIMIT) gas->diverged++;
+        else gas->errors++;
+        island->done++;
+
+        if (gc_should_collect(gas->ctx)) {
+            gc(gas->ctx, var(gas->ctx, symbol(gas->ctx, "_dummy")), none);
+        }
+    }
+}
+
+// Every migrant is copied out before any slot is overwritten, so the order
+// the islands are visited in doesn't matter
+static void gas_islands_migrate(Gas_Islands *islands)
+{
+    size_t n = islands->active;
+    for (size_t i = 0; i < n; ++i) {
+        Gas *src = &islands->items[i].gas;
+        Gas_Island *dst = &islands->items[(i + 1) % n];
+        size_t count = (size_t)(islands->fraction * src->pool.count + 0.5);
+        if (count == 0 && islands->fraction > 0.0) count = 1;
+        if (count > dst->gas.pool.count) count = dst->gas.pool.count;
+        for (size_t j = 0; j < count; ++j) {
+            Expr_Index expr = src->pool.items[rng_below(&src->ctx->rng, (uint32_t)src->pool.count)];
+            da_append(&dst->migrants, expr_copy(&dst->ctx, src->ctx, expr, SCRATCH_FRESH_TAGS));
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        Gas_Island *island = &islands->items[i];
+        for (size_t j = 0; j < island->migrants.count; ++j) {
+            size_t slot = rng_below(&island->ctx.rng, (uint32_t)island->gas.pool.count);
+            gas_pool_set(&island->gas, slot, island->migrants.items[j]);
+        }
+        island->migrants.count = 0;
     }
+}
+
+// Same row as gas_log_row() over all islands together
+static void gas_islands_log_row(Gas_Islands *islands, size_t population, long step, FILE *log)
+{
+    char **snapshots = malloc((population > 0 ? population : 1) * sizeof(char*));
+    assert(snapshots != NULL && "Buy more RAM lol");
+    size_t n = 0;
+    for (size_t i = 0; i < islands->active; ++i) {
+        Gas *gas = &islands->items[i].gas;
+        for (size_t j = 0; j < gas->pool.count; ++j) {
+            snapshots[n++] = expr_to_string(gas->ctx, gas->pool.items[j]);
+        }
+    }
+
+    Gas_Census census;
+    census_from_snapshots(&census, snapshots, n);
+    fprintf(log, "%ld,%zu,%.4f,%zu\n", step, census.unique, census.entropy, census.max_freq);
+    fflush(log);
+    gas_census_free(&census);
     free(snapshots);
 }
 
+static long gas_islands_run(Gas *gas, Bindings bindings, long iterations, int depth, size_t max_steps, FILE *log, bool progress)
+{
+    Gas_Islands *islands = gas->islands;
+    Lamb_Context *ctx = gas->ctx;
+    size_t n = islands->count < gas->pool.count ? islands->count : gas->pool.count;
+    islands->active = n;
+    islands->max_steps = max_steps;
+    islands->depth = depth;
+
+    // Deal the pool
+    for (size_t i = 0; i < n; ++i) {
+        Gas_Island *island = &islands->items[i];
+        island->ctx.fresh_counter = SCRATCH_FRESH_TAGS;
+        island->ctx.rng = rng_split(&ctx->rng);
+        gas_init(&island->gas, &island->ctx);
+    }
+    for (size_t i = 0; i < gas->pool.count; ++i) {
+        Gas_Island *island = &islands->items[i % n];
+        gas_pool_set(&island->gas, island->gas.pool.count, expr_copy(&island->ctx, ctx, gas->pool.items[i], SIZE_MAX));
+    }
+
+    long it = 0;
+    if (log && n > 0) gas_islands_log_row(islands, gas->pool.count, 0, log);
+    while (n > 0 && it < iterations && !ctrl_c) {
+        long epoch = islands->interval * (long)n;
+        if (epoch > iterations - it) epoch = iterations - it;
+        for (size_t i = 0; i < n; ++i) {
+            islands->items[i].quota = epoch / (long)n + ((long)i < epoch % (long)n);
+        }
+        pool_run(islands->pool, n, gas_island_task, islands);
+
+        long done = 0;
+        for (size_t i = 0; i < n; ++i) done += islands->items[i].done;
+        if (progress) {
+            for (long dot = it / 100; dot < (it + done) / 100; ++dot) printf(".");
+            fflush(stdout);
+        }
+        if (log && (it + done) / 1000 > it / 1000) gas_islands_log_row(islands, gas->pool.count, it + done, log);
+        it += done;
+
+        if (n > 1 && it < iterations && !ctrl_c) gas_islands_migrate(islands);
+    }
+
+    // Gather back into the slots the molecules were dealt from
+    for (size_t i = 0; i < gas->pool.count; ++i) {
+        Gas_Island *island = &islands->items[i % n];
+        gas_pool_set(gas, i, expr_copy(ctx, &island->ctx, island->gas.pool.items[i / n], SCRATCH_FRESH_TAGS));
+    }
+    for (size_t i = 0; i < n; ++i) {
+        Gas_Island *island = &islands->items[i];
+        gas->converged += island->gas.converged;
+        gas->diverged += island->gas.diverged;
+        gas->errors += island->gas.errors;
+        gas_free(&island->gas);
+        lamb_context_free(&island->ctx);
+        memset(&island->ctx, 0, sizeof(island->ctx));
+    }
+    if (gc_should_collect(ctx)) {
+        gc(ctx, var(ctx, symbol(ctx, "_dummy")), bindings);
+    }
+
+    gas->total_steps += it;
+    return it;
+}
+
+// ============================================================================
+// SIMULATION
+// ============================================================================
+
+// Time-series row: step,unique_count,entropy,top_freq
+static void gas_log_row(Gas *gas, long step, FILE *log)
+{
+    Gas_Census census;
+    gas_census(gas, &census);
+    fprintf(log, "%ld,%zu,%.4f,%zu\n", step, census.unique, census.entropy, census.max_freq);
+    fflush(log);
+    gas_census_free(&census);
+}
+
+// Runs up to `iterations` collisions (stops early on Ctrl-C and returns the
+// number run). log gets a CSV row every 1000 collisions, progress a dot
+// every 100 on stdout. bindings stay alive across collections.
+long gas_run(Gas *gas, Bindings bindings, long iterations, int depth, size_t max_steps, FILE *log, bool progress)
+{
+    Lamb_Context *ctx = gas->ctx;
+    if (log) fprintf(log, "step,unique_count,entropy,top_freq\n");
+    if (gas->islands) return gas_islands_run(gas, bindings, iterations, depth, max_steps, log, progress);
+
+    long it = 0;
+    for (; it < iterations; ++it) {
+        if (ctrl_c) break;
+
+        Eval_Result res = gas->batch
+            ? gas_batch_next(gas, iterations - it, max_steps, depth)
+            : gas_collide(gas, max_steps, depth);
+        if (res == EVAL_DONE) gas->converged++;
+        else if (res == EVAL_LIMIT) gas->diverged++;
+        else gas->errors++;
+
+        // Periodic logging every 1000 steps
+        if (log && it % 1000 == 0 && gas->pool.count > 0) gas_log_row(gas, it, log);
+
+        // Progress indicator
+        if (progress && (it + 1) % 100 == 0) {
+            printf(".");
+            fflush(stdout);
+        }
+
+        // Collect once enough was allocated since the last GC
+        if (gc_should_collect(ctx)) {
+            gc(ctx, var(ctx, symbol(ctx, "_dummy")), bindings);
+        }
+    }
+
+    // A batch cut short by Ctrl-C is dropped
+    if (gas->batch) {
+        gas->batch->collisions.count = 0;
+        gas->batch->next = 0;
+    }
+    gas->total_steps += it;
+    return it;
+}
+
 // ============================================================================
 // MAIN
 // ============================================================================
 
+#ifndef LAMB_LIBRARY_MODE
 int main(int argc, char **argv)
 {
     static char buffer[1024];
     static Commands commands = {0};
+    static Lamb_Context gas_ctx = {0};
     static Bindings bindings = {0};
     static Lexer l = {0};
+    Lamb_Context *ctx = &gas_ctx;
+    Gas *gas = &active_gas;
+    gas_init(gas, ctx);
 
 #ifndef _WIN32
     struct sigaction act = {0};
@@ -194,23 +732,30 @@ int main(int argc, char **argv)
     sigaction(SIGINT, &act, NULL);
 #endif // _WIN32
 
-    srand((unsigned)time(NULL));
-
     const char *editor  = getenv("LAMB_EDITOR");
     if (!editor) editor = getenv("EDITOR");
     if (!editor) editor = "vi";
 
     char *active_file_path = NULL;
+    uint64_t seed = seed_from_time();
 
-    if (argc == 2) {
-        active_file_path = copy_string(argv[1]);
-    } else if (argc > 2) {
-        fprintf(stderr, "ERROR: only a single active file is support right now\n");
-        return 1;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--seed") == 0) {
+            if (i + 1 >= argc || !parse_seed(argv[++i], &seed)) {
+                fprintf(stderr, "ERROR: --seed expects a number\n");
+                return 1;
+            }
+        } else if (active_file_path) {
+            fprintf(stderr, "ERROR: only a single active file is support right now\n");
+            return 1;
+        } else {
+            active_file_path = copy_string(argv[i]);
+        }
     }
+    rng_seed(&ctx->rng, seed);
 
     if (active_file_path) {
-        create_bindings_from_file(active_file_path, &bindings);
+        create_bindings_from_file(ctx, active_file_path, &bindings);
     }
 
     printf(",---@>\n");
@@ -243,7 +788,7 @@ again:
                 }
 
                 bindings.count = 0;
-                create_bindings_from_file(active_file_path, &bindings);
+                create_bindings_from_file(ctx, active_file_path, &bindings);
                 goto again;
             }
             if (command(&commands, l.string.items, "save", "[path]", "Save current bindings to a file.")) {
@@ -258,7 +803,7 @@ again:
                 for (size_t i = 0; i < bindings.count; ++i) {
                     assert(bindings.items[i].name.tag == 0);
                     sb_appendf(&sb, "%s = ", bindings.items[i].name.label);
-                    expr_display(bindings.items[i].body, &sb);
+                    expr_display(ctx, bindings.items[i].body, &sb);
                     sb_appendf(&sb, ";\n");
                 }
 
@@ -295,7 +840,7 @@ again:
                 da_append(&cmd, active_file_path);
                 if (cmd_run(&cmd)) {
                     bindings.count = 0;
-                    create_bindings_from_file(active_file_path, &bindings);
+                    create_bindings_from_file(ctx, active_file_path, &bindings);
                 }
 #endif // _WIN32
                 goto again;
@@ -311,7 +856,7 @@ again:
                 args.count = 0;
                 if (!lexer_next(&l)) goto again;
                 while (l.token == TOKEN_NAME) {
-                    da_append(&args, intern_label(l.string.items));
+                    da_append(&args, intern_label(ctx, l.string.items));
                     if (!lexer_next(&l)) goto again;
                 }
                 if (l.token != TOKEN_END) {
@@ -324,7 +869,7 @@ again:
                         assert(bindings.items[i].name.tag == 0);
                         sb.count = 0;
                         sb_appendf(&sb, "%s = ", bindings.items[i].name.label);
-                        expr_display(bindings.items[i].body, &sb);
+                        expr_display(ctx, bindings.items[i].body, &sb);
                         sb_appendf(&sb, ";");
                         sb_append_null(&sb);
                         printf("%s\n", sb.items);
@@ -340,7 +885,7 @@ again:
                         if (bindings.items[i].name.label == label) {
                             sb.count = 0;
                             sb_appendf(&sb, "%s = ", bindings.items[i].name.label);
-                            expr_display(bindings.items[i].body, &sb);
+                            expr_display(ctx, bindings.items[i].body, &sb);
                             sb_appendf(&sb, ";");
                             sb_append_null(&sb);
                             printf("%s\n", sb.items);
@@ -357,7 +902,7 @@ again:
             }
             if (command(&commands, l.string.items, "delete", "<name>", "delete a binding by name")) {
                 if (!lexer_expect(&l, TOKEN_NAME)) goto again;
-                Symbol name = symbol(l.string.items);
+                Symbol name = symbol(ctx, l.string.items);
                 for (size_t i = 0; i < bindings.count; ++i) {
                     if (symbol_eq(bindings.items[i].name, name)) {
                         da_delete_at(&bindings, i);
@@ -390,14 +935,14 @@ again:
                 
                 char *soup_filename = copy_string_sized(path_start, path_len);
                 
-                if (gas_pool.count == 0) {
+                if (gas->pool.count == 0) {
                     fprintf(stderr, "ERROR: Gas pool is empty. Run :gas first.\n");
                     free(soup_filename);
                     goto again;
                 }
                 
-                if (save_soup_to_file(soup_filename, gas_total_steps)) {
-                    printf("Saved %zu soup items to %s\n", gas_pool.count, soup_filename);
+                if (save_soup_to_file(gas, soup_filename, gas->total_steps)) {
+                    printf("Saved %zu soup items to %s\n", gas->pool.count, soup_filename);
                 }
                 
                 free(soup_filename);
@@ -416,29 +961,29 @@ again:
                 }
                 char *json_filename = copy_string_sized(path_start, path_len);
 
-                // 2. Load Soup from bindings (if gas_pool is empty, try to populate from bindings)
-                if (gas_pool.count == 0) {
+                // 2. Load Soup from bindings (if the pool is empty, try to populate from bindings)
+                if (gas->pool.count == 0) {
                     for (size_t i = 0; i < bindings.count; ++i) {
                         if (strncmp(bindings.items[i].name.label, "soup_", 5) == 0) {
-                            da_append(&gas_pool, bindings.items[i].body);
+                            gas_pool_set(gas, gas->pool.count, bindings.items[i].body);
                         }
                     }
                 }
 
-                if (gas_pool.count == 0) {
+                if (gas->pool.count == 0) {
                     fprintf(stderr, "ERROR: No soup found. Load a file with soup_ bindings or run :gas.\n");
                     free(json_filename);
                     goto again;
                 }
 
-                printf("Analyzing %zu expressions...\n", gas_pool.count);
+                printf("Analyzing %zu expressions...\n", gas->pool.count);
 
                 // 3. Identify Unique Species
-                Species *species_list = malloc(gas_pool.count * sizeof(Species));
+                Species *species_list = malloc(gas->pool.count * sizeof(Species));
                 size_t species_count = 0;
 
-                for (size_t i = 0; i < gas_pool.count; ++i) {
-                    char *lbl = expr_to_string(gas_pool.items[i]);
+                for (size_t i = 0; i < gas->pool.count; ++i) {
+                    char *lbl = expr_to_string(ctx, gas->pool.items[i]);
                     int existing = find_species_index(species_list, species_count, lbl);
                     
                     if (existing >= 0) {
@@ -446,7 +991,7 @@ again:
                         free(lbl);
                     } else {
                         species_list[species_count].label = lbl;
-                        species_list[species_count].expr = gas_pool.items[i];
+                        species_list[species_count].expr = gas->pool.items[i];
                         species_list[species_count].count = 1;
                         species_list[species_count].id = (int)species_count;
                         species_count++;
@@ -459,14 +1004,22 @@ again:
                 for(size_t i=0; i<species_count; ++i) species_list[i].id = (int)i;
 
                 printf("Found %zu unique species.\nComputing reaction matrix...\n", species_count);
+                fflush(stdout);
 
                 // 4. Compute Reactions & Export
-                FILE *f = fopen(json_filename, "w");
+                int *matrix = malloc(species_count * species_count * sizeof(int));
+                assert(matrix != NULL && "Buy more RAM lol");
+                int threads = gas->batch ? gas_threads(gas) : 0;
+                FILE *f = NULL;
+                if (gas_matrix_compute(ctx, species_list, species_count, matrix, threads)) {
+                    f = fopen(json_filename, "w");
+                    if (!f) fprintf(stderr, "ERROR: Could not open %s\n", json_filename);
+                }
                 if (!f) {
-                    fprintf(stderr, "ERROR: Could not open %s\n", json_filename);
                     // cleanup
                     for(size_t i=0; i<species_count; ++i) free(species_list[i].label);
                     free(species_list);
+                    free(matrix);
                     free(json_filename);
                     goto again;
                 }
@@ -485,22 +1038,7 @@ again:
                 // Interaction Matrix: A + B -> C
                 for (size_t i = 0; i < species_count; ++i) {
                     for (size_t j = 0; j < species_count; ++j) {
-                        Expr_Index reaction = app(species_list[i].expr, species_list[j].expr);
-                        Expr_Index result;
-                        
-                        // Use standard evaluation limits
-                        Eval_Result res = eval_bounded(reaction, &result, 1000, 5000); 
-
-                        int result_id = -1; // -1 implies "Waste" or "External"
-
-                        if (res == EVAL_DONE) {
-                            char *res_lbl = expr_to_string(result);
-                            int found = find_species_index(species_list, species_count, res_lbl);
-                            if (found >= 0) {
-                                result_id = species_list[found].id;
-                            }
-                            free(res_lbl);
-                        }
+                        int result_id = matrix[i*species_count + j];
 
                         // We export the link. 
                         // If result_id is -1, it means the network is NOT closed (produces novel output).
@@ -520,15 +1058,16 @@ again:
                 // Cleanup
                 for(size_t i=0; i<species_count; ++i) free(species_list[i].label);
                 free(species_list);
+                free(matrix);
                 free(json_filename);
                 goto again;
             }
             if (command(&commands, l.string.items, "debug", "<expr>", "Step debug the evaluation of an expression")) {
                 Expr_Index expr;
-                if (!parse_expr(&l, &expr)) goto again;
+                if (!parse_expr(ctx, &l, &expr)) goto again;
                 if (!lexer_expect(&l, TOKEN_END)) goto again;
                 for (size_t i = bindings.count; i > 0; --i) {
-                    expr = replace(bindings.items[i-1].name, expr, bindings.items[i-1].body);
+                    expr = replace(ctx, bindings.items[i-1].name, expr, bindings.items[i-1].body);
                 }
 
                 ctrl_c = 0;
@@ -536,7 +1075,7 @@ again:
                     if (ctrl_c) goto again;
 
                     printf("DEBUG: ");
-                    trace_expr(expr);
+                    trace_expr(ctx, expr);
                     printf("\n");
 
                     printf("-> ");
@@ -554,10 +1093,10 @@ again:
                         if (strcmp(l.string.items, "quit") == 0) goto again;
                     }
 
-                    gc(expr, bindings);
+                    gc(ctx, expr, bindings);
 
                     Expr_Index expr1;
-                    if (!eval1(expr, &expr1)) goto again;
+                    if (!eval1(ctx, expr, &expr1)) goto again;
                     if (expr.unwrap == expr1.unwrap) break;
                     expr = expr1;
                 }
@@ -624,25 +1163,31 @@ again:
                 printf("Pool Size: %ld\n", pool_size);
                 printf("Iterations: %ld\n", iterations);
                 printf("Expression Depth: %ld\n", depth);
-                printf("Max Reduction Steps: %ld\n\n", max_steps);
+                printf("Max Reduction Steps: %ld\n", max_steps);
+                if (gas->islands) {
+                    printf("Islands: %zu, migrating %.1f%% every %ld collisions\n", gas_island_count(gas), gas->islands->fraction * 100.0, gas->islands->interval);
+                } else if (gas->batch) {
+                    printf("Batch: %zu collisions on %d threads\n", gas_batch_size(gas), gas_threads(gas));
+                }
+                printf("\n");
                 fflush(stdout);
                 
-                gas_pool.count = 0;
+                gas_clear(gas);
                 
                 // Check if we can resume from soup_* bindings
                 bool soup_loaded = false;
                 for (size_t i = 0; i < bindings.count; ++i) {
                     if (strncmp(bindings.items[i].name.label, "soup_", 5) == 0) {
-                        da_append(&gas_pool, bindings.items[i].body);
+                        gas_pool_set(gas, gas->pool.count, bindings.items[i].body);
                         soup_loaded = true;
                     }
                 }
                 
                 if (soup_loaded) {
-                    printf("Resumed simulation from loaded soup (%zu items).\n", gas_pool.count);
+                    printf("Resumed simulation from loaded soup (%zu items).\n", gas->pool.count);
                     fflush(stdout);
                     // Use the loaded soup size as the effective pool size
-                    pool_size = (long)gas_pool.count;
+                    pool_size = (long)gas->pool.count;
                 } else {
                     // Seed atoms for generating expressions (kept for reference/fallback)
                     const char *atoms[] = {"s", "k", "i", "x", "y", "z", "f", "g"};
@@ -652,126 +1197,26 @@ again:
                     
                     printf("Seeding primordial soup with RICH combinators...\n");
                     fflush(stdout);
-                    for (long i = 0; i < pool_size; ++i) {
-                        Expr_Index expr;
-                        
-                        // Keep generating until we get something that isn't \x.x
-                        // and isn't too simple.
-                        int attempts = 0;
-                        do {
-                            // Pass current_depth=0, max_depth=depth
-                            expr = generate_rich_combinator(0, (int)depth, NULL, 0);
-                            attempts++;
-                        } while (is_identity(expr) && attempts < 10);
-                        
-                        da_append(&gas_pool, expr);
-                    }
+                    gas_seed(gas, (size_t)pool_size, (int)depth);
                 }
                 
-                analyze_pool("INITIAL SOUP");
+                analyze_pool(gas, "INITIAL SOUP");
                 
                 printf("Starting simulation...\n");
                 fflush(stdout);
-                size_t converged = 0;
-                size_t diverged = 0;
-                size_t errors = 0;
+                gas->converged = 0;
+                gas->diverged = 0;
+                gas->errors = 0;
                 
                 // Open CSV log file for time-series data
                 FILE *log_csv = fopen(log_filename, "w");
-                if (log_csv) {
-                    fprintf(log_csv, "step,unique_count,entropy,top_freq\n");
-                } else {
+                if (!log_csv) {
                     fprintf(stderr, "WARNING: Could not open %s for writing\n", log_filename);
                 }
                 
-                for (long it = 0; it < iterations; ++it) {
-                    if (ctrl_c) {
-                        printf("\nSimulation interrupted by user.\n");
-                        break;
-                    }
-                    
-                    // Pick two random molecules
-                    size_t idx_a = rand() % gas_pool.count;
-                    size_t idx_b = rand() % gas_pool.count;
-                    
-                    Expr_Index A = gas_pool.items[idx_a];
-                    Expr_Index B = gas_pool.items[idx_b];
-                    
-                    // Reaction: A applied to B
-                    Expr_Index reaction = app(A, B);
-                    
-                    // Reduce with limits
-                    Expr_Index result;
-                    Eval_Result res = eval_bounded(reaction, &result, (size_t)max_steps, 5000);
-                    
-                    if (res == EVAL_DONE) {
-                        // Success: Overwrite a random slot
-                        size_t target_idx = rand() % gas_pool.count;
-                        gas_pool.items[target_idx] = result;
-                        converged++;
-                    } else if (res == EVAL_LIMIT) {
-                        // Divergence: Kill one reactant, replace with fresh combinator
-                        gas_pool.items[idx_a] = generate_rich_combinator(0, (int)depth, NULL, 0);
-                        diverged++;
-                    } else {
-                        // Error: Replace both with fresh combinators
-                        gas_pool.items[idx_a] = generate_rich_combinator(0, (int)depth, NULL, 0);
-                        gas_pool.items[idx_b] = generate_rich_combinator(0, (int)depth, NULL, 0);
-                        errors++;
-                    }
-                    
-                    // Periodic logging every 1000 steps
-                    if (log_csv && it % 1000 == 0 && gas_pool.count > 0) {
-                        // Snapshot all expressions as strings
-                        char **snapshots = malloc(gas_pool.count * sizeof(char*));
-                        for (size_t i = 0; i < gas_pool.count; ++i) {
-                            snapshots[i] = expr_to_string(gas_pool.items[i]);
-                        }
-                        
-                        // Sort to group identical species
-                        qsort(snapshots, gas_pool.count, sizeof(char*), compare_strings);
-                        
-                        // Calculate metrics: unique count, entropy, max frequency
-                        size_t unique = 1;
-                        double entropy = 0.0;
-                        size_t cur_freq = 1;
-                        size_t max_freq = 0;
-                        
-                        for (size_t i = 1; i < gas_pool.count; ++i) {
-                            if (strcmp(snapshots[i], snapshots[i-1]) != 0) {
-                                unique++;
-                                double p = (double)cur_freq / gas_pool.count;
-                                if (p > 0) entropy -= p * log(p);
-                                if (cur_freq > max_freq) max_freq = cur_freq;
-                                cur_freq = 1;
-                            } else {
-                                cur_freq++;
-                            }
-                        }
-                        // Handle the last run
-                        double p = (double)cur_freq / gas_pool.count;
-                        if (p > 0) entropy -= p * log(p);
-                        if (cur_freq > max_freq) max_freq = cur_freq;
-                        
-                        // Write to CSV
-                        fprintf(log_csv, "%ld,%zu,%.4f,%zu\n", it, unique, entropy, max_freq);
-                        fflush(log_csv);
-                        
-                        // Cleanup
-                        for (size_t i = 0; i < gas_pool.count; ++i) free(snapshots[i]);
-                        free(snapshots);
-                    }
-                    
-                    // Progress indicator
-                    if ((it + 1) % 100 == 0) {
-                        printf(".");
-                        fflush(stdout);
-                    }
-                    
-                    // Periodic GC to prevent OOM
-                    if (it % 50 == 0) {
-                        gc(var(symbol("_dummy")), bindings);
-                    }
+                ctrl_c = 0;
+                if (gas_run(gas, bindings, iterations, (int)depth, (size_t)max_steps, log_csv, true) < iterations) {
+                    printf("\nSimulation interrupted by user.\n");
                 }
                 
                 // Close CSV log file
@@ -780,20 +1225,17 @@ again:
                     printf("\nTime-series data saved to %s\n", log_filename);
                 }
                 
-                // Update total step counter for dump_soup metadata
-                gas_total_steps += iterations;
-                
                 printf("\n=== SIMULATION COMPLETE ===\n");
-                printf("Converged reactions: %zu\n", converged);
-                printf("Diverged reactions: %zu\n", diverged);
-                printf("Error reactions: %zu\n\n", errors);
+                printf("Converged reactions: %zu\n", gas->converged);
+                printf("Diverged reactions: %zu\n", gas->diverged);
+                printf("Error reactions: %zu\n\n", gas->errors);
                 
-                analyze_pool("FINAL SOUP");
+                analyze_pool(gas, "FINAL SOUP");
                 
                 fflush(stdout);
                 
                 // Export gas pool to bindings for inspection
-                printf("Exporting %zu specimens to bindings...\n", gas_pool.count);
+                printf("Exporting %zu specimens to bindings...\n", gas->pool.count);
                 fflush(stdout);
                 
                 // Clear old specimen bindings
@@ -805,10 +1247,10 @@ again:
                 }
                 
                 // Add gas pool to bindings
-                for (size_t i = 0; i < gas_pool.count; ++i) {
+                for (size_t i = 0; i < gas->pool.count; ++i) {
                     char buf[64];
                     snprintf(buf, sizeof(buf), "specimen_%zu", i);
-                    create_binding(&bindings, symbol(buf), gas_pool.items[i]);
+                    create_binding(&bindings, symbol(ctx, buf), gas->pool.items[i]);
                 }
                 
                 printf("Use ':list specimen_0 specimen_1 ...' to inspect results.\n");
@@ -817,11 +1259,64 @@ again:
                 
                 goto again;
             }
+            if (command(&commands, l.string.items, "batch", "[k] [threads]", "Show or set batched collisions: k per batch (0 = one at a time) on n threads (0 = all CPUs)")) {
+                if (lexer_next(&l) && l.token == TOKEN_NAME) {
+                    long size = strtol(l.string.items, NULL, 10);
+                    int threads = 0;
+                    if (lexer_next(&l) && l.token == TOKEN_NAME) threads = atoi(l.string.items);
+                    gas_set_batch(gas, size > 0 ? (size_t)size : 0, threads);
+                }
+                if (gas->batch) {
+                    printf("Batch: %zu collisions on %d threads\n", gas_batch_size(gas), gas_threads(gas));
+                    pool_print_stats(gas->batch->pool);
+                } else {
+                    printf("Batch: off\n");
+                }
+                goto again;
+            }
+            if (command(&commands, l.string.items, "islands", "[n] [interval] [migrate%] [threads]", "Show or set the island model: n private pools (1 = off) exchanging migrate% of their molecules every interval collisions")) {
+                if (lexer_next(&l) && l.token == TOKEN_NAME) {
+                    long count = strtol(l.string.items, NULL, 10);
+                    long interval = 1000;
+                    double percent = 5.0;
+                    int threads = 0;
+                    if (lexer_next(&l) && l.token == TOKEN_NAME) {
+                        interval = strtol(l.string.items, NULL, 10);
+                        if (lexer_next(&l) && l.token == TOKEN_NAME) {
+                            percent = strtod(l.string.items, NULL);
+                            if (lexer_next(&l) && l.token == TOKEN_NAME) threads = atoi(l.string.items);
+                        }
+                    }
+                    gas_set_islands(gas, count > 0 ? (size_t)count : 0, interval, percent / 100.0, threads);
+                }
+                if (gas->islands) {
+                    printf("Islands: %zu, migrating %.1f%% every %ld collisions\n", gas_island_count(gas), gas->islands->fraction * 100.0, gas->islands->interval);
+                    pool_print_stats(gas->islands->pool);
+                } else {
+                    printf("Islands: off\n");
+                }
+                goto again;
+            }
+            if (command(&commands, l.string.items, "seed", "[n]", "Show the seed of the random stream or restart it from n")) {
+                if (lexer_next(&l) && l.token == TOKEN_NAME) {
+                    if (!parse_seed(l.string.items, &seed)) {
+                        fprintf(stderr, "ERROR: seed must be a number\n");
+                        goto again;
+                    }
+                    rng_seed(&ctx->rng, seed);
+                }
+                printf("Seed: %llu\n", (unsigned long long)seed);
+                goto again;
+            }
+            if (command(&commands, l.string.items, "gc", "[mode] [budget_MB]", "Show heap stats, switch mode (tracing, refcount) or set a heap budget")) {
+                gc_command(ctx, &l);
+                goto again;
+            }
             if (command(&commands, l.string.items, "ast", "<expr>", "print the AST of the expression")) {
                 Expr_Index expr;
-                if (!parse_expr(&l, &expr)) goto again;
+                if (!parse_expr(ctx, &l, &expr)) goto again;
                 if (!lexer_expect(&l, TOKEN_END)) goto again;
-                dump_expr_ast(expr);
+                dump_expr_ast(ctx, expr);
                 goto again;
             }
             if (command(&commands, l.string.items, "quit", "", "quit the REPL")) goto quit;
@@ -844,20 +1339,20 @@ again:
 
         if (a == TOKEN_NAME && b == TOKEN_EQUALS) {
             if (!lexer_expect(&l, TOKEN_NAME)) goto again;
-            Symbol name = symbol(l.string.items);
+            Symbol name = symbol(ctx, l.string.items);
             if (!lexer_expect(&l, TOKEN_EQUALS)) goto again;
             Expr_Index body;
-            if (!parse_expr(&l, &body)) goto again;
+            if (!parse_expr(ctx, &l, &body)) goto again;
             if (!lexer_expect(&l, TOKEN_END)) goto again;
             create_binding(&bindings, name, body);
             goto again;
         }
 
         Expr_Index expr;
-        if (!parse_expr(&l, &expr)) goto again;
+        if (!parse_expr(ctx, &l, &expr)) goto again;
         if (!lexer_expect(&l, TOKEN_END)) goto again;
         for (size_t i = bindings.count; i > 0; --i) {
-            expr = replace(bindings.items[i-1].name, expr, bindings.items[i-1].body);
+            expr = replace(ctx, bindings.items[i-1].name, expr, bindings.items[i-1].body);
         }
 
         ctrl_c = 0;
@@ -867,22 +1362,23 @@ again:
                 goto again;
             }
 
-            gc(expr, bindings);
+            gc(ctx, expr, bindings);
 
             Expr_Index expr1;
-            if (!eval1(expr, &expr1)) goto again;
+            if (!eval1(ctx, expr, &expr1)) goto again;
             if (expr.unwrap == expr1.unwrap) break;
             expr = expr1;
         }
 
         printf("RESULT: ");
-        trace_expr(expr);
+        trace_expr(ctx, expr);
         printf("\n");
     }
 quit:
 
     return 0;
 }
+#endif // LAMB_LIBRARY_MODE
 
 // Copyright 2025 Alexey Kutepov <reximkut@gmail.com>
 //
@@ -1,8 +1,13 @@
 // ,---@>
 //  W-W'
 // LAMB GRID - Spatial Grid / Cellular Automata Simulation
-// cc -o lamb_grid lamb_grid.c lamb_lib.c -lm
+// cc -o lamb_grid lamb_grid.c lamb_lib.c -lm -pthread
 #include "lamb.h"
+#include <limits.h>
+#include <stddef.h>
+#ifndef _WIN32
+#    include <fcntl.h>
+#endif // _WIN32
 
 // ============================================================================
 // SPATIAL GRID SYSTEM (Cellular Automata + Lambda Calculus)
@@ -16,192 +21,339 @@ static Grid active_grid = {0};
 #endif
 
 // ============================================================================
-// GC FUNCTION (with grid marking)
+// GC ROOTS
 // ============================================================================
 
-void gc(Expr_Index root, Bindings bindings)
+// Every expression held by the grid (ctx->roots of its context)
+static void grid_visit_roots(Lamb_Context *ctx, Gc_Visit visit)
 {
-    for (size_t i = 0; i < GC.gens[GC.gen_cur].count; ++i) {
-        Expr_Index expr = GC.gens[GC.gen_cur].items[i];
-        expr_slot(expr).visited = false;
+    Grid *g = ctx->roots_data;
+    if (!g->cells) return;
+    for (int i = 0; i < g->cell_count; ++i) {
+        if (g->cells[i].occupied) {
+            Expr_Index atom = cell_atom(&g->cells[i]);
+            visit(ctx, &atom);
+            g->cells[i].atom = (uint32_t)atom.unwrap;
+        }
     }
+}
 
-    gc_mark(root);
-    for (size_t i = 0; i < bindings.count; ++i) {
-        gc_mark(bindings.items[i].body);
-    }
-    
-    // Mark all expressions in the active grid to prevent GC from sweeping them
-    if (active_grid.cells) {
-        int total = active_grid.width * active_grid.height;
-        for (int i = 0; i < total; ++i) {
-            if (active_grid.cells[i].occupied) {
-                gc_mark(active_grid.cells[i].atom);
-            }
+// ============================================================================
+// KINETIC ENGINE (Gillespie)
+// ============================================================================
+
+// Continuous-time alternative to the sweeps. Every cell has an event rate: an
+// occupied cell gets updated (ages, then moves or reacts, see
+// grid_update_cell()) once per unit of time on average, an empty one gets a
+// cosmic ray at COSMIC_RAY_RATE / 100000. The rates sit in a Fenwick tree as
+// integers in units of 1/100000, so the sums stay exact however many events
+// change them. The next event is drawn in O(log N) and the clock advances by
+// an exponential waiting time.
+// No speedup over the sweeps: every update of an occupied cell does something
+// (it moves or it reacts), so splitting the rate per event would leave every
+// occupied cell at the same total and the event count unchanged.
+#define GRID_KINETIC_UPDATE 100000
+#define GRID_KINETIC_SPAWN COSMIC_RAY_RATE
+
+struct Grid_Kinetic {
+    uint64_t *tree;       // Fenwick tree over the cells, 1-based
+    uint32_t *weight;     // Current weight of every cell
+    size_t size;
+    size_t top_bit;       // Highest power of two <= size
+};
+
+static void grid_kinetic_add(Grid_Kinetic *k, size_t i, int64_t delta)
+{
+    for (++i; i <= k->size; i += i & (~i + 1)) k->tree[i] += (uint64_t)delta;
+}
+
+static uint64_t grid_kinetic_total(Grid_Kinetic *k)
+{
+    uint64_t sum = 0;
+    for (size_t i = k->size; i > 0; i -= i & (~i + 1)) sum += k->tree[i];
+    return sum;
+}
+
+// The cell whose weight interval contains r < total
+static size_t grid_kinetic_find(Grid_Kinetic *k, uint64_t r)
+{
+    size_t pos = 0;
+    for (size_t bit = k->top_bit; bit > 0; bit >>= 1) {
+        if (pos + bit <= k->size && k->tree[pos + bit] <= r) {
+            pos += bit;
+            r -= k->tree[pos];
         }
     }
+    return pos;
+}
 
-    size_t next = 1 - GC.gen_cur;
-    GC.gens[next].count = 0;
-    for (size_t i = 0; i < GC.gens[GC.gen_cur].count; ++i) {
-        Expr_Index expr = GC.gens[GC.gen_cur].items[i];
-        if (expr_slot(expr).visited) {
-            da_append(&GC.gens[next], expr);
-        } else {
-            free_expr(expr);
-        }
+// Bring the weight of a cell in line with its occupancy
+static void grid_kinetic_touch(Grid *g, int idx)
+{
+    Grid_Kinetic *k = g->kinetic;
+    uint32_t weight = g->cells[idx].occupied ? GRID_KINETIC_UPDATE : GRID_KINETIC_SPAWN;
+    if (k->weight[idx] == weight) return;
+    grid_kinetic_add(k, (size_t)idx, (int64_t)weight - (int64_t)k->weight[idx]);
+    k->weight[idx] = weight;
+}
+
+// Every cell empty
+static Grid_Kinetic *grid_kinetic_new(size_t size)
+{
+    Grid_Kinetic *k = calloc(1, sizeof(*k));
+    assert(k != NULL && "Buy more RAM lol");
+    k->size = size;
+    k->tree = calloc(size + 1, sizeof(*k->tree));
+    k->weight = malloc(size * sizeof(*k->weight));
+    assert(k->tree != NULL && k->weight != NULL && "Buy more RAM lol");
+    for (size_t i = 1; i <= size; ++i) {
+        k->weight[i - 1] = GRID_KINETIC_SPAWN;
+        k->tree[i] += GRID_KINETIC_SPAWN;
+        size_t parent = i + (i & (~i + 1));
+        if (parent <= size) k->tree[parent] += k->tree[i];
     }
-    GC.gen_cur = next;
+    k->top_bit = 1;
+    while (k->top_bit * 2 <= size) k->top_bit *= 2;
+    return k;
 }
 
-// Compact GC slots to reclaim memory and improve cache locality
-// Call this periodically when slot fragmentation is high
-void gc_compact(Bindings *bindings) {
-    if (GC.slots.count == 0) return;
-    
-    // Only compact if fragmentation is significant (>50% dead space)
-    size_t live_count = GC.slots.count - GC.dead.count;
-    if (GC.dead.count < GC.slots.count / 2) return;
-    
-    // Build remapping table: old_index -> new_index
-    size_t *remap = malloc(GC.slots.count * sizeof(size_t));
-    for (size_t i = 0; i < GC.slots.count; ++i) {
-        remap[i] = (size_t)-1;  // Mark as unmapped
+static void grid_kinetic_free(Grid_Kinetic *k)
+{
+    if (!k) return;
+    free(k->tree);
+    free(k->weight);
+    free(k);
+}
+
+void grid_set_kinetic(Grid *g, bool kinetic)
+{
+    g->want_kinetic = kinetic;
+}
+
+// ============================================================================
+// SPECIES HISTOGRAM
+// ============================================================================
+
+// Slot of the hash, or of the free slot where it would go
+static size_t histogram_probe(Grid_Histogram *h, uint64_t hash)
+{
+    size_t mask = h->capacity - 1;
+    size_t i = (size_t)hash & mask;
+    size_t deleted = SIZE_MAX;
+    while (h->slots[i].hash != 0 && h->slots[i].hash != hash) {
+        if (deleted == SIZE_MAX && h->slots[i].count == 0) deleted = i;
+        i = (i + 1) & mask;
     }
-    
-    // Allocate new compact slots array
-    Expr *new_slots = malloc(live_count * sizeof(Expr));
-    size_t new_idx = 0;
-    
-    // Copy live expressions and build remap
-    for (size_t i = 0; i < GC.slots.count; ++i) {
-        if (GC.slots.items[i].live) {
-            new_slots[new_idx] = GC.slots.items[i];
-            remap[i] = new_idx;
-            new_idx++;
-        }
+    if (h->slots[i].hash == 0 && deleted != SIZE_MAX) return deleted;
+    return i;
+}
+
+static void histogram_link(Grid_Histogram *h, size_t i)
+{
+    Grid_Species_Slot *slot = &h->slots[i];
+    while (h->heads.count <= slot->count) da_append(&h->heads, -1);
+    slot->prev = -1;
+    slot->next = h->heads.items[slot->count];
+    if (slot->next >= 0) h->slots[slot->next].prev = (int32_t)i;
+    h->heads.items[slot->count] = (int32_t)i;
+}
+
+static void histogram_unlink(Grid_Histogram *h, size_t i)
+{
+    Grid_Species_Slot *slot = &h->slots[i];
+    if (slot->prev >= 0) {
+        h->slots[slot->prev].next = slot->next;
+    } else {
+        h->heads.items[slot->count] = slot->next;
     }
-    
-    // Update all internal expression references
-    for (size_t i = 0; i < new_idx; ++i) {
-        Expr *e = &new_slots[i];
-        switch (e->kind) {
-        case EXPR_FUN:
-            if (remap[e->as.fun.body.unwrap] != (size_t)-1) {
-                e->as.fun.body.unwrap = remap[e->as.fun.body.unwrap];
-            }
-            break;
-        case EXPR_APP:
-            if (remap[e->as.app.lhs.unwrap] != (size_t)-1) {
-                e->as.app.lhs.unwrap = remap[e->as.app.lhs.unwrap];
-            }
-            if (remap[e->as.app.rhs.unwrap] != (size_t)-1) {
-                e->as.app.rhs.unwrap = remap[e->as.app.rhs.unwrap];
-            }
-            break;
-        default:
-            break;
+    if (slot->next >= 0) h->slots[slot->next].prev = slot->prev;
+}
+
+// Rebuild without the deleted slots, keeping the order of every chain
+static void histogram_rehash(Grid_Histogram *h)
+{
+    Grid_Histogram old = *h;
+    size_t capacity = 64;
+    while (capacity < 4 * (old.unique + 1)) capacity *= 2;
+    h->slots = calloc(capacity, sizeof(Grid_Species_Slot));
+    assert(h->slots != NULL && "Buy more RAM lol");
+    h->capacity = capacity;
+    h->used = old.unique;
+    memset(&h->heads, 0, sizeof(h->heads));
+    for (size_t count = 1; count < old.heads.count; ++count) {
+        int32_t last = old.heads.items[count];
+        if (last < 0) continue;
+        while (old.slots[last].next >= 0) last = old.slots[last].next;
+        for (int32_t j = last; j >= 0; j = old.slots[j].prev) {
+            size_t i = histogram_probe(h, old.slots[j].hash);
+            h->slots[i].hash = old.slots[j].hash;
+            h->slots[i].count = old.slots[j].count;
+            histogram_link(h, i);
         }
     }
-    
-    // Update grid cell references
-    if (active_grid.cells) {
-        int total = active_grid.width * active_grid.height;
-        for (int i = 0; i < total; ++i) {
-            if (active_grid.cells[i].occupied) {
-                size_t old_idx = active_grid.cells[i].atom.unwrap;
-                if (remap[old_idx] != (size_t)-1) {
-                    active_grid.cells[i].atom.unwrap = remap[old_idx];
-                }
-            }
-        }
+    free(old.slots);
+    free(old.heads.items);
+}
+
+static void histogram_add(Grid_Histogram *h, uint64_t hash)
+{
+    if (4 * (h->used + 1) > 3 * h->capacity) histogram_rehash(h);
+    size_t i = histogram_probe(h, hash);
+    Grid_Species_Slot *slot = &h->slots[i];
+    if (slot->hash != hash) {
+        if (slot->hash == 0) h->used++;
+        slot->hash = hash;
+        slot->count = 0;
     }
-    
-    // Update bindings references
-    if (bindings) {
-        for (size_t i = 0; i < bindings->count; ++i) {
-            size_t old_idx = bindings->items[i].body.unwrap;
-            if (remap[old_idx] != (size_t)-1) {
-                bindings->items[i].body.unwrap = remap[old_idx];
-            }
-        }
+    if (slot->count == 0) {
+        h->unique++;
+    } else {
+        histogram_unlink(h, i);
     }
-    
-    // Update GC generation arrays
-    for (int g = 0; g < 2; ++g) {
-        size_t write_idx = 0;
-        for (size_t i = 0; i < GC.gens[g].count; ++i) {
-            size_t old_idx = GC.gens[g].items[i].unwrap;
-            if (remap[old_idx] != (size_t)-1) {
-                GC.gens[g].items[write_idx].unwrap = remap[old_idx];
-                write_idx++;
-            }
-        }
-        GC.gens[g].count = write_idx;
+    slot->count++;
+    histogram_link(h, i);
+    if (slot->count > h->max_freq) h->max_freq = slot->count;
+}
+
+static void histogram_remove(Grid_Histogram *h, uint64_t hash)
+{
+    size_t i = histogram_probe(h, hash);
+    Grid_Species_Slot *slot = &h->slots[i];
+    assert(slot->hash == hash && slot->count > 0 && "Species is not in the histogram");
+    histogram_unlink(h, i);
+    slot->count--;
+    if (slot->count > 0) {
+        histogram_link(h, i);
+    } else {
+        h->unique--;
     }
-    
-    // Swap in new slots array
-    free(GC.slots.items);
-    GC.slots.items = new_slots;
-    GC.slots.count = new_idx;
-    GC.slots.capacity = live_count;
-    
-    // Clear dead list (all slots are now live and compact)
-    GC.dead.count = 0;
-    
-    free(remap);
+    // Only the species that just left could have been alone at max_freq
+    if (h->heads.items[h->max_freq] < 0) h->max_freq--;
 }
 
+static void histogram_free(Grid_Histogram *h)
+{
+    free(h->slots);
+    free(h->heads.items);
+    memset(h, 0, sizeof(*h));
+}
+
+size_t grid_species_count(Grid *g, uint64_t hash)
+{
+    Grid_Histogram *h = &g->histogram;
+    if (h->capacity == 0 || hash == 0) return 0;
+    Grid_Species_Slot *slot = &h->slots[histogram_probe(h, hash)];
+    return slot->hash == hash ? slot->count : 0;
+}
+
+uint64_t grid_dominant(Grid *g)
+{
+    Grid_Histogram *h = &g->histogram;
+    if (h->max_freq == 0) return 0;
+    return h->slots[h->heads.items[h->max_freq]].hash;
+}
 
 // ============================================================================
-// HASHING FUNCTIONS (for fast species comparison)
+// GRID FUNCTIONS
 // ============================================================================
 
-static uint32_t hash_string(const char *str) {
-    uint32_t hash = 5381;
-    int c;
-    while ((c = *str++)) {
-        hash = ((hash << 5) + hash) + (uint32_t)c;
+#define GRID_BLOCK_AREA (GRID_BLOCK * GRID_BLOCK)
+
+// Neighbour tables of the blocked layout. Moving inside a block is a fixed
+// offset, moving out of it lands on the opposite edge of the next block.
+static void grid_layout_blocks(Grid *g)
+{
+    const int B = GRID_BLOCK;
+    int blocks_x = g->width / B, blocks_y = g->height / B;
+    g->blocks_x = blocks_x;
+    g->block_next = malloc((size_t)(blocks_x * blocks_y) * 4 * sizeof(int));
+    assert(g->block_next != NULL && "Buy more RAM lol");
+    for (int by = 0; by < blocks_y; ++by) {
+        for (int bx = 0; bx < blocks_x; ++bx) {
+            int *next = &g->block_next[(by * blocks_x + bx) * 4];
+            next[0] = (by + blocks_y - 1) % blocks_y * blocks_x + bx;
+            next[1] = by * blocks_x + (bx + 1) % blocks_x;
+            next[2] = (by + 1) % blocks_y * blocks_x + bx;
+            next[3] = by * blocks_x + (bx + blocks_x - 1) % blocks_x;
+        }
+    }
+    for (int ly = 0; ly < B; ++ly) {
+        for (int lx = 0; lx < B; ++lx) {
+            int p = ly * B + lx;
+            g->local_next[0][p] = ly > 0     ? p - B : -((B - 1) * B + lx + 1);
+            g->local_next[1][p] = lx < B - 1 ? p + 1 : -(ly * B + 1);
+            g->local_next[2][p] = ly < B - 1 ? p + B : -(lx + 1);
+            g->local_next[3][p] = lx > 0     ? p - 1 : -(ly * B + B - 1 + 1);
+        }
     }
-    return hash;
 }
 
-// Recursive AST Hasher (No allocation)
-// Walks the GC slots directly to compute a structural ID
-static uint32_t hash_expr(Expr_Index expr) {
-    if (expr.unwrap >= GC.slots.count) return 0;
-    Expr *e = &expr_slot_unsafe(expr);
-    if (!e->live) return 0;
-    
-    uint32_t h = 0;
-    
-    switch (e->kind) {
-    case EXPR_VAR:
-        h = hash_string(e->as.var.label);
-        h = h ^ ((uint32_t)e->as.var.tag * 33);
-        return h;
-    case EXPR_MAG:
-        return hash_string(e->as.mag) ^ 0xAAAAAAAA;
-    case EXPR_FUN:
-        h = hash_string(e->as.fun.param.label);
-        return (h << 3) ^ hash_expr(e->as.fun.body);
-    case EXPR_APP:
-        return (hash_expr(e->as.app.lhs) * 33) ^ 
-               hash_expr(e->as.app.rhs);
-    default: 
-        return 0;
+void grid_set_layout(Grid *g, bool blocked)
+{
+    g->want_blocked = blocked;
+}
+
+void grid_set_sparse(Grid *g, bool sparse)
+{
+    g->want_sparse = sparse;
+}
+
+#define GRID_SPARSE_AREA (GRID_SPARSE_TILE * GRID_SPARSE_TILE)
+
+// Give a tile of a sparse world a slot of empty cells. The cell arrays may
+// move.
+static int grid_tile_alloc(Grid *g, int tile)
+{
+    int slot;
+    if (g->free_slots.count > 0) {
+        slot = g->free_slots.items[--g->free_slots.count];
+    } else {
+        assert(g->slots.count < (size_t)(INT_MAX / GRID_SPARSE_AREA) && "World too crowded for int cell indices");
+        slot = (int)g->slots.count;
+        Grid_Slot empty = {0};
+        da_append(&g->slots, empty);
+        if (g->slots.count > g->slots_allocated) {
+            size_t old = g->slots_allocated * GRID_SPARSE_AREA;
+            g->slots_allocated = g->slots.capacity;
+            size_t cells = g->slots_allocated * GRID_SPARSE_AREA;
+            g->cells = realloc(g->cells, cells * sizeof(Cell));
+            g->info = realloc(g->info, cells * sizeof(Cell_Info));
+            g->active_slot = realloc(g->active_slot, cells * sizeof(int));
+            assert(g->cells != NULL && g->info != NULL && g->active_slot != NULL && "Buy more RAM lol");
+            for (size_t i = old; i < cells; ++i) g->active_slot[i] = -1;
+        }
+        g->cell_count = (int)(g->slots.count * GRID_SPARSE_AREA);
     }
+    size_t base = (size_t)slot * GRID_SPARSE_AREA;
+    memset(&g->cells[base], 0, GRID_SPARSE_AREA * sizeof(Cell));
+    memset(&g->info[base], 0, GRID_SPARSE_AREA * sizeof(Cell_Info));
+    g->slots.items[slot] = (Grid_Slot){ .tile = tile };
+    g->tile_slot[tile] = slot;
+    return slot;
 }
 
-// ============================================================================
-// GRID FUNCTIONS
-// ============================================================================
+// Hand the slots of tiles that got empty back (between steps, so no cell
+// index in flight points into them)
+static void grid_tiles_release(Grid *g)
+{
+    for (size_t slot = 0; slot < g->slots.count; ++slot) {
+        Grid_Slot *s = &g->slots.items[slot];
+        if (s->tile < 0 || s->population > 0) continue;
+        g->tile_slot[s->tile] = -1;
+        s->tile = -1;
+        da_append(&g->free_slots, (int)slot);
+    }
+}
 
-void grid_init(Grid *g, int w, int h) {
-    if (g->cells) free(g->cells);
+void grid_init(Grid *g, Lamb_Context *ctx, int w, int h) {
+    grid_free(g);
+    g->ctx = ctx;
+    ctx->roots = grid_visit_roots;
+    ctx->roots_data = g;
     g->width = w;
     g->height = h;
     g->steps = 0;
+    g->time = 0.0;
     g->population = 0;
     g->reactions_success = 0;
     g->reactions_diverged = 0;
@@ -210,15 +362,70 @@ void grid_init(Grid *g, int w, int h) {
     g->cosmic_spawns = 0;
     g->attacks = 0;
     g->evasions = 0;
+    g->active.count = 0;
+    g->sparse = g->want_sparse;
+    if (g->sparse) {
+        g->tiles_x = (w + GRID_SPARSE_TILE - 1) / GRID_SPARSE_TILE;
+        g->tiles_y = (h + GRID_SPARSE_TILE - 1) / GRID_SPARSE_TILE;
+        size_t tiles = (size_t)g->tiles_x * (size_t)g->tiles_y;
+        assert(tiles <= INT_MAX && "World too big");
+        g->tile_slot = malloc(tiles * sizeof(int));
+        assert(g->tile_slot != NULL && "Buy more RAM lol");
+        for (size_t i = 0; i < tiles; ++i) g->tile_slot[i] = -1;
+        g->cell_count = 0;
+        return;
+    }
+    assert((size_t)w * (size_t)h <= INT_MAX && "Use a sparse world for grids this big");
+    g->cell_count = w * h;
     g->cells = calloc((size_t)(w * h), sizeof(Cell));
     assert(g->cells != NULL);
+    g->info = calloc((size_t)(w * h), sizeof(Cell_Info));
+    assert(g->info != NULL && "Buy more RAM lol");
+    g->blocked = g->want_blocked && w % GRID_BLOCK == 0 && h % GRID_BLOCK == 0;
+    if (g->blocked) grid_layout_blocks(g);
+    if (g->want_kinetic) g->kinetic = grid_kinetic_new((size_t)(w * h));
+    g->active_slot = malloc((size_t)(w * h) * sizeof(int));
+    assert(g->active_slot != NULL && "Buy more RAM lol");
+    for (int i = 0; i < w * h; ++i) g->active_slot[i] = -1;
 }
 
 void grid_free(Grid *g) {
+    grid_record_stop(g);
+    histogram_free(&g->histogram);
+    grid_clusters_free(&g->clusters);
     if (g->cells) {
-        free(g->cells);
-        g->cells = NULL;
+        for (int i = 0; i < g->cell_count; ++i) {
+            if (g->cells[i].occupied) gc_forget(g->ctx, cell_atom(&g->cells[i]));
+        }
     }
+    free(g->cells);
+    free(g->info);
+    g->cells = NULL;
+    g->info = NULL;
+    g->cell_count = 0;
+    free(g->tile_slot);
+    free(g->slots.items);
+    free(g->free_slots.items);
+    free(g->live.items);
+    g->tile_slot = NULL;
+    memset(&g->slots, 0, sizeof(g->slots));
+    memset(&g->free_slots, 0, sizeof(g->free_slots));
+    memset(&g->live, 0, sizeof(g->live));
+    g->slots_allocated = 0;
+    g->sparse = false;
+    grid_kinetic_free(g->kinetic);
+    g->kinetic = NULL;
+    free(g->active.items);
+    free(g->active_slot);
+    free(g->sweep.items);
+    free(g->sweep_start.items);
+    free(g->block_next);
+    g->block_next = NULL;
+    g->blocked = false;
+    memset(&g->active, 0, sizeof(g->active));
+    memset(&g->sweep, 0, sizeof(g->sweep));
+    memset(&g->sweep_start, 0, sizeof(g->sweep_start));
+    g->active_slot = NULL;
     g->width = 0;
     g->height = 0;
     g->steps = 0;
@@ -232,277 +439,1746 @@ int grid_idx(Grid *g, int x, int y) {
     // Wrap y
     int wy = y % g->height;
     if (wy < 0) wy += g->height;
-    return wy * g->width + wx;
+    if (g->sparse) {
+        int tile = wy / GRID_SPARSE_TILE * g->tiles_x + wx / GRID_SPARSE_TILE;
+        int slot = g->tile_slot[tile];
+        if (slot < 0) slot = grid_tile_alloc(g, tile);
+        return slot * GRID_SPARSE_AREA + wy % GRID_SPARSE_TILE * GRID_SPARSE_TILE + wx % GRID_SPARSE_TILE;
+    }
+    if (!g->blocked) return wy * g->width + wx;
+    int block = wy / GRID_BLOCK * g->blocks_x + wx / GRID_BLOCK;
+    return block * GRID_BLOCK_AREA + wy % GRID_BLOCK * GRID_BLOCK + wx % GRID_BLOCK;
+}
+
+void grid_xy(Grid *g, int idx, int *x, int *y)
+{
+    if (g->sparse) {
+        int tile = g->slots.items[idx / GRID_SPARSE_AREA].tile, p = idx % GRID_SPARSE_AREA;
+        *x = tile % g->tiles_x * GRID_SPARSE_TILE + p % GRID_SPARSE_TILE;
+        *y = tile / g->tiles_x * GRID_SPARSE_TILE + p / GRID_SPARSE_TILE;
+        return;
+    }
+    if (!g->blocked) {
+        *x = idx % g->width;
+        *y = idx / g->width;
+        return;
+    }
+    int block = idx / GRID_BLOCK_AREA, p = idx % GRID_BLOCK_AREA;
+    *x = block % g->blocks_x * GRID_BLOCK + p % GRID_BLOCK;
+    *y = block / g->blocks_x * GRID_BLOCK + p / GRID_BLOCK;
+}
+
+// Cell next to idx in direction dir (0:N, 1:E, 2:S, 3:W)
+static int grid_neighbor(Grid *g, int idx, int dir)
+{
+    if (g->sparse) {
+        // Inside the tile (and the world) it's an offset
+        int p = idx % GRID_SPARSE_AREA, x, y;
+        grid_xy(g, idx, &x, &y);
+        switch (dir) {
+            case 0:
+                if (p >= GRID_SPARSE_TILE) return idx - GRID_SPARSE_TILE;
+                return grid_idx(g, x, y - 1);
+            case 1:
+                if ((p + 1) % GRID_SPARSE_TILE != 0 && x + 1 < g->width) return idx + 1;
+                return grid_idx(g, x + 1, y);
+            case 2:
+                if (p < GRID_SPARSE_AREA - GRID_SPARSE_TILE && y + 1 < g->height) return idx + GRID_SPARSE_TILE;
+                return grid_idx(g, x, y + 1);
+            default:
+                if (p % GRID_SPARSE_TILE != 0) return idx - 1;
+                return grid_idx(g, x - 1, y);
+        }
+    }
+    if (g->blocked) {
+        int p = g->local_next[dir][idx % GRID_BLOCK_AREA];
+        if (p >= 0) return idx - idx % GRID_BLOCK_AREA + p;
+        return g->block_next[idx / GRID_BLOCK_AREA * 4 + dir] * GRID_BLOCK_AREA - p - 1;
+    }
+    int x = idx % g->width;
+    int area = g->width * g->height;
+    switch (dir) {
+        case 0:  return idx >= g->width ? idx - g->width : idx + area - g->width;
+        case 1:  return x < g->width - 1 ? idx + 1 : idx + 1 - g->width;
+        case 2:  return idx < area - g->width ? idx + g->width : idx + g->width - area;
+        default: return x > 0 ? idx - 1 : idx - 1 + g->width;
+    }
+}
+
+// g->active bookkeeping. Parallel workers journal their changes instead (see
+// grid_cell_moved()) and the journals are applied between phases.
+static void grid_active_add(Grid *g, int idx)
+{
+    if (g->sparse) g->slots.items[idx / GRID_SPARSE_AREA].population++;
+    if (g->kinetic) grid_kinetic_touch(g, idx);
+    g->active_slot[idx] = (int)g->active.count;
+    da_append(&g->active, idx);
+}
+
+static void grid_active_remove(Grid *g, int idx)
+{
+    if (g->sparse) g->slots.items[idx / GRID_SPARSE_AREA].population--;
+    if (g->kinetic) grid_kinetic_touch(g, idx);
+    int slot = g->active_slot[idx];
+    int last = g->active.items[--g->active.count];
+    g->active.items[slot] = last;
+    g->active_slot[last] = slot;
+    g->active_slot[idx] = -1;
+}
+
+static void grid_active_move(Grid *g, int from, int to)
+{
+    if (g->sparse) {
+        g->slots.items[from / GRID_SPARSE_AREA].population--;
+        g->slots.items[to / GRID_SPARSE_AREA].population++;
+    }
+    if (g->kinetic) {
+        grid_kinetic_touch(g, from);
+        grid_kinetic_touch(g, to);
+    }
+    int slot = g->active_slot[from];
+    g->active.items[slot] = to;
+    g->active_slot[to] = slot;
+    g->active_slot[from] = -1;
+}
+
+// A cell got occupied (from < 0), emptied (to < 0) or moved
+static void grid_active_apply(Grid *g, int from, int to)
+{
+    if (from < 0) grid_active_add(g, to);
+    else if (to < 0) grid_active_remove(g, from);
+    else grid_active_move(g, from, to);
+}
+
+static void cell_set_atom(Cell *cell, Expr_Index atom)
+{
+    assert(atom.unwrap <= UINT32_MAX && "Buy more RAM lol");
+    cell->atom = (uint32_t)atom.unwrap;
+}
+
+// Populate grid randomly with SKI combinators
+// Put a fresh combinator in an empty cell
+static void grid_seed_cell(Grid *g, int idx, int depth)
+{
+    Lamb_Context *ctx = g->ctx;
+    // Generate an SKI combinator tree
+    // Skip pure I combinators as they're trivial
+    Expr_Index e;
+    int sub_attempts = 0;
+    do {
+        e = generate_rich_combinator(ctx, 0, depth, NULL, 0);
+        sub_attempts++;
+    } while (is_identity(ctx, e) && sub_attempts < 5);
+
+    cell_set_atom(&g->cells[idx], e);
+    gc_remember(ctx, e);
+    g->info[idx].hash = expr_hash(ctx, e);
+    histogram_add(&g->histogram, g->info[idx].hash);
+    g->cells[idx].occupied = true;
+    g->cells[idx].age = 0;
+    g->info[idx].generation = 0;
+    g->info[idx].cache_valid = false;  // Invalidate cache for new cell
+    g->population++;  // Increment population counter
+    grid_active_add(g, idx);
 }
 
 // Populate grid randomly with SKI combinators
 void grid_seed(Grid *g, int count, int depth) {
+    Lamb_Context *ctx = g->ctx;
     int placed = 0;
     int attempts = 0;
     int max_attempts = count * 10;
     
     while (placed < count && attempts < max_attempts) {
-        int x = rand() % g->width;
-        int y = rand() % g->height;
+        int x = (int)rng_below(&ctx->rng, (uint32_t)g->width);
+        int y = (int)rng_below(&ctx->rng, (uint32_t)g->height);
         int idx = grid_idx(g, x, y);
         
         if (!g->cells[idx].occupied) {
-            // Generate an SKI combinator tree
-            // Skip pure I combinators as they're trivial
-            Expr_Index e;
-            int sub_attempts = 0;
-            do {
-                e = generate_rich_combinator(0, depth, NULL, 0);
-                sub_attempts++;
-            } while (is_identity(e) && sub_attempts < 5);
-
-            g->cells[idx].atom = e;
-            g->cells[idx].occupied = true;
-            g->cells[idx].age = 0;
-            g->cells[idx].generation = 0;
-            g->cells[idx].cache_valid = false;  // Invalidate cache for new cell
-            g->population++;  // Increment population counter
+            grid_seed_cell(g, idx, depth);
             placed++;
         }
         attempts++;
     }
 }
 
-// Return cached population count (O(1) instead of O(n))
+// Seed discs of the given radius around random centres, every cell of a disc
+// with probability density%. For worlds far too big to seed all over.
+void grid_seed_colonies(Grid *g, int colonies, int radius, int density, int depth)
+{
+    Lamb_Context *ctx = g->ctx;
+    for (int c = 0; c < colonies; ++c) {
+        int cx = (int)rng_below(&ctx->rng, (uint32_t)g->width);
+        int cy = (int)rng_below(&ctx->rng, (uint32_t)g->height);
+        for (int dy = -radius; dy <= radius; ++dy) {
+            for (int dx = -radius; dx <= radius; ++dx) {
+                if (dx * dx + dy * dy > radius * radius) continue;
+                if ((int)rng_below(&ctx->rng, 100) >= density) continue;
+                int idx = grid_idx(g, cx + dx, cy + dy);
+                if (!g->cells[idx].occupied) grid_seed_cell(g, idx, depth);
+            }
+        }
+    }
+}
+
 int grid_population(Grid *g) {
     return g->population;
 }
 
+// ============================================================================
+// RECORD AND REPLAY
+// ============================================================================
+
+// Event log of a grid run. The header holds the random stream, the fresh tag
+// counter and every cell of the starting grid. From there a run is a function
+// of the stream except for the reductions, so a step only logs its reactions
+// in the order the cells were updated: how many fresh tags the reduction took
+// and its normal form, or that it diverged. A replay re-executes the steps and
+// checks every reaction against the log, or, fast, takes the logged outcome
+// instead of reducing. Parallel steps log a segment per tile in tile order,
+// so the log doesn't depend on the thread count.
+//
+//   log     = "LAMBREC4" seed rng[4] fresh width height layout eval_steps max_mass
+//             cell_count {y*width+x age generation term} step*
+//   layout  = tiled | blocked << 1 | sparse << 2 | kinetic << 3
+//   step    = 'S' segment* population reactions_success
+//   segment = event_count {fresh outcome}
+//   outcome = 0 (diverged) | term
+//   term    = 2*id + 1 (seen before) | 2*len + 2 bytes[len] (expr_encode()d)
+//
+// Numbers are LEB128 varints.
+#define GRID_RECORD_MAGIC "LAMBREC4"
+#define GRID_RECORD_STEP 'S'
+
+typedef struct {
+    bool done;
+    uint32_t result;      // Logged term of a normal form
+    uint64_t fresh;
+} Grid_Event;
+
+// Reactions of one tile (of the whole step when serial)
+typedef struct {
+    Bytes bytes;          // Recording: {fresh, 0 | len + 1 bytes[len]} as the worker met them
+    size_t count;
+    struct {
+        Grid_Event *items;
+        size_t count;
+        size_t capacity;
+    } events;             // Replaying
+    size_t next;
+} Grid_Segment;
+
+struct Grid_Record {
+    FILE *file;
+    bool replay;
+    bool fast;            // Replay takes reaction outcomes from the log
+    bool failed;          // Log ended early or is corrupt
+    uint64_t file_size;   // Replaying: no logged term is longer than the rest of it
+    Grid_Workers *workers; // Replaying: the grid's own, put back by grid_record_stop()
+    Grid_Record_Info info;
+    struct {
+        Grid_Segment *items;
+        size_t count;
+        size_t capacity;
+    } segments;           // Of the current phase
+    // Logged terms by id: terms[offsets[id], offsets[id + 1])
+    Bytes terms;
+    struct {
+        size_t *items;
+        size_t count;
+        size_t capacity;
+    } offsets;
+    uint32_t *table;      // Recording: open addressing over id + 1
+    size_t table_size;
+    Bytes out;
+    long mismatches;
+};
+
+static bool grid_tiled(Grid *g)
+{
+    return g->workers && !g->sparse && !g->kinetic && g->width >= 4 && g->height >= 4;
+}
+
+static void file_put_varint(FILE *f, uint64_t value)
+{
+    while (value >= 0x80) {
+        fputc((int)(value | 0x80) & 0xFF, f);
+        value >>= 7;
+    }
+    fputc((int)value, f);
+}
+
+static bool file_get_varint(FILE *f, uint64_t *value)
+{
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = fgetc(f);
+        if (byte == EOF) return false;
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+static long long file_tell(FILE *f)
+{
+#ifndef _WIN32
+    return ftell(f);
+#else
+    return _ftelli64(f);
+#endif
+}
+
+static size_t grid_record_term_count(Grid_Record *rec)
+{
+    return rec->offsets.count > 0 ? rec->offsets.count - 1 : 0;
+}
+
+static uint32_t grid_record_add_term(Grid_Record *rec, const uint8_t *bytes, size_t size)
+{
+    if (rec->offsets.count == 0) da_append(&rec->offsets, 0);
+    for (size_t i = 0; i < size; ++i) da_append(&rec->terms, bytes[i]);
+    da_append(&rec->offsets, rec->terms.count);
+    return (uint32_t)(rec->offsets.count - 2);
+}
+
+static bool grid_record_term_is(Grid_Record *rec, uint32_t id, const uint8_t *bytes, size_t size)
+{
+    size_t start = rec->offsets.items[id];
+    return rec->offsets.items[id + 1] - start == size && memcmp(&rec->terms.items[start], bytes, size) == 0;
+}
+
+// FNV-1a
+static uint64_t grid_record_hash(const uint8_t *bytes, size_t size)
+{
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= bytes[i];
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+static void grid_record_insert(Grid_Record *rec, uint32_t id)
+{
+    size_t start = rec->offsets.items[id];
+    uint64_t h = grid_record_hash(&rec->terms.items[start], rec->offsets.items[id + 1] - start);
+    size_t i = (size_t)h & (rec->table_size - 1);
+    while (rec->table[i]) i = (i + 1) & (rec->table_size - 1);
+    rec->table[i] = id + 1;
+}
+
+// Appends the term code of bytes to rec->out, logging the term the first time
+static void grid_record_put_term(Grid_Record *rec, const uint8_t *bytes, size_t size)
+{
+    size_t mask = rec->table_size - 1;
+    for (size_t i = (size_t)grid_record_hash(bytes, size) & mask; rec->table[i]; i = (i + 1) & mask) {
+        if (grid_record_term_is(rec, rec->table[i] - 1, bytes, size)) {
+            bytes_put_varint(&rec->out, 2 * (uint64_t)(rec->table[i] - 1) + 1);
+            return;
+        }
+    }
+
+    bytes_put_varint(&rec->out, 2 * (uint64_t)size + 2);
+    for (size_t i = 0; i < size; ++i) da_append(&rec->out, bytes[i]);
+    uint32_t id = grid_record_add_term(rec, bytes, size);
+
+    if (2 * grid_record_term_count(rec) >= rec->table_size) {
+        free(rec->table);
+        rec->table_size *= 2;
+        rec->table = calloc(rec->table_size, sizeof(*rec->table));
+        assert(rec->table != NULL && "Buy more RAM lol");
+        for (uint32_t j = 0; j < grid_record_term_count(rec); ++j) grid_record_insert(rec, j);
+    } else {
+        grid_record_insert(rec, id);
+    }
+}
+
+static bool grid_record_get_term(Grid_Record *rec, uint64_t code, uint32_t *id)
+{
+    if (code & 1) {
+        *id = (uint32_t)(code / 2);
+        return code / 2 < grid_record_term_count(rec);
+    }
+    if (code < 2) return false;
+    long long pos = file_tell(rec->file);
+    if (pos < 0 || code / 2 - 1 > rec->file_size - (uint64_t)pos) return false;
+    size_t size = (size_t)(code / 2 - 1);
+    rec->out.count = 0;
+    da_reserve(&rec->out, size);
+    if (fread(rec->out.items, 1, size, rec->file) != size) return false;
+    *id = grid_record_add_term(rec, rec->out.items, size);
+    return true;
+}
+
+static bool grid_record_term_expr(Grid_Record *rec, Lamb_Context *ctx, uint32_t id, Expr_Index *expr)
+{
+    const uint8_t *p = &rec->terms.items[rec->offsets.items[id]];
+    const uint8_t *end = &rec->terms.items[rec->offsets.items[id + 1]];
+    return expr_decode(ctx, &p, end, expr) && p == end;
+}
+
+static void grid_record_free(Grid_Record *rec)
+{
+    if (rec->file) fclose(rec->file);
+    for (size_t i = 0; i < rec->segments.count; ++i) {
+        free(rec->segments.items[i].bytes.items);
+        free(rec->segments.items[i].events.items);
+    }
+    free(rec->segments.items);
+    free(rec->terms.items);
+    free(rec->offsets.items);
+    free(rec->table);
+    free(rec->out.items);
+    free(rec);
+}
+
+static Grid_Record *grid_record_new(FILE *file, bool replay)
+{
+    Grid_Record *rec = calloc(1, sizeof(*rec));
+    assert(rec != NULL && "Buy more RAM lol");
+    rec->file = file;
+    rec->replay = replay;
+    rec->table_size = 1024;
+    rec->table = calloc(rec->table_size, sizeof(*rec->table));
+    assert(rec->table != NULL && "Buy more RAM lol");
+    return rec;
+}
+
+bool grid_record_start(Grid *g, const char *path, uint64_t seed, size_t eval_steps, size_t max_mass)
+{
+    grid_record_stop(g);
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "ERROR: Could not open %s for writing: %s\n", path, strerror(errno));
+        return false;
+    }
+    Grid_Record *rec = grid_record_new(f, false);
+    rec->info.seed = seed;
+    rec->info.eval_steps = eval_steps;
+    rec->info.max_mass = max_mass;
+    rec->info.tiled = grid_tiled(g);
+    rec->info.blocked = g->blocked;
+    rec->info.sparse = g->sparse;
+    rec->info.kinetic = g->kinetic != NULL;
+
+    Lamb_Context *ctx = g->ctx;
+    Bytes *out = &rec->out;
+    for (const char *c = GRID_RECORD_MAGIC; *c; ++c) da_append(out, (uint8_t)*c);
+    bytes_put_varint(out, seed);
+    for (size_t i = 0; i < 4; ++i) bytes_put_varint(out, ctx->rng.s[i]);
+    bytes_put_varint(out, ctx->fresh_counter);
+    bytes_put_varint(out, (uint64_t)g->width);
+    bytes_put_varint(out, (uint64_t)g->height);
+    bytes_put_varint(out, (uint64_t)rec->info.tiled | (uint64_t)rec->info.blocked << 1 | (uint64_t)rec->info.sparse << 2 |
+                          (uint64_t)rec->info.kinetic << 3);
+    bytes_put_varint(out, eval_steps);
+    bytes_put_varint(out, max_mass);
+
+    // In g->active order, which decides the sweep order
+    bytes_put_varint(out, (uint64_t)g->active.count);
+    Bytes term = {0};
+    for (size_t j = 0; j < g->active.count; ++j) {
+        int i = g->active.items[j];
+        Cell *cell = &g->cells[i];
+        int x, y;
+        grid_xy(g, i, &x, &y);
+        bytes_put_varint(out, (uint64_t)y * (uint64_t)g->width + (uint64_t)x);
+        bytes_put_varint(out, (uint64_t)cell->age);
+        bytes_put_varint(out, (uint64_t)g->info[i].generation);
+        term.count = 0;
+        expr_encode(ctx, cell_atom(cell), &term);
+        grid_record_put_term(rec, term.items, term.count);
+    }
+    free(term.items);
+    fwrite(out->items, 1, out->count, f);
+
+    g->record = rec;
+    return true;
+}
+
+bool grid_replay_start(Grid *g, Lamb_Context *ctx, const char *path, bool fast, Grid_Record_Info *info)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "ERROR: Could not open %s for reading: %s\n", path, strerror(errno));
+        return false;
+    }
+    Grid_Record *rec = grid_record_new(f, true);
+    rec->fast = fast;
+    long long size = fseek(f, 0, SEEK_END) == 0 ? file_tell(f) : -1;
+    if (size < 0 || fseek(f, 0, SEEK_SET) != 0) {
+        fprintf(stderr, "ERROR: Could not read %s: %s\n", path, strerror(errno));
+        grid_record_free(rec);
+        return false;
+    }
+    rec->file_size = (uint64_t)size;
+
+    char magic[sizeof(GRID_RECORD_MAGIC) - 1];
+    uint64_t header[12];
+    bool ok = fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+              memcmp(magic, GRID_RECORD_MAGIC, sizeof(magic)) == 0;
+    for (size_t i = 0; ok && i < sizeof(header) / sizeof(header[0]); ++i) ok = file_get_varint(f, &header[i]);
+    uint64_t width = ok ? header[6] : 0, height = ok ? header[7] : 0;
+    if (!ok || width == 0 || height == 0 || width > INT_MAX || height > INT_MAX || header[11] > INT_MAX ||
+        (!(header[8] & 4) && width * height > INT_MAX) || header[11] > width * height) {
+        fprintf(stderr, "ERROR: %s is not a grid event log\n", path);
+        grid_record_free(rec);
+        return false;
+    }
+    rec->info.seed = header[0];
+    rec->info.tiled = (header[8] & 1) != 0;
+    rec->info.blocked = (header[8] & 2) != 0;
+    rec->info.sparse = (header[8] & 4) != 0;
+    rec->info.kinetic = (header[8] & 8) != 0;
+    rec->info.eval_steps = (size_t)header[9];
+    rec->info.max_mass = (size_t)header[10];
+
+    // Built aside, so a corrupt log leaves g as it was
+    Grid scratch = {0};
+    void (*roots)(Lamb_Context *, Gc_Visit) = ctx->roots;
+    void *roots_data = ctx->roots_data;
+    grid_set_layout(&scratch, rec->info.blocked);
+    grid_set_sparse(&scratch, rec->info.sparse);
+    grid_set_kinetic(&scratch, rec->info.kinetic);
+    grid_init(&scratch, ctx, (int)width, (int)height);
+    for (uint64_t n = 0; n < header[11]; ++n) {
+        uint64_t position, age, generation, code;
+        uint32_t id;
+        Expr_Index atom;
+        int index = -1;
+        if (file_get_varint(f, &position) && position < width * height) {
+            index = grid_idx(&scratch, (int)(position % width), (int)(position / width));
+        }
+        if (index < 0 || !file_get_varint(f, &age) || !file_get_varint(f, &generation) ||
+            !file_get_varint(f, &code) || scratch.cells[index].occupied ||
+            !grid_record_get_term(rec, code, &id) || !grid_record_term_expr(rec, ctx, id, &atom)) {
+            fprintf(stderr, "ERROR: %s: corrupt starting grid\n", path);
+            grid_record_free(rec);
+            grid_free(&scratch);
+            ctx->roots = roots;
+            ctx->roots_data = roots_data;
+            return false;
+        }
+        Cell *cell = &scratch.cells[index];
+        cell_set_atom(cell, atom);
+        gc_remember(ctx, atom);
+        scratch.info[index].hash = expr_hash(ctx, atom);
+        histogram_add(&scratch.histogram, scratch.info[index].hash);
+        cell->occupied = true;
+        cell->age = (uint16_t)age;
+        scratch.info[index].generation = (int)generation;
+        scratch.info[index].cache_valid = false;
+        grid_active_add(&scratch, index);
+        scratch.population++;
+    }
+
+    grid_free(g);  // Ends its record, if any
+    scratch.workers = g->workers;
+    *g = scratch;
+    ctx->roots_data = g;
+    for (size_t i = 0; i < 4; ++i) ctx->rng.s[i] = header[1 + i];
+    ctx->fresh_counter = (size_t)header[5];
+
+    // Same schedule as the recording (any thread count will do for tiles)
+    rec->workers = g->workers;
+    if (!rec->info.tiled) g->workers = NULL;
+    else if (!g->workers) grid_set_threads(g, 2);
+
+    g->record = rec;
+    if (info) *info = rec->info;
+    return true;
+}
+
+bool grid_replay_pending(Grid *g)
+{
+    Grid_Record *rec = g->record;
+    if (!rec || !rec->replay || rec->failed) return false;
+    int c = fgetc(rec->file);
+    if (c == EOF) return false;
+    ungetc(c, rec->file);
+    return true;
+}
+
+long grid_replay_mismatches(Grid *g)
+{
+    return g->record ? g->record->mismatches : 0;
+}
+
+void grid_record_stop(Grid *g)
+{
+    Grid_Record *rec = g->record;
+    if (!rec) return;
+    g->record = NULL;
+    if (rec->replay && g->workers != rec->workers) {
+        grid_set_threads(g, 1);
+        g->workers = rec->workers;
+    }
+    grid_record_free(rec);
+}
+
+static void grid_record_fail(Grid_Record *rec)
+{
+    if (!rec->failed) fprintf(stderr, "ERROR: grid event log ends early or is corrupt\n");
+    rec->failed = true;
+}
+
+static void grid_record_begin_step(Grid *g)
+{
+    Grid_Record *rec = g->record;
+    if (!rec->replay) {
+        fputc(GRID_RECORD_STEP, rec->file);
+    } else if (!rec->failed && fgetc(rec->file) != GRID_RECORD_STEP) {
+        grid_record_fail(rec);
+    }
+}
+
+static void grid_record_end_step(Grid *g)
+{
+    Grid_Record *rec = g->record;
+    if (!rec->replay) {
+        file_put_varint(rec->file, (uint64_t)g->population);
+        file_put_varint(rec->file, (uint64_t)g->reactions_success);
+        return;
+    }
+    uint64_t population, reactions;
+    if (rec->failed || !file_get_varint(rec->file, &population) || !file_get_varint(rec->file, &reactions)) {
+        grid_record_fail(rec);
+    } else if (population != (uint64_t)g->population || reactions != (uint64_t)g->reactions_success) {
+        rec->mismatches++;
+    }
+}
+
+// Before a phase of `count` segments: empty them, or load them from the log
+static void grid_record_begin(Grid *g, size_t count)
+{
+    Grid_Record *rec = g->record;
+    while (rec->segments.count < count) {
+        Grid_Segment segment = {0};
+        da_append(&rec->segments, segment);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        Grid_Segment *segment = &rec->segments.items[i];
+        segment->bytes.count = 0;
+        segment->count = 0;
+        segment->events.count = 0;
+        segment->next = 0;
+    }
+    if (!rec->replay || rec->failed) return;
+
+    for (size_t i = 0; i < count; ++i) {
+        Grid_Segment *segment = &rec->segments.items[i];
+        uint64_t n;
+        if (!file_get_varint(rec->file, &n)) goto fail;
+        for (uint64_t j = 0; j < n; ++j) {
+            Grid_Event event = {0};
+            uint64_t code;
+            if (!file_get_varint(rec->file, &event.fresh) || !file_get_varint(rec->file, &code)) goto fail;
+            if (code != 0) {
+                if (!grid_record_get_term(rec, code, &event.result)) goto fail;
+                event.done = true;
+            }
+            da_append(&segment->events, event);
+        }
+    }
+    return;
+
+fail:
+    grid_record_fail(rec);
+    for (size_t i = 0; i < count; ++i) rec->segments.items[i].events.count = 0;
+}
+
+// After the phase: log the segments, or count logged reactions that didn't happen
+static void grid_record_end(Grid *g, size_t count)
+{
+    Grid_Record *rec = g->record;
+    if (rec->replay) {
+        for (size_t i = 0; i < count; ++i) {
+            Grid_Segment *segment = &rec->segments.items[i];
+            rec->mismatches += (long)(segment->events.count - segment->next);
+        }
+        return;
+    }
+
+    rec->out.count = 0;
+    for (size_t i = 0; i < count; ++i) {
+        Grid_Segment *segment = &rec->segments.items[i];
+        const uint8_t *p = segment->bytes.items;
+        const uint8_t *end = p + segment->bytes.count;
+        bytes_put_varint(&rec->out, segment->count);
+        while (p < end) {
+            uint64_t fresh, size;
+            bytes_get_varint(&p, end, &fresh);
+            bytes_get_varint(&p, end, &size);
+            bytes_put_varint(&rec->out, fresh);
+            if (size == 0) {
+                bytes_put_varint(&rec->out, 0);
+            } else {
+                grid_record_put_term(rec, p, (size_t)size - 1);
+                p += size - 1;
+            }
+        }
+    }
+    fwrite(rec->out.items, 1, rec->out.count, rec->file);
+}
+
+// Sweep order: a keyed pseudo-random permutation of [0, n), so a step needs
+// no shuffle. Four Feistel rounds over the smallest 2^(2k) >= n, walking the
+// cycle until the value falls below n (less than 4 rounds trips on average).
+typedef struct {
+    uint32_t n;
+    uint32_t half_bits;
+    uint32_t half_mask;
+    uint32_t keys[4];
+} Grid_Sweep;
+
+static void grid_sweep_init(Grid_Sweep *sweep, size_t n, Lamb_Rng *rng)
+{
+    assert(n <= UINT32_MAX);
+    sweep->n = (uint32_t)n;
+    sweep->half_bits = 1;
+    while (((uint64_t)1 << 2 * sweep->half_bits) < n) sweep->half_bits++;
+    sweep->half_mask = ((uint32_t)1 << sweep->half_bits) - 1;
+    uint64_t a = rng_next(rng), b = rng_next(rng);
+    sweep->keys[0] = (uint32_t)a;
+    sweep->keys[1] = (uint32_t)(a >> 32);
+    sweep->keys[2] = (uint32_t)b;
+    sweep->keys[3] = (uint32_t)(b >> 32);
+}
+
+static uint32_t grid_sweep_at(const Grid_Sweep *sweep, uint32_t i)
+{
+    do {
+        uint32_t left = i >> sweep->half_bits, right = i & sweep->half_mask;
+        for (size_t k = 0; k < 4; ++k) {
+            uint32_t f = (right ^ sweep->keys[k]) * 0x9E3779B1u;
+            f ^= f >> 15;
+            f *= 0x85EBCA77u;
+            f ^= f >> 13;
+            uint32_t next = (left ^ f) & sweep->half_mask;
+            left = right;
+            right = next;
+        }
+        i = left << sweep->half_bits | right;
+    } while (i >= sweep->n);
+    return i;
+}
+
+// A cell of the species appeared (+1) or went away (-1)
+typedef struct {
+    uint64_t hash;
+    int delta;
+} Grid_Species_Delta;
+
+// Who is updating cells right now. The serial schedule works straight in the
+// grid's heap; parallel workers build terms in a private heap and hand them
+// over in grid_workers_commit(), since a heap only takes one writer.
+typedef struct {
+    Lamb_Context *ctx;        // Heap the new terms go to (g->ctx when serial)
+    Lamb_Context scratch;     // Private heap of a parallel worker
+    // Cells the worker updates, and where each block starts among them
+    struct {
+        int *items;
+        size_t count;
+        size_t capacity;
+    } order;
+    struct {
+        size_t *items;
+        size_t count;
+        size_t capacity;
+    } runs;
+    // Cells that got a term of ctx this phase
+    struct {
+        int *items;
+        size_t count;
+        size_t capacity;
+    } touched;
+    // Atoms of g->ctx the cells stopped pointing at
+    struct {
+        Expr_Index *items;
+        size_t count;
+        size_t capacity;
+    } dropped;
+    // Statistics, folded into the grid by grid_worker_flush()
+    int population;
+    long reactions_success;
+    long reactions_diverged;
+    long movements;
+    long deaths_age;
+    long cosmic_spawns;
+    // Changes to g->active as (from, to) pairs (see grid_active_apply())
+    struct {
+        int *items;
+        size_t count;
+        size_t capacity;
+    } journal;
+    // Changes to g->histogram (see grid_species_changed())
+    struct {
+        Grid_Species_Delta *items;
+        size_t count;
+        size_t capacity;
+    } species;
+    // Event log of the cells being updated (see grid_react())
+    Grid_Segment *segment;
+    Bytes encoded;
+    long mismatches;
+} Grid_Worker;
+
+// The atom of a cell as a term of the worker's heap
+static Expr_Index grid_cell_atom(Grid *g, Grid_Worker *w, int idx)
+{
+    if (w->ctx == g->ctx || g->cells[idx].local) return cell_atom(&g->cells[idx]);
+    return expr_copy(w->ctx, g->ctx, cell_atom(&g->cells[idx]), SIZE_MAX);
+}
+
+static void grid_species_changed(Grid *g, Grid_Worker *w, uint64_t hash, int delta)
+{
+    if (w->ctx != g->ctx) {
+        Grid_Species_Delta change = { .hash = hash, .delta = delta };
+        da_append(&w->species, change);
+    } else if (delta > 0) {
+        histogram_add(&g->histogram, hash);
+    } else {
+        histogram_remove(&g->histogram, hash);
+    }
+}
+
+// The cell is about to die or get a new atom
+static void grid_cell_drop(Grid *g, Grid_Worker *w, int idx)
+{
+    grid_species_changed(g, w, g->info[idx].hash, -1);
+    if (w->ctx == g->ctx) {
+        gc_forget(g->ctx, cell_atom(&g->cells[idx]));
+    } else if (!g->cells[idx].local) {
+        da_append(&w->dropped, cell_atom(&g->cells[idx]));
+    }
+    g->cells[idx].local = false;
+}
+
+// Hashes the atom while its heap belongs to the caller, so nobody else ever
+// writes its nodes
+static void grid_cell_store(Grid *g, Grid_Worker *w, int idx, Expr_Index atom)
+{
+    cell_set_atom(&g->cells[idx], atom);
+    g->info[idx].hash = expr_hash(w->ctx, atom);
+    grid_species_changed(g, w, g->info[idx].hash, +1);
+    if (w->ctx == g->ctx) {
+        gc_remember(g->ctx, atom);
+    } else {
+        g->cells[idx].local = true;
+        da_append(&w->touched, idx);
+    }
+}
+
+static void grid_cell_moved(Grid *g, Grid_Worker *w, int from, int to)
+{
+    if (w->ctx == g->ctx) {
+        grid_active_apply(g, from, to);
+    } else {
+        da_append(&w->journal, from);
+        da_append(&w->journal, to);
+    }
+}
+
+static void grid_worker_flush(Grid *g, Grid_Worker *w)
+{
+    g->population += w->population;
+    g->reactions_success += w->reactions_success;
+    g->reactions_diverged += w->reactions_diverged;
+    g->movements += w->movements;
+    g->deaths_age += w->deaths_age;
+    g->cosmic_spawns += w->cosmic_spawns;
+    w->population = 0;
+    w->reactions_success = 0;
+    w->reactions_diverged = 0;
+    w->movements = 0;
+    w->deaths_age = 0;
+    w->cosmic_spawns = 0;
+    if (g->record) g->record->mismatches += w->mismatches;
+    w->mismatches = 0;
+}
+
+// A reaction of the worker: A applied to B. With a record, the outcome is
+// logged, or checked against the log, or in a fast replay taken from it.
+static Eval_Result grid_react(Grid *g, Grid_Worker *w, Expr_Index A, Expr_Index B, Expr_Index *result, size_t eval_steps, size_t max_mass)
+{
+    Lamb_Context *ctx = w->ctx;
+    Grid_Record *rec = g->record;
+    if (!rec) return eval_bounded(ctx, app(ctx, A, B), result, eval_steps, max_mass);
+
+    Grid_Segment *segment = w->segment;
+    Grid_Event *event = NULL;
+    if (rec->replay && segment->next < segment->events.count) {
+        event = &segment->events.items[segment->next++];
+    }
+    if (event && rec->fast) {
+        ctx->fresh_counter += (size_t)event->fresh;
+        if (!event->done) return EVAL_LIMIT;
+        if (grid_record_term_expr(rec, ctx, event->result, result)) return EVAL_DONE;
+        w->mismatches++;
+        return EVAL_LIMIT;
+    }
+
+    size_t fresh_before = ctx->fresh_counter;
+    Eval_Result res = eval_bounded(ctx, app(ctx, A, B), result, eval_steps, max_mass);
+    uint64_t fresh = ctx->fresh_counter - fresh_before;
+
+    w->encoded.count = 0;
+    if (res == EVAL_DONE) expr_encode(ctx, *result, &w->encoded);
+    if (!rec->replay) {
+        bytes_put_varint(&segment->bytes, fresh);
+        bytes_put_varint(&segment->bytes, res == EVAL_DONE ? w->encoded.count + 1 : 0);
+        for (size_t i = 0; i < w->encoded.count; ++i) da_append(&segment->bytes, w->encoded.items[i]);
+        segment->count++;
+    } else if (!event || event->fresh != fresh || event->done != (res == EVAL_DONE) ||
+               (event->done && !grid_record_term_is(rec, event->result, w->encoded.items, w->encoded.count))) {
+        w->mismatches++;
+    }
+    return res;
+}
+
+// Cosmic ray on an empty cell: spawns an SKI combinator, the "chemical"
+// building block
+static void grid_cosmic_ray(Grid *g, Grid_Worker *w, int idx)
+{
+    grid_cell_store(g, w, idx, generate_rich_combinator(w->ctx, 0, 3, NULL, 0));
+    g->cells[idx].occupied = true;
+    g->cells[idx].age = 0;
+    g->info[idx].generation = 0;
+    g->info[idx].cache_valid = false;  // Invalidate cache
+    grid_cell_moved(g, w, -1, idx);
+    w->population++;
+    w->cosmic_spawns++;
+}
+
+// Every empty cell of the rectangle gets a cosmic ray with probability
+// COSMIC_RAY_RATE / 100000. Jumps from hit to hit with geometric gaps rather
+// than rolling the die for every cell.
+static void grid_cosmic_rays(Grid *g, Grid_Worker *w, int x0, int y0, int x1, int y1)
+{
+    double log_miss = log1p(-COSMIC_RAY_RATE / 100000.0);
+    long width = x1 - x0;
+    long area = width * (y1 - y0);
+    for (long i = -1;;) {
+        double gap = floor(log1p(-rng_double(&w->ctx->rng)) / log_miss);
+        if (gap >= (double)(area - i - 1)) break;
+        i += 1 + (long)gap;
+        int idx = grid_idx(g, x0 + (int)(i % width), y0 + (int)(i / width));
+        if (!g->cells[idx].occupied) grid_cosmic_ray(g, w, idx);
+    }
+}
+
+// Same over the tiles of a sparse world that were allocated when the step
+// began, which keeps the void empty
+static void grid_cosmic_rays_sparse(Grid *g, Grid_Worker *w)
+{
+    double log_miss = log1p(-COSMIC_RAY_RATE / 100000.0);
+    long area = (long)g->live.count * GRID_SPARSE_AREA;
+    for (long i = -1;;) {
+        double gap = floor(log1p(-rng_double(&w->ctx->rng)) / log_miss);
+        if (gap >= (double)(area - i - 1)) break;
+        i += 1 + (long)gap;
+        int tile = g->live.items[i / GRID_SPARSE_AREA], p = (int)(i % GRID_SPARSE_AREA);
+        int x = tile % g->tiles_x * GRID_SPARSE_TILE + p % GRID_SPARSE_TILE;
+        int y = tile / g->tiles_x * GRID_SPARSE_TILE + p / GRID_SPARSE_TILE;
+        if (x >= g->width || y >= g->height) continue;  // Edge tile sticking out of the torus
+        int idx = g->tile_slot[tile] * GRID_SPARSE_AREA + p;
+        if (!g->cells[idx].occupied) grid_cosmic_ray(g, w, idx);
+    }
+}
+
 // The heart of the spatial simulation - METABOLIC MODEL
 // 1. Catalytic: A applies to B -> C. A survives, B becomes C.
 // 2. Aging: Every cell has age, dies at MAX_AGE.
-// 3. Cosmic Rays: Spontaneous generation in empty slots.
-void grid_step(Grid *g, Bindings bindings, size_t eval_steps, size_t max_mass) {
-    int total = g->width * g->height;
-    
-    // 1. Create a shuffled list of indices (Fisher-Yates) - Asynchronous Cellular Automata
-    int *indices = malloc((size_t)total * sizeof(int));
-    for (int i = 0; i < total; ++i) indices[i] = i;
+// 3. Cosmic Rays: Spontaneous generation in empty slots (grid_cosmic_rays()).
+// Touches the cell and at most one of its von Neumann neighbours. A cell
+// emptied since the sweep began is skipped, and so is a creature that moved
+// onto a cell still due in this sweep after having had its own turn.
+static void grid_update_cell(Grid *g, Grid_Worker *w, int curr_idx, size_t eval_steps, size_t max_mass)
+{
+    Lamb_Context *ctx = w->ctx;
+    if (!g->cells[curr_idx].occupied) return;
+    if (!g->kinetic) {
+        uint32_t stamp = (uint32_t)g->steps + 1;
+        if (g->info[curr_idx].swept == stamp) return;
+        g->info[curr_idx].swept = stamp;
+    }
+
+    // --- ENTROPY & DEATH (Aging) ---
+    g->cells[curr_idx].age++;
+
+    // Death from old age
+    if (g->cells[curr_idx].age > MAX_AGE) {
+        grid_cell_drop(g, w, curr_idx);
+        g->cells[curr_idx].occupied = false;
+        g->info[curr_idx].cache_valid = false;  // Invalidate cache
+        grid_cell_moved(g, w, curr_idx, -1);
+        w->population--;
+        w->deaths_age++;
+        return; // Slot is now empty, skip to next
+    }
+
+    // --- PHYSICS (Movement or Interaction) ---
     
-    // Fisher-Yates shuffle
-    for (int i = total - 1; i > 0; i--) {
-        int j = rand() % (i + 1);
-        int temp = indices[i];
-        indices[i] = indices[j];
-        indices[j] = temp;
+    // Pick a random direction: 0:N, 1:E, 2:S, 3:W
+    int dir = (int)rng_below(&ctx->rng, 4);
+    int target_idx = grid_neighbor(g, curr_idx, dir);
+
+    // RULE 1: MOVEMENT - if target is empty, random walk
+    if (!g->cells[target_idx].occupied) {
+        g->cells[target_idx] = g->cells[curr_idx];
+        g->info[target_idx] = g->info[curr_idx];
+        if (g->cells[target_idx].local) da_append(&w->touched, target_idx);
+        g->cells[curr_idx].occupied = false;
+        g->cells[curr_idx].local = false;
+        g->info[curr_idx].cache_valid = false;  // Source cell is now empty
+        // Target inherits cache from source (no recomputation needed)
+        grid_cell_moved(g, w, curr_idx, target_idx);
+        w->movements++;
+    } 
+    // RULE 2: CATALYTIC INTERACTION - A applies to B, A survives, B becomes result
+    else {
+        Expr_Index A = grid_cell_atom(g, w, curr_idx);
+        Expr_Index B = grid_cell_atom(g, w, target_idx);
+        Expr_Index result;
+
+        // Run bounded evaluation
+        Eval_Result res = grid_react(g, w, A, B, &result, eval_steps, max_mass);
+
+        if (res == EVAL_DONE) {
+            // Successful catalysis: A survives, B transforms into result
+            // A stays where it is (catalytic) - rejuvenated by successful reaction
+            // B becomes the result (mutation)
+            g->cells[curr_idx].age = 0;  // Catalyst rejuvenated by successful work
+            g->info[curr_idx].cache_valid = false;  // Age changed, invalidate
+            grid_cell_drop(g, w, target_idx);
+            grid_cell_store(g, w, target_idx, result);
+            g->cells[target_idx].age = 0;  // Rejuvenate: it's a new creature
+            g->info[target_idx].generation++;
+            g->info[target_idx].cache_valid = false;  // Invalidate cache - new expression
+            w->reactions_success++;
+        } else {
+            // Divergence/Explosion: The victim B dies from instability
+            // A survives (it was the catalyst)
+            grid_cell_drop(g, w, target_idx);
+            g->cells[target_idx].occupied = false;
+            g->info[target_idx].cache_valid = false;
+            grid_cell_moved(g, w, target_idx, -1);
+            w->population--;
+            w->reactions_diverged++;
+        }
     }
+}
 
-    // 2. Process cells in shuffled order
-    for (int i = 0; i < total; ++i) {
-        int curr_idx = indices[i];
-        
-        // --- ENTROPY & DEATH (Aging) ---
-        if (g->cells[curr_idx].occupied) {
-            g->cells[curr_idx].age++;
-            
-            // Death from old age
-            if (g->cells[curr_idx].age > MAX_AGE) {
-                g->cells[curr_idx].occupied = false;
-                g->cells[curr_idx].cache_valid = false;  // Invalidate cache
-                g->population--;
-                g->deaths_age++;
-                continue; // Slot is now empty, skip to next
-            }
+// Update cells[starts[0]..starts[runs]], one run after another in random order
+// and the cells of a run in random order too. Runs are the storage blocks in
+// the blocked layout, so a block and its halo stay in cache while it's swept.
+static void grid_sweep_cells(Grid *g, Grid_Worker *w, const int *cells, const size_t *starts, size_t runs,
+                             size_t eval_steps, size_t max_mass)
+{
+    Grid_Sweep outer, inner;
+    grid_sweep_init(&outer, runs, &w->ctx->rng);
+    for (uint32_t k = 0; k < outer.n; ++k) {
+        uint32_t run = grid_sweep_at(&outer, k);
+        const int *first = cells + starts[run];
+        size_t count = starts[run + 1] - starts[run];
+        if (count == 0) continue;
+        grid_sweep_init(&inner, count, &w->ctx->rng);
+        for (uint32_t i = 0; i < inner.n; ++i) {
+            grid_update_cell(g, w, first[grid_sweep_at(&inner, i)], eval_steps, max_mass);
         }
-        
-        // --- COSMIC RAYS (Spontaneous Generation) ---
-        // Spawns SKI combinators only - the "chemical" building blocks
-        if (!g->cells[curr_idx].occupied) {
-            if ((rand() % 100000) < COSMIC_RAY_RATE) {
-                g->cells[curr_idx].atom = generate_rich_combinator(0, 3, NULL, 0);
-                g->cells[curr_idx].occupied = true;
-                g->cells[curr_idx].age = 0;
-                g->cells[curr_idx].generation = 0;
-                g->cells[curr_idx].cache_valid = false;  // Invalidate cache
-                g->population++;
-                g->cosmic_spawns++;
-            }
-            continue; // Empty cell processed, move on
+    }
+}
+
+// ============================================================================
+// PARALLEL UPDATE (checkerboard tiles)
+// ============================================================================
+
+// The torus is cut into an even number of tiles along both axes, at least 2
+// cells wide, and colored by the parity of their coordinates. Tiles of one
+// color share no cell and no neighbour, so a phase updates them all at once,
+// each in a random sweep order like the serial schedule. A step runs the four
+// colors in random order over the occupied cells of the step's start, so
+// every creature still gets one update per step.
+// Each tile draws from its own stream, seeded from the phase seed and the
+// tile index, whichever worker happens to run it.
+#define GRID_TILE 8
+
+typedef struct {
+    int cell;
+    size_t worker;
+} Grid_Commit;
+
+// A tile's changes to g->active, journal[start..end] of the worker that ran it
+typedef struct {
+    size_t worker;
+    size_t start;
+    size_t end;
+} Grid_Tile_Journal;
+
+struct Grid_Workers {
+    Thread_Pool *pool;
+    Grid_Worker *items;
+    size_t count;
+    struct {
+        Grid_Commit *items;
+        size_t count;
+        size_t capacity;
+    } commits;
+    // Every worker's species changes of the phase
+    struct {
+        Grid_Species_Delta *items;
+        size_t count;
+        size_t capacity;
+    } species;
+    // Where every tile of the phase left its journal, so the journals apply
+    // in tile order and g->active doesn't depend on who ran which tile
+    struct {
+        Grid_Tile_Journal *items;
+        size_t count;
+        size_t capacity;
+    } journals;
+    // Tile coordinate of every column and row
+    struct {
+        int *items;
+        size_t count;
+        size_t capacity;
+    } tile_of;
+    // First column of every tile and the width, then the same for rows, so
+    // tile t spans [edge[t], edge[t + 1]) exactly where tile_of says t
+    struct {
+        int *items;
+        size_t count;
+        size_t capacity;
+    } tile_edge;
+    // Occupied cells when the step began, which every phase takes its color of
+    struct {
+        int *items;
+        size_t count;
+        size_t capacity;
+    } snapshot;
+    // Occupied cells of the current color grouped by tile, the tile of index
+    // i owning bucket[tile_start[i]..tile_start[i + 1]]
+    struct {
+        int *items;
+        size_t count;
+        size_t capacity;
+    } bucket;
+    struct {
+        size_t *items;
+        size_t count;
+        size_t capacity;
+    } tile_start;
+    // Current phase
+    int tiles_x;
+    int tiles_y;
+    int color;
+    uint64_t phase_seed;
+    size_t eval_steps;
+    size_t max_mass;
+};
+
+static int grid_tiles_along(int cells)
+{
+    int tiles = (cells / GRID_TILE) & ~1;
+    return tiles < 2 ? 2 : tiles;
+}
+
+static int compare_ints(const void *a, const void *b)
+{
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static void grid_tile_task(void *data, size_t worker, size_t index)
+{
+    Grid *g = data;
+    Grid_Workers *ws = g->workers;
+    Grid_Worker *w = &ws->items[worker];
+
+    // index-th tile of the current color
+    int half_x = ws->tiles_x / 2;
+    int tx = (int)(index % (size_t)half_x) * 2 + (ws->color & 1);
+    int ty = (int)(index / (size_t)half_x) * 2 + (ws->color >> 1);
+    const int *edge_x = ws->tile_edge.items, *edge_y = ws->tile_edge.items + ws->tiles_x + 1;
+    int x0 = edge_x[tx], x1 = edge_x[tx + 1];
+    int y0 = edge_y[ty], y1 = edge_y[ty + 1];
+
+    // Tiles of a phase never combine terms and every term gets fresh grid tags
+    // when committed, so a tile can number its fresh tags from scratch. Keeps
+    // what a tile does independent of the tiles its worker ran before.
+    rng_seed(&w->ctx->rng, ws->phase_seed + index);
+    w->ctx->fresh_counter = SCRATCH_FRESH_TAGS;
+    w->segment = g->record ? &g->record->segments.items[index] : NULL;
+    // The bucket may hold cells emptied by an earlier phase, which are skipped
+    w->order.count = 0;
+    for (size_t i = ws->tile_start.items[index]; i < ws->tile_start.items[index + 1]; ++i) {
+        da_append(&w->order, ws->bucket.items[i]);
+    }
+    qsort(w->order.items, w->order.count, sizeof(int), compare_ints);
+    size_t journal_start = w->journal.count;
+
+    // Sorted, so the cells of a block are next to each other
+    w->runs.count = 0;
+    da_append(&w->runs, 0);
+    for (size_t i = 1; g->blocked && i < w->order.count; ++i) {
+        if (w->order.items[i] / GRID_BLOCK_AREA != w->order.items[i - 1] / GRID_BLOCK_AREA) da_append(&w->runs, i);
+    }
+    da_append(&w->runs, w->order.count);
+    grid_sweep_cells(g, w, w->order.items, w->runs.items, w->runs.count - 1, ws->eval_steps, ws->max_mass);
+    grid_cosmic_rays(g, w, x0, y0, x1, y1);
+    ws->journals.items[index] = (Grid_Tile_Journal){ .worker = worker, .start = journal_start, .end = w->journal.count };
+}
+
+// Group the snapshot cells of the current color by tile (counting sort)
+static void grid_bucket_tiles(Grid *g, size_t tiles)
+{
+    Grid_Workers *ws = g->workers;
+    const int *tile_x = ws->tile_of.items;
+    const int *tile_y = ws->tile_of.items + g->width;
+    int half_x = ws->tiles_x / 2;
+
+    ws->tile_start.count = 0;
+    for (size_t i = 0; i <= tiles; ++i) da_append(&ws->tile_start, 0);
+    size_t *start = ws->tile_start.items;
+    size_t count = 0;
+    for (size_t i = 0; i < ws->snapshot.count; ++i) {
+        int idx = ws->snapshot.items[i], x, y;
+        grid_xy(g, idx, &x, &y);
+        int tx = tile_x[x], ty = tile_y[y];
+        if (((ty & 1) << 1 | (tx & 1)) != ws->color) continue;
+        start[(ty / 2) * half_x + tx / 2 + 1]++;
+        count++;
+    }
+    for (size_t i = 1; i <= tiles; ++i) start[i] += start[i - 1];
+
+    ws->bucket.count = 0;
+    while (ws->bucket.count < count) da_append(&ws->bucket, 0);
+    for (size_t i = 0; i < ws->snapshot.count; ++i) {
+        int idx = ws->snapshot.items[i], x, y;
+        grid_xy(g, idx, &x, &y);
+        int tx = tile_x[x], ty = tile_y[y];
+        if (((ty & 1) << 1 | (tx & 1)) != ws->color) continue;
+        ws->bucket.items[start[(ty / 2) * half_x + tx / 2]++] = idx;
+    }
+    // Every start got moved to the next one's
+    for (size_t i = tiles; i > 0; --i) start[i] = start[i - 1];
+    start[0] = 0;
+}
+
+static int compare_commits(const void *a, const void *b)
+{
+    int x = ((const Grid_Commit *)a)->cell;
+    int y = ((const Grid_Commit *)b)->cell;
+    return (x > y) - (x < y);
+}
+
+static int compare_species_deltas(const void *a, const void *b)
+{
+    const Grid_Species_Delta *x = a, *y = b;
+    if (x->hash != y->hash) return x->hash < y->hash ? -1 : 1;
+    // Births first: a cell may be born and die within the phase
+    return (x->delta < y->delta) - (x->delta > y->delta);
+}
+
+// Move what the workers built this phase into the grid's heap. Goes in cell
+// order, so the grid's fresh tags don't depend on which worker ran which tile.
+// The species changes go in hash order for the same reason: ties for the
+// dominant species are broken by who got there last. The changes to g->active
+// go in tile order, since it's saved in checkpoints.
+static void grid_workers_commit(Grid *g)
+{
+    Grid_Workers *ws = g->workers;
+    ws->commits.count = 0;
+    for (size_t k = 0; k < ws->count; ++k) {
+        Grid_Worker *w = &ws->items[k];
+        for (size_t i = 0; i < w->touched.count; ++i) {
+            Grid_Commit commit = { .cell = w->touched.items[i], .worker = k };
+            da_append(&ws->commits, commit);
+        }
+    }
+    qsort(ws->commits.items, ws->commits.count, sizeof(Grid_Commit), compare_commits);
+
+    for (size_t i = 0; i < ws->commits.count; ++i) {
+        Cell *cell = &g->cells[ws->commits.items[i].cell];
+        if (!cell->local) continue;  // Moved on, died later in the phase or already done
+        cell->local = false;
+        if (!cell->occupied) continue;
+        cell_set_atom(cell, expr_copy(g->ctx, ws->items[ws->commits.items[i].worker].ctx, cell_atom(cell), SCRATCH_FRESH_TAGS));
+        gc_remember(g->ctx, cell_atom(cell));
+    }
+    for (size_t t = 0; t < ws->journals.count; ++t) {
+        Grid_Tile_Journal *tj = &ws->journals.items[t];
+        const int *journal = ws->items[tj->worker].journal.items;
+        for (size_t i = tj->start; i < tj->end; i += 2) {
+            grid_active_apply(g, journal[i], journal[i + 1]);
+        }
+    }
+    for (size_t k = 0; k < ws->count; ++k) {
+        Grid_Worker *w = &ws->items[k];
+        for (size_t i = 0; i < w->dropped.count; ++i) {
+            gc_forget(g->ctx, w->dropped.items[i]);
+        }
+        if (w->species.count > 0) {
+            da_reserve(&ws->species, ws->species.count + w->species.count);
+            memcpy(&ws->species.items[ws->species.count], w->species.items, w->species.count * sizeof(Grid_Species_Delta));
+            ws->species.count += w->species.count;
         }
+        w->touched.count = 0;
+        w->dropped.count = 0;
+        w->journal.count = 0;
+        w->species.count = 0;
+        gc_reset(w->ctx);
+        grid_worker_flush(g, w);
+    }
+    qsort(ws->species.items, ws->species.count, sizeof(Grid_Species_Delta), compare_species_deltas);
+    for (size_t i = 0; i < ws->species.count; ++i) {
+        if (ws->species.items[i].delta > 0) {
+            histogram_add(&g->histogram, ws->species.items[i].hash);
+        } else {
+            histogram_remove(&g->histogram, ws->species.items[i].hash);
+        }
+    }
+    ws->species.count = 0;
+}
 
-        // --- PHYSICS (Movement or Interaction) ---
-        
-        // Calculate 2D coords from linear index
-        int cx = curr_idx % g->width;
-        int cy = curr_idx / g->width;
+// Cut cells columns (or rows) into tiles of nearly equal size, appending to
+// tile_of and tile_edge
+static void grid_cut_tiles(Grid_Workers *ws, int cells, int tiles)
+{
+    for (int t = 0; t < tiles; ++t) {
+        int x0 = (int)((long long)t * cells / tiles), x1 = (int)((long long)(t + 1) * cells / tiles);
+        da_append(&ws->tile_edge, x0);
+        for (int x = x0; x < x1; ++x) da_append(&ws->tile_of, t);
+    }
+    da_append(&ws->tile_edge, cells);
+}
 
-        // Pick a random direction: 0:N, 1:E, 2:S, 3:W
-        int dir = rand() % 4;
-        int tx = cx, ty = cy;
-        
-        switch(dir) {
-            case 0: ty--; break; // N
-            case 1: tx++; break; // E
-            case 2: ty++; break; // S
-            case 3: tx--; break; // W
+static void grid_step_tiles(Grid *g, size_t eval_steps, size_t max_mass)
+{
+    Grid_Workers *ws = g->workers;
+    ws->tiles_x = grid_tiles_along(g->width);
+    ws->tiles_y = grid_tiles_along(g->height);
+    ws->eval_steps = eval_steps;
+    ws->max_mass = max_mass;
+    ws->tile_of.count = 0;
+    ws->tile_edge.count = 0;
+    grid_cut_tiles(ws, g->width, ws->tiles_x);
+    grid_cut_tiles(ws, g->height, ws->tiles_y);
+
+    // Creatures that move into a later color's tile wait for the next step
+    ws->snapshot.count = 0;
+    da_reserve(&ws->snapshot, g->active.count);
+    if (g->active.count > 0) memcpy(ws->snapshot.items, g->active.items, g->active.count * sizeof(int));
+    ws->snapshot.count = g->active.count;
+
+    int colors[4] = {0, 1, 2, 3};
+    for (int i = 3; i > 0; --i) {
+        int j = (int)rng_below(&g->ctx->rng, (uint32_t)(i + 1));
+        int temp = colors[i];
+        colors[i] = colors[j];
+        colors[j] = temp;
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        ws->color = colors[i];
+        ws->phase_seed = rng_next(&g->ctx->rng);
+        size_t tiles = (size_t)(ws->tiles_x / 2 * ws->tiles_y / 2);
+        grid_bucket_tiles(g, tiles);
+        da_reserve(&ws->journals, tiles);
+        ws->journals.count = tiles;
+        if (g->record) grid_record_begin(g, tiles);
+        pool_run(ws->pool, tiles, grid_tile_task, g);
+        grid_workers_commit(g);
+        if (g->record) grid_record_end(g, tiles);
+    }
+}
+
+void grid_set_threads(Grid *g, int threads)
+{
+    Grid_Workers *ws = g->workers;
+    if (ws) {
+        pool_free(ws->pool);
+        for (size_t i = 0; i < ws->count; ++i) {
+            free(ws->items[i].order.items);
+            free(ws->items[i].runs.items);
+            free(ws->items[i].touched.items);
+            free(ws->items[i].dropped.items);
+            free(ws->items[i].journal.items);
+            free(ws->items[i].species.items);
+            free(ws->items[i].encoded.items);
+            lamb_context_free(&ws->items[i].scratch);
         }
-        
-        int target_idx = grid_idx(g, tx, ty);
-
-        // RULE 1: MOVEMENT - if target is empty, random walk
-        if (!g->cells[target_idx].occupied) {
-            g->cells[target_idx] = g->cells[curr_idx];
-            g->cells[curr_idx].occupied = false;
-            g->cells[curr_idx].cache_valid = false;  // Source cell is now empty
-            // Target inherits cache from source (no recomputation needed)
-            g->movements++;
-        } 
-        // RULE 2: CATALYTIC INTERACTION - A applies to B, A survives, B becomes result
-        else {
-            Expr_Index A = g->cells[curr_idx].atom;
-            Expr_Index B = g->cells[target_idx].atom;
-            Expr_Index result;
-
-            // Run bounded evaluation
-            Eval_Result res = eval_bounded(app(A, B), &result, eval_steps, max_mass);
-
-            if (res == EVAL_DONE) {
-                // Successful catalysis: A survives, B transforms into result
-                // A stays where it is (catalytic) - rejuvenated by successful reaction
-                // B becomes the result (mutation)
-                g->cells[curr_idx].age = 0;  // Catalyst rejuvenated by successful work
-                g->cells[curr_idx].cache_valid = false;  // Age changed, invalidate
-                g->cells[target_idx].atom = result;
-                g->cells[target_idx].age = 0;  // Rejuvenate: it's a new creature
-                g->cells[target_idx].generation++;
-                g->cells[target_idx].cache_valid = false;  // Invalidate cache - new expression
-                g->reactions_success++;
+        free(ws->items);
+        free(ws->commits.items);
+        free(ws->species.items);
+        free(ws->journals.items);
+        free(ws->tile_of.items);
+        free(ws->tile_edge.items);
+        free(ws->snapshot.items);
+        free(ws->bucket.items);
+        free(ws->tile_start.items);
+        free(ws);
+        g->workers = NULL;
+    }
+    if (threads == 1) return;
+
+    Thread_Pool *pool = pool_create(threads > 0 ? (size_t)threads : 0);
+    if (pool_workers(pool) == 1) {
+        pool_free(pool);
+        return;
+    }
+    ws = calloc(1, sizeof(*ws));
+    assert(ws != NULL && "Buy more RAM lol");
+    ws->pool = pool;
+    ws->count = pool_workers(pool);
+    ws->items = calloc(ws->count, sizeof(*ws->items));
+    assert(ws->items != NULL && "Buy more RAM lol");
+    for (size_t i = 0; i < ws->count; ++i) {
+        ws->items[i].ctx = &ws->items[i].scratch;
+        ws->items[i].scratch.fresh_counter = SCRATCH_FRESH_TAGS;
+    }
+    g->workers = ws;
+}
+
+// Storage block (or live tile) of a cell, for grid_snapshot_active()
+static size_t grid_sweep_bucket(Grid *g, int idx)
+{
+    if (g->sparse) return (size_t)g->slots.items[idx / GRID_SPARSE_AREA].rank;
+    return (size_t)(idx / GRID_BLOCK_AREA);
+}
+
+// Copy g->active to g->sweep, bucketed by block when blocked and by tile when
+// sparse. Also lists the live tiles of a sparse world.
+static void grid_snapshot_active(Grid *g)
+{
+    size_t count = g->active.count;
+    da_reserve(&g->sweep, count);
+    g->sweep.count = count;
+    g->sweep_start.count = 0;
+    da_append(&g->sweep_start, 0);
+    if (!g->blocked && !g->sparse) {
+        memcpy(g->sweep.items, g->active.items, count * sizeof(int));
+        da_append(&g->sweep_start, count);
+        return;
+    }
+
+    size_t blocks = (size_t)g->cell_count / GRID_BLOCK_AREA;
+    if (g->sparse) {
+        // Directory order, so slot numbers don't matter
+        g->live.count = 0;
+        for (size_t slot = 0; slot < g->slots.count; ++slot) {
+            if (g->slots.items[slot].tile >= 0) da_append(&g->live, g->slots.items[slot].tile);
+        }
+        qsort(g->live.items, g->live.count, sizeof(int), compare_ints);
+        for (size_t i = 0; i < g->live.count; ++i) g->slots.items[g->tile_slot[g->live.items[i]]].rank = (int)i;
+        blocks = g->live.count;
+    }
+    for (size_t i = 0; i < blocks; ++i) da_append(&g->sweep_start, 0);
+    size_t *start = g->sweep_start.items;
+    for (size_t i = 0; i < count; ++i) start[grid_sweep_bucket(g, g->active.items[i]) + 1]++;
+    for (size_t i = 1; i <= blocks; ++i) start[i] += start[i - 1];
+    for (size_t i = 0; i < count; ++i) {
+        int idx = g->active.items[i];
+        g->sweep.items[start[grid_sweep_bucket(g, idx)]++] = idx;
+    }
+    for (size_t i = blocks; i > 0; --i) start[i] = start[i - 1];
+    start[0] = 0;
+}
+
+int grid_threads(Grid *g)
+{
+    return g->workers ? (int)g->workers->count : 1;
+}
+
+// Run events until the clock reaches the next whole unit of time. An event
+// that would land past it is dropped: waiting times are memoryless, so the
+// next step redraws it without bias.
+static void grid_step_kinetic(Grid *g, Grid_Worker *w, size_t eval_steps, size_t max_mass)
+{
+    Grid_Kinetic *k = g->kinetic;
+    Lamb_Rng *rng = &g->ctx->rng;
+    double end = (double)(g->steps + 1);
+    for (;;) {
+        uint64_t total = grid_kinetic_total(k);
+        double rate = (double)total / GRID_KINETIC_UPDATE;
+        double dt = -log1p(-rng_double(rng)) / rate;
+        if (total == 0 || g->time + dt >= end) break;
+        g->time += dt;
+
+        // Uniform in [0, total) by rejection
+        uint64_t limit = UINT64_MAX - UINT64_MAX % total, r;
+        do r = rng_next(rng); while (r >= limit);
+        int idx = (int)grid_kinetic_find(k, r % total);
+        if (g->cells[idx].occupied) {
+            grid_update_cell(g, w, idx, eval_steps, max_mass);
+        } else {
+            grid_cosmic_ray(g, w, idx);
+        }
+    }
+    g->time = end;
+}
+
+void grid_step(Grid *g, Bindings bindings, size_t eval_steps, size_t max_mass) {
+    Lamb_Context *ctx = g->ctx;
+
+    if (g->record) grid_record_begin_step(g);
+    if (grid_tiled(g)) {
+        grid_step_tiles(g, eval_steps, max_mass);
+    } else {
+        Grid_Worker w = { .ctx = ctx };
+        if (g->record) {
+            grid_record_begin(g, 1);
+            w.segment = &g->record->segments.items[0];
+        }
+        if (g->kinetic) {
+            grid_step_kinetic(g, &w, eval_steps, max_mass);
+        } else {
+            // 1. Snapshot the occupied cells - Asynchronous Cellular Automata.
+            // Cells that get occupied during the sweep wait for the next step.
+            grid_snapshot_active(g);
+
+            // 2. Process cells in sweep order, then the cosmic rays
+            grid_sweep_cells(g, &w, g->sweep.items, g->sweep_start.items, g->sweep_start.count - 1, eval_steps, max_mass);
+            if (g->sparse) {
+                grid_cosmic_rays_sparse(g, &w);
             } else {
-                // Divergence/Explosion: The victim B dies from instability
-                // A survives (it was the catalyst)
-                g->cells[target_idx].occupied = false;
-                g->cells[target_idx].cache_valid = false;
-                g->population--;
-                g->reactions_diverged++;
+                grid_cosmic_rays(g, &w, 0, 0, g->width, g->height);
             }
         }
+        grid_worker_flush(g, &w);
+        if (g->record) grid_record_end(g, 1);
+        free(w.encoded.items);
+        if (g->sparse) grid_tiles_release(g);
     }
-
-    free(indices);
     g->steps++;
+    if (!g->kinetic) g->time = (double)g->steps;
+    if (g->record) grid_record_end_step(g);
     
-    // Periodic GC
-    if (g->steps % 10 == 0) {
-        gc(var(symbol("_dummy")), bindings);
+    // Collect once enough was allocated since the last GC (every step when
+    // reference counting, where it only touches what changed)
+    if (gc_should_collect(ctx)) {
+        gc(ctx, var(ctx, symbol(ctx, "_dummy")), bindings);
         
-        // Compact memory if slot count gets too high (>10K slots with >50% dead)
-        if (g->steps % 100 == 0 && gc_slot_count() > 10000) {
-            gc_compact(NULL);  // bindings are empty in view mode
+        // Compact memory once most of the arena is free slots
+        if (gc_should_compact(ctx)) {
+            gc_compact(ctx, NULL);  // bindings are empty in view mode
         }
     }
 }
 
-// Hash comparison for qsort
-static int compare_hashes(const void *a, const void *b) {
-    uint32_t ha = *(const uint32_t*)a;
-    uint32_t hb = *(const uint32_t*)b;
-    if (ha < hb) return -1;
-    if (ha > hb) return 1;
-    return 0;
+// ============================================================================
+// CLUSTERS
+// ============================================================================
+
+// Like grid_neighbor(), but a cell of a tile without storage is -1 (empty)
+// rather than a reason to allocate one
+static int grid_neighbor_peek(Grid *g, int idx, int dir)
+{
+    if (!g->sparse) return grid_neighbor(g, idx, dir);
+    static const int dx[4] = {0, 1, 0, -1};
+    static const int dy[4] = {-1, 0, 1, 0};
+    int x, y;
+    grid_xy(g, idx, &x, &y);
+    x = (x + dx[dir] + g->width) % g->width;
+    y = (y + dy[dir] + g->height) % g->height;
+    int slot = g->tile_slot[y / GRID_SPARSE_TILE * g->tiles_x + x / GRID_SPARSE_TILE];
+    if (slot < 0) return -1;
+    return slot * GRID_SPARSE_AREA + y % GRID_SPARSE_TILE * GRID_SPARSE_TILE + x % GRID_SPARSE_TILE;
 }
 
-// Analyze unique species in the grid (returns unique count)
-// OPTIMIZED: Uses hashes instead of string conversion for speed
-size_t grid_analyze(Grid *g, bool verbose) {
-    int total = g->width * g->height;
-    int pop = grid_population(g);
-    
-    if (pop == 0) {
-        if (verbose) printf("Grid is empty.\n");
-        return 0;
+// Root of the cell's cluster, halving the path on the way
+static int32_t cluster_find(int32_t *parent, int32_t i)
+{
+    while (parent[i] >= 0) {
+        if (parent[parent[i]] >= 0) parent[i] = parent[parent[i]];
+        i = parent[i];
     }
-    
-    // Collect hashes of all expressions (much faster than string conversion)
-    uint32_t *hashes = malloc((size_t)pop * sizeof(uint32_t));
-    int hash_idx = 0;
-    int most_common_cell = -1;
-    
-    for (int i = 0; i < total && hash_idx < pop; ++i) {
-        if (g->cells[i].occupied) {
-            // Use cached hash if available
-            if (!g->cells[i].cache_valid) {
-                g->cells[i].cached_hash = hash_expr(g->cells[i].atom);
-                g->cells[i].cached_mass = expr_mass(g->cells[i].atom);
-                g->cells[i].cache_valid = true;
+    return i;
+}
+
+// Roots hold minus their size, the smaller cluster goes under the bigger
+static void cluster_union(int32_t *parent, int32_t a, int32_t b)
+{
+    a = cluster_find(parent, a);
+    b = cluster_find(parent, b);
+    if (a == b) return;
+    if (parent[a] > parent[b]) {
+        int32_t t = a;
+        a = b;
+        b = t;
+    }
+    parent[a] += parent[b];
+    parent[b] = a;
+}
+
+// Joins the two cells when they hold the same species, counts the sides of
+// the edge that face something else otherwise. j < 0 is a cell without
+// storage.
+static void cluster_edge(Grid *g, Grid_Clusters *clusters, int i, int j)
+{
+    bool a = g->cells[i].occupied;
+    bool b = j >= 0 && g->cells[j].occupied;
+    if (a && b && g->info[i].hash == g->info[j].hash) {
+        cluster_union(clusters->parent.items, i, j);
+    } else {
+        clusters->boundary += (size_t)a + (size_t)b;
+    }
+}
+
+// One pass over the edges of the torus (east and south of every cell), then
+// one over the roots. Rows get their neighbours without a division.
+void grid_clusters(Grid *g, Grid_Clusters *clusters)
+{
+    size_t total = (size_t)g->cell_count;
+    clusters->clusters = 0;
+    clusters->largest = 0;
+    clusters->boundary = 0;
+    memset(clusters->sizes, 0, sizeof(clusters->sizes));
+    clusters->parent.count = 0;
+    da_reserve(&clusters->parent, total);
+    clusters->parent.count = total;
+    int32_t *parent = clusters->parent.items;
+    for (size_t i = 0; i < total; ++i) parent[i] = -1;
+
+    if (!g->sparse && !g->blocked) {
+        int w = g->width, h = g->height;
+        for (int y = 0; y < h; ++y) {
+            int row = y * w, below = y + 1 < h ? row + w : 0;
+            for (int x = 0; x < w; ++x) {
+                cluster_edge(g, clusters, row + x, x + 1 < w ? row + x + 1 : row);
+                cluster_edge(g, clusters, row + x, below + x);
             }
-            hashes[hash_idx] = g->cells[i].cached_hash;
-            if (most_common_cell < 0) most_common_cell = i;
-            hash_idx++;
         }
-    }
-    
-    // Sort hashes to group identical species
-    qsort(hashes, (size_t)pop, sizeof(uint32_t), compare_hashes);
-    
-    // Count unique (note: hash collisions may slightly undercount)
-    size_t unique = 1;
-    size_t max_freq = 1;
-    size_t cur_freq = 1;
-    uint32_t most_common_hash = hashes[0];
-    
-    for (int i = 1; i < pop; ++i) {
-        if (hashes[i] != hashes[i-1]) {
-            if (cur_freq > max_freq) {
-                max_freq = cur_freq;
-                most_common_hash = hashes[i-1];
+    } else if (g->sparse) {
+        for (size_t slot = 0; slot < g->slots.count; ++slot) {
+            int tile = g->slots.items[slot].tile;
+            if (tile < 0) continue;
+            int x0 = tile % g->tiles_x * GRID_SPARSE_TILE, y0 = tile / g->tiles_x * GRID_SPARSE_TILE;
+            for (int p = 0; p < GRID_SPARSE_AREA; ++p) {
+                // Tiles on the far edges may stick out of the world
+                if (x0 + p % GRID_SPARSE_TILE >= g->width || y0 + p / GRID_SPARSE_TILE >= g->height) continue;
+                int i = (int)slot * GRID_SPARSE_AREA + p;
+                cluster_edge(g, clusters, i, grid_neighbor_peek(g, i, 1));
+                cluster_edge(g, clusters, i, grid_neighbor_peek(g, i, 2));
+                // Edges coming from a tile without storage are never walked
+                if (g->cells[i].occupied) {
+                    clusters->boundary += (size_t)(grid_neighbor_peek(g, i, 0) < 0);
+                    clusters->boundary += (size_t)(grid_neighbor_peek(g, i, 3) < 0);
+                }
             }
-            unique++;
-            cur_freq = 1;
-        } else {
-            cur_freq++;
         }
+    } else {
+        for (size_t i = 0; i < total; ++i) {
+            cluster_edge(g, clusters, (int)i, grid_neighbor(g, (int)i, 1));
+            cluster_edge(g, clusters, (int)i, grid_neighbor(g, (int)i, 2));
+        }
+    }
+
+    for (size_t i = 0; i < total; ++i) {
+        if (!g->cells[i].occupied || parent[i] >= 0) continue;
+        size_t size = (size_t)-parent[i];
+        size_t bin = 0;
+        while (bin + 1 < GRID_CLUSTER_BINS && size >> (bin + 1)) bin++;
+        clusters->sizes[bin]++;
+        clusters->clusters++;
+        if (size > clusters->largest) clusters->largest = size;
     }
-    if (cur_freq > max_freq) {
-        max_freq = cur_freq;
-        most_common_hash = hashes[pop-1];
+}
+
+void grid_clusters_free(Grid_Clusters *clusters)
+{
+    free(clusters->parent.items);
+    memset(clusters, 0, sizeof(*clusters));
+}
+
+// Analyze unique species in the grid (returns unique count), straight from
+// the histogram
+size_t grid_analyze(Grid *g, bool verbose) {
+    Lamb_Context *ctx = g->ctx;
+    size_t pop = (size_t)g->population;
+    size_t unique = g->histogram.unique;
+    
+    if (pop == 0) {
+        if (verbose) printf("Grid is empty.\n");
+        return 0;
     }
     
     if (verbose) {
-        printf("Population:  %d\n", pop);
+        printf("Population:  %zu\n", pop);
         printf("Unique:      %zu (%.2f%% diversity)\n", unique, ((float)unique / pop) * 100.0f);
         
         // Find and print the most common expression (only when verbose)
-        for (int i = 0; i < total; ++i) {
-            if (g->cells[i].occupied && g->cells[i].cached_hash == most_common_hash) {
-                char *expr_str = expr_to_string(g->cells[i].atom);
-                printf("Dominant:    %s (%zu, %.2f%%)\n", expr_str, max_freq, ((float)max_freq / pop) * 100.0f);
+        uint64_t dominant = grid_dominant(g);
+        for (int i = 0; i < g->cell_count; ++i) {
+            if (g->cells[i].occupied && g->info[i].hash == dominant) {
+                char *expr_str = expr_to_string(ctx, cell_atom(&g->cells[i]));
+                printf("Dominant:    %s (%zu, %.2f%%)\n", expr_str, g->histogram.max_freq, ((float)g->histogram.max_freq / pop) * 100.0f);
                 free(expr_str);
                 break;
             }
         }
     }
     
-    free(hashes);
     return unique;
 }
 
+// ============================================================================
+// RENDERING AND EXPORT
+// ============================================================================
+
+// A sparse world is too big to draw cell by cell: one character per tile,
+// by how full it is, as long as the map fits a terminal
+static void grid_render_tiles(Grid *g)
+{
+    size_t live = 0;
+    for (size_t slot = 0; slot < g->slots.count; ++slot) live += g->slots.items[slot].tile >= 0;
+    printf("%zu of %d tiles live (%dx%d cells each)\n", live, g->tiles_x * g->tiles_y, GRID_SPARSE_TILE, GRID_SPARSE_TILE);
+    if (g->tiles_x > 160) return;
+    for (int ty = 0; ty < g->tiles_y; ++ty) {
+        for (int tx = 0; tx < g->tiles_x; ++tx) {
+            int slot = g->tile_slot[ty * g->tiles_x + tx];
+            int population = slot < 0 ? 0 : g->slots.items[slot].population;
+            char c = '.';
+            if (population > GRID_SPARSE_AREA / 4) c = '#';
+            else if (population > GRID_SPARSE_AREA / 32) c = '8';
+            else if (population > 0) c = 'o';
+            putchar(c);
+        }
+        putchar('\n');
+    }
+}
+
 // ASCII renderer for the grid - Mass-based visualization
 void grid_render(Grid *g, bool clear_screen) {
+    Lamb_Context *ctx = g->ctx;
     if (clear_screen) {
         printf("\033[H\033[J"); // ANSI clear screen
     }
     printf("--- STEP %ld | Pop: %d | React: %ld | Div: %ld | Deaths: %ld | Spawns: %ld ---\n", 
            g->steps, grid_population(g), g->reactions_success, 
            g->reactions_diverged, g->deaths_age, g->cosmic_spawns);
+    if (g->sparse) {
+        grid_render_tiles(g);
+        return;
+    }
     
     for (int y = 0; y < g->height; ++y) {
         for (int x = 0; x < g->width; ++x) {
-            int idx = y * g->width + x;
+            int idx = grid_idx(g, x, y);
             if (!g->cells[idx].occupied) {
                 printf(". ");
             } else {
                 // Use cached mass if available
-                if (!g->cells[idx].cache_valid) {
-                    g->cells[idx].cached_mass = expr_mass(g->cells[idx].atom);
-                    g->cells[idx].cached_hash = hash_expr(g->cells[idx].atom);
-                    g->cells[idx].cache_valid = true;
+                if (!g->info[idx].cache_valid) {
+                    g->info[idx].cached_mass = expr_mass(ctx, cell_atom(&g->cells[idx]));
+                    g->info[idx].cache_valid = true;
                 }
-                size_t mass = g->cells[idx].cached_mass;
+                size_t mass = g->info[idx].cached_mass;
                 char c = '?';
                 
                 // Visualization based on complexity (mass)
@@ -529,19 +2205,37 @@ bool grid_export_log(Grid *g, const char *filename, bool append) {
     if (!f) return false;
     
     if (!append) {
-        fprintf(f, "step,population,unique_species,reactions_success,reactions_diverged,movements,deaths_age,cosmic_spawns\n");
+        fprintf(f, "step,population,unique_species,reactions_success,reactions_diverged,movements,deaths_age,cosmic_spawns,"
+                   "clusters,largest_cluster,boundary");
+        for (int bin = 0; bin < GRID_CLUSTER_BINS; ++bin) fprintf(f, ",clusters_%d", 1 << bin);
+        fprintf(f, "\n");
     }
     
     size_t unique = grid_analyze(g, false);
-    fprintf(f, "%ld,%d,%zu,%ld,%ld,%ld,%ld,%ld\n", 
-            g->steps, grid_population(g), unique, 
+    Grid_Clusters *clusters = &g->clusters;
+    grid_clusters(g, clusters);
+    int pop = grid_population(g);
+    fprintf(f, "%ld,%d,%zu,%ld,%ld,%ld,%ld,%ld,%zu,%.4f,%zu", 
+            g->steps, pop, unique, 
             g->reactions_success, g->reactions_diverged, g->movements,
-            g->deaths_age, g->cosmic_spawns);
+            g->deaths_age, g->cosmic_spawns,
+            clusters->clusters, pop > 0 ? (double)clusters->largest / pop : 0.0, clusters->boundary);
+    for (int bin = 0; bin < GRID_CLUSTER_BINS; ++bin) fprintf(f, ",%zu", clusters->sizes[bin]);
+    fprintf(f, "\n");
     
     fclose(f);
     return true;
 }
 
+static void grid_save_cell(Grid *g, FILE *f, String_Builder *sb, int idx, int *soup_idx)
+{
+    if (!g->cells[idx].occupied) return;
+    sb->count = 0;
+    expr_display_no_tags(g->ctx, cell_atom(&g->cells[idx]), sb);
+    sb_append_null(sb);
+    fprintf(f, "soup_%d = %s;\n", (*soup_idx)++, sb->items);
+}
+
 // Save grid soup to a .lamb file
 bool grid_save_soup(Grid *g, const char *filename) {
     FILE *f = fopen(filename, "w");
@@ -553,14 +2247,20 @@ bool grid_save_soup(Grid *g, const char *filename) {
     
     String_Builder sb = {0};
     int soup_idx = 0;
-    int total = g->width * g->height;
-    
-    for (int i = 0; i < total; ++i) {
-        if (g->cells[i].occupied) {
-            sb.count = 0;
-            expr_display_no_tags(g->cells[i].atom, &sb);
-            sb_append_null(&sb);
-            fprintf(f, "soup_%d = %s;\n", soup_idx++, sb.items);
+    if (g->sparse) {
+        // Live tiles in directory order, each row-major
+        for (int tile = 0; tile < g->tiles_x * g->tiles_y; ++tile) {
+            int slot = g->tile_slot[tile];
+            if (slot < 0) continue;
+            for (int p = 0; p < GRID_SPARSE_AREA; ++p) {
+                grid_save_cell(g, f, &sb, slot * GRID_SPARSE_AREA + p, &soup_idx);
+            }
+        }
+    } else {
+        int total = g->width * g->height;
+        for (int j = 0; j < total; ++j) {
+            // Row-major whatever the layout
+            grid_save_cell(g, f, &sb, grid_idx(g, j % g->width, j / g->width), &soup_idx);
         }
     }
     
@@ -569,6 +2269,527 @@ bool grid_save_soup(Grid *g, const char *filename) {
     return true;
 }
 
+// ============================================================================
+// CHECKPOINT
+// ============================================================================
+
+// Binary snapshot of a grid that grid_load_checkpoint() resumes exactly: the
+// random stream, the fresh tag counter, the statistics and every cell with
+// its age, generation and place in the sweep order. The terms of all the cells
+// share one node table, every distinct subterm stored once and children before
+// parents. Everything is fixed width in host byte order, so a load maps the
+// file and only turns node ids into heap nodes and label numbers into interned
+// labels.
+//
+//   file   = header nodes[node_count] info[cell_count] cells[cell_count]
+//            active[active_count] tile_slot[tiles] slots[slot_count]
+//            free_slots[free_count] labels
+//   labels = label_count NUL-terminated strings
+//
+// The atoms of the cells are node ids. A sparse world keeps its tile
+// directory and storage slots as they are, a dense one has none (tiles = 0).
+#define GRID_CHECKPOINT_MAGIC "LAMBCKP1"
+#define GRID_CHECKPOINT_VERSION 1
+#define GRID_CHECKPOINT_ENDIAN 0x01020304u
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian;          // GRID_CHECKPOINT_ENDIAN as the writer stored it
+    uint32_t width;
+    uint32_t height;
+    uint32_t layout;          // blocked | sparse << 1 | kinetic << 2
+    uint32_t label_count;
+    uint64_t rng[4];
+    uint64_t fresh;
+    int64_t steps;
+    double time;
+    int64_t reactions_success;
+    int64_t reactions_diverged;
+    int64_t movements;
+    int64_t deaths_age;
+    int64_t cosmic_spawns;
+    int64_t attacks;
+    int64_t evasions;
+    uint64_t node_count;
+    uint64_t cell_count;
+    uint64_t active_count;
+    uint64_t slot_count;
+    uint64_t free_count;
+    uint64_t labels_size;
+} Grid_Checkpoint_Header;
+
+typedef struct {
+    uint32_t kind;
+    uint32_t label;           // Variable, magic or parameter
+    uint64_t tag;
+    uint32_t lhs;             // Body of a function, sides of an application
+    uint32_t rhs;
+    uint64_t hash;            // expr_hash() memo, 0 = none. Not part of the identity.
+} Grid_Checkpoint_Node;
+
+typedef struct {
+    int32_t generation;
+    uint32_t unused;
+    uint64_t hash;            // Of the atom, which a load hashes again instead
+} Grid_Checkpoint_Info;
+
+typedef struct {
+    uint32_t atom;            // Node id
+    uint16_t age;
+    uint8_t occupied;
+    uint8_t unused;
+} Grid_Checkpoint_Cell;
+
+typedef struct {
+    Lamb_Context *ctx;
+    struct {
+        Grid_Checkpoint_Node *items;
+        size_t count;
+        size_t capacity;
+    } nodes;
+    struct {
+        const char **items;
+        size_t count;
+        size_t capacity;
+    } labels;
+    uint32_t *ids;            // Node of every heap slot + 1, 0 = not met yet
+    uint32_t *table;          // Open addressing over node id + 1
+    size_t table_size;
+} Checkpoint_Writer;
+
+static uint32_t checkpoint_label(Checkpoint_Writer *cw, const char *label)
+{
+    // Interned, and there are few of them
+    for (size_t i = 0; i < cw->labels.count; ++i) {
+        if (cw->labels.items[i] == label) return (uint32_t)i;
+    }
+    da_append(&cw->labels, label);
+    return (uint32_t)(cw->labels.count - 1);
+}
+
+static uint64_t checkpoint_node_hash(const Grid_Checkpoint_Node *node)
+{
+    return grid_record_hash((const uint8_t *)node, offsetof(Grid_Checkpoint_Node, hash));
+}
+
+static void checkpoint_insert(Checkpoint_Writer *cw, uint32_t id)
+{
+    size_t mask = cw->table_size - 1;
+    size_t i = (size_t)checkpoint_node_hash(&cw->nodes.items[id]) & mask;
+    while (cw->table[i]) i = (i + 1) & mask;
+    cw->table[i] = id + 1;
+}
+
+// Node id of the term, adding the nodes nobody added yet
+static uint32_t checkpoint_node(Checkpoint_Writer *cw, Expr_Index expr)
+{
+    if (cw->ids[expr.unwrap]) return cw->ids[expr.unwrap] - 1;
+    Expr *e = &expr_slot(cw->ctx, expr);
+    Grid_Checkpoint_Node node = { .kind = (uint32_t)e->kind, .hash = e->hash };
+    switch (e->kind) {
+    case EXPR_VAR:
+        node.label = checkpoint_label(cw, e->as.var.label);
+        node.tag = e->as.var.tag;
+        break;
+    case EXPR_MAG:
+        node.label = checkpoint_label(cw, e->as.mag);
+        break;
+    case EXPR_FUN:
+        node.label = checkpoint_label(cw, e->as.fun.param.label);
+        node.tag = e->as.fun.param.tag;
+        node.lhs = checkpoint_node(cw, e->as.fun.body);
+        break;
+    case EXPR_APP:
+        node.lhs = checkpoint_node(cw, e->as.app.lhs);
+        node.rhs = checkpoint_node(cw, e->as.app.rhs);
+        break;
+    default: UNREACHABLE("Expr_Kind");
+    }
+
+    size_t mask = cw->table_size - 1;
+    size_t i = (size_t)checkpoint_node_hash(&node) & mask;
+    for (; cw->table[i]; i = (i + 1) & mask) {
+        uint32_t id = cw->table[i] - 1;
+        if (memcmp(&cw->nodes.items[id], &node, offsetof(Grid_Checkpoint_Node, hash)) == 0) {
+            cw->ids[expr.unwrap] = id + 1;
+            return id;
+        }
+    }
+    assert(cw->nodes.count < UINT32_MAX && "Buy more RAM lol");
+    uint32_t id = (uint32_t)cw->nodes.count;
+    da_append(&cw->nodes, node);
+    if (2 * cw->nodes.count >= cw->table_size) {
+        free(cw->table);
+        cw->table_size *= 2;
+        cw->table = calloc(cw->table_size, sizeof(*cw->table));
+        assert(cw->table != NULL && "Buy more RAM lol");
+        for (uint32_t j = 0; j < cw->nodes.count; ++j) checkpoint_insert(cw, j);
+    } else {
+        cw->table[i] = id + 1;
+    }
+    cw->ids[expr.unwrap] = id + 1;
+    return id;
+}
+
+bool grid_save_checkpoint(Grid *g, const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "ERROR: Could not open %s for writing: %s\n", path, strerror(errno));
+        return false;
+    }
+    Lamb_Context *ctx = g->ctx;
+    size_t cells = (size_t)g->cell_count;
+    Checkpoint_Writer cw = { .ctx = ctx, .table_size = 1024 };
+    cw.ids = calloc(ctx->gc.slots.count + 1, sizeof(*cw.ids));
+    cw.table = calloc(cw.table_size, sizeof(*cw.table));
+    assert(cw.ids != NULL && cw.table != NULL && "Buy more RAM lol");
+    for (size_t i = 0; i < cells; ++i) {
+        if (g->cells[i].occupied) checkpoint_node(&cw, cell_atom(&g->cells[i]));
+    }
+
+    Grid_Checkpoint_Header h = {0};
+    memcpy(h.magic, GRID_CHECKPOINT_MAGIC, sizeof(h.magic));
+    h.version = GRID_CHECKPOINT_VERSION;
+    h.endian = GRID_CHECKPOINT_ENDIAN;
+    h.width = (uint32_t)g->width;
+    h.height = (uint32_t)g->height;
+    h.layout = (uint32_t)g->blocked | (uint32_t)g->sparse << 1 | (uint32_t)(g->kinetic != NULL) << 2;
+    h.label_count = (uint32_t)cw.labels.count;
+    for (size_t i = 0; i < 4; ++i) h.rng[i] = ctx->rng.s[i];
+    h.fresh = ctx->fresh_counter;
+    h.steps = g->steps;
+    h.time = g->time;
+    h.reactions_success = g->reactions_success;
+    h.reactions_diverged = g->reactions_diverged;
+    h.movements = g->movements;
+    h.deaths_age = g->deaths_age;
+    h.cosmic_spawns = g->cosmic_spawns;
+    h.attacks = g->attacks;
+    h.evasions = g->evasions;
+    h.node_count = cw.nodes.count;
+    h.cell_count = cells;
+    h.active_count = g->active.count;
+    h.slot_count = g->sparse ? g->slots.count : 0;
+    h.free_count = g->sparse ? g->free_slots.count : 0;
+    for (size_t i = 0; i < cw.labels.count; ++i) h.labels_size += strlen(cw.labels.items[i]) + 1;
+
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+    if (ok && cw.nodes.count > 0) ok = fwrite(cw.nodes.items, sizeof(*cw.nodes.items), cw.nodes.count, f) == cw.nodes.count;
+
+    // The cell sections go out a chunk at a time, the atoms turned into node ids
+    enum { CHUNK = 4096 };
+    Grid_Checkpoint_Info *info = malloc(CHUNK * sizeof(*info));
+    Grid_Checkpoint_Cell *chunk = malloc(CHUNK * sizeof(*chunk));
+    assert(info != NULL && chunk != NULL && "Buy more RAM lol");
+    for (size_t start = 0; ok && start < cells; start += CHUNK) {
+        size_t n = cells - start < CHUNK ? cells - start : CHUNK;
+        for (size_t i = 0; i < n; ++i) {
+            bool occupied = g->cells[start + i].occupied;
+            info[i] = (Grid_Checkpoint_Info){0};
+            if (occupied) {
+                info[i].generation = g->info[start + i].generation;
+                info[i].hash = g->info[start + i].hash;
+            }
+        }
+        ok = fwrite(info, sizeof(*info), n, f) == n;
+    }
+    for (size_t start = 0; ok && start < cells; start += CHUNK) {
+        size_t n = cells - start < CHUNK ? cells - start : CHUNK;
+        for (size_t i = 0; i < n; ++i) {
+            Cell *cell = &g->cells[start + i];
+            chunk[i] = (Grid_Checkpoint_Cell){0};
+            if (cell->occupied) {
+                chunk[i].atom = cw.ids[cell->atom] - 1;
+                chunk[i].age = cell->age;
+                chunk[i].occupied = 1;
+            }
+        }
+        ok = fwrite(chunk, sizeof(*chunk), n, f) == n;
+    }
+
+    if (ok && g->active.count > 0) ok = fwrite(g->active.items, sizeof(int), g->active.count, f) == g->active.count;
+    if (g->sparse) {
+        size_t tiles = (size_t)g->tiles_x * (size_t)g->tiles_y;
+        if (ok) ok = fwrite(g->tile_slot, sizeof(int), tiles, f) == tiles;
+        if (ok && g->slots.count > 0) ok = fwrite(g->slots.items, sizeof(Grid_Slot), g->slots.count, f) == g->slots.count;
+        if (ok && g->free_slots.count > 0) {
+            ok = fwrite(g->free_slots.items, sizeof(int), g->free_slots.count, f) == g->free_slots.count;
+        }
+    }
+    for (size_t i = 0; ok && i < cw.labels.count; ++i) {
+        size_t n = strlen(cw.labels.items[i]) + 1;
+        ok = fwrite(cw.labels.items[i], 1, n, f) == n;
+    }
+    if (fclose(f) != 0) ok = false;
+    if (!ok) fprintf(stderr, "ERROR: Could not write %s: %s\n", path, strerror(errno));
+
+    free(info);
+    free(chunk);
+    free(cw.nodes.items);
+    free(cw.labels.items);
+    free(cw.ids);
+    free(cw.table);
+    return ok;
+}
+
+// A checkpoint file in memory, mapped where mmap() is around
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    String_Builder sb;
+} Checkpoint_Map;
+
+static bool checkpoint_map(const char *path, Checkpoint_Map *map)
+{
+    memset(map, 0, sizeof(*map));
+#ifdef _WIN32
+    if (!read_entire_file(path, &map->sb)) return false;
+    map->data = (const uint8_t *)map->sb.items;
+    map->size = map->sb.count;
+    return true;
+#else
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        fprintf(stderr, "ERROR: Could not open %s for reading: %s\n", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    map->size = (size_t)st.st_size;
+    if (map->size > 0) {
+        void *data = mmap(NULL, map->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            fprintf(stderr, "ERROR: Could not map %s: %s\n", path, strerror(errno));
+            close(fd);
+            return false;
+        }
+        // Read once front to back
+        madvise(data, map->size, MADV_SEQUENTIAL);
+        map->data = data;
+    }
+    close(fd);
+    return true;
+#endif // _WIN32
+}
+
+static void checkpoint_unmap(Checkpoint_Map *map)
+{
+#ifndef _WIN32
+    if (map->data) munmap((void *)map->data, map->size);
+#endif // _WIN32
+    free(map->sb.items);
+}
+
+bool grid_load_checkpoint(Grid *g, Lamb_Context *ctx, const char *path)
+{
+    Checkpoint_Map map;
+    if (!checkpoint_map(path, &map)) return false;
+
+    Grid_Checkpoint_Header h;
+    bool ok = map.size >= sizeof(h);
+    if (ok) memcpy(&h, map.data, sizeof(h));
+    ok = ok && memcmp(h.magic, GRID_CHECKPOINT_MAGIC, sizeof(h.magic)) == 0 &&
+         h.version == GRID_CHECKPOINT_VERSION && h.endian == GRID_CHECKPOINT_ENDIAN &&
+         h.width > 0 && h.height > 0 && h.width <= INT_MAX && h.height <= INT_MAX && h.layout < 8 &&
+         h.node_count <= UINT32_MAX && h.label_count <= h.labels_size && h.labels_size <= map.size;
+    bool blocked = (h.layout & 1) != 0, sparse = (h.layout & 2) != 0, kinetic = (h.layout & 4) != 0;
+    uint64_t tiles = 0;
+    if (ok && sparse) {
+        tiles = (uint64_t)((h.width + GRID_SPARSE_TILE - 1) / GRID_SPARSE_TILE) *
+                (uint64_t)((h.height + GRID_SPARSE_TILE - 1) / GRID_SPARSE_TILE);
+        ok = !blocked && !kinetic && tiles <= INT_MAX && h.slot_count <= (uint64_t)(INT_MAX / GRID_SPARSE_AREA) &&
+             h.cell_count == h.slot_count * GRID_SPARSE_AREA && h.free_count <= h.slot_count;
+    } else if (ok) {
+        ok = (uint64_t)h.width * h.height <= INT_MAX && h.cell_count == (uint64_t)h.width * h.height &&
+             h.slot_count == 0 && h.free_count == 0 &&
+             (!blocked || (h.width % GRID_BLOCK == 0 && h.height % GRID_BLOCK == 0));
+    }
+    ok = ok && h.active_count <= h.cell_count &&
+         sizeof(h) + h.node_count * sizeof(Grid_Checkpoint_Node) +
+         h.cell_count * (sizeof(Grid_Checkpoint_Info) + sizeof(Grid_Checkpoint_Cell)) +
+         (h.active_count + tiles + h.free_count) * sizeof(int) + h.slot_count * sizeof(Grid_Slot) + h.labels_size == map.size;
+    if (!ok) {
+        fprintf(stderr, "ERROR: %s is not a grid checkpoint\n", path);
+        checkpoint_unmap(&map);
+        return false;
+    }
+
+    const uint8_t *p = map.data + sizeof(h);
+    const Grid_Checkpoint_Node *nodes = (const void *)p;
+    p += h.node_count * sizeof(*nodes);
+    const Grid_Checkpoint_Info *info = (const void *)p;
+    p += h.cell_count * sizeof(*info);
+    const Grid_Checkpoint_Cell *cells = (const void *)p;
+    p += h.cell_count * sizeof(*cells);
+    const int *active = (const void *)p;
+    p += h.active_count * sizeof(int);
+    const int *tile_slot = (const void *)p;
+    p += tiles * sizeof(int);
+    const Grid_Slot *slots = (const void *)p;
+    p += h.slot_count * sizeof(*slots);
+    const int *free_slots = (const void *)p;
+    p += h.free_count * sizeof(int);
+    const char *text = (const char *)p;
+    size_t cell_count = (size_t)h.cell_count;
+
+    // Fix-up tables: label numbers to interned labels, node ids to heap nodes
+    const char **labels = malloc((h.label_count + 1) * sizeof(*labels));
+    Expr_Index *exprs = malloc((size_t)(h.node_count + 1) * sizeof(*exprs));
+    assert(labels != NULL && exprs != NULL && "Buy more RAM lol");
+    size_t at = 0, count = 0;
+    ok = h.labels_size == 0 || text[h.labels_size - 1] == '\0';
+    while (ok && count < h.label_count && at < h.labels_size) {
+        labels[count++] = intern_label(ctx, &text[at]);
+        at += strlen(&text[at]) + 1;
+    }
+    if (!ok || count != h.label_count || at != h.labels_size) {
+        fprintf(stderr, "ERROR: %s: corrupt labels\n", path);
+        free(labels);
+        free(exprs);
+        checkpoint_unmap(&map);
+        return false;
+    }
+
+    // Every section is checked against the file before the grid is touched,
+    // so a rejected checkpoint leaves the running grid as it was
+    for (size_t i = 0; ok && i < h.node_count; ++i) {
+        Grid_Checkpoint_Node node = nodes[i];
+        bool named = node.kind != EXPR_APP;
+        bool children = node.kind == EXPR_FUN || node.kind == EXPR_APP;
+        ok = node.kind <= EXPR_MAG && (!named || node.label < h.label_count) &&
+             (!children || (node.lhs < i && (node.kind == EXPR_FUN || node.rhs < i)));
+    }
+    size_t slot_count = (size_t)h.slot_count;
+    if (ok && sparse) {
+        for (uint64_t t = 0; ok && t < tiles; ++t) {
+            ok = tile_slot[t] >= -1 && tile_slot[t] < (int)slot_count &&
+                 (tile_slot[t] < 0 || slots[tile_slot[t]].tile == (int)t);
+        }
+        for (size_t s = 0; ok && s < slot_count; ++s) {
+            ok = slots[s].tile >= -1 && slots[s].tile < (int)tiles && (slots[s].tile < 0 || tile_slot[slots[s].tile] == (int)s);
+        }
+        // The free list names every free slot exactly once
+        size_t unused = 0;
+        for (size_t s = 0; s < slot_count; ++s) unused += slots[s].tile < 0;
+        ok = ok && unused == h.free_count;
+        bool *freed = ok ? calloc(slot_count + 1, sizeof(*freed)) : NULL;
+        assert((!ok || freed != NULL) && "Buy more RAM lol");
+        for (size_t s = 0; ok && s < h.free_count; ++s) {
+            int slot = free_slots[s];
+            ok = slot >= 0 && slot < (int)slot_count && slots[slot].tile < 0 && !freed[slot];
+            if (ok) freed[slot] = true;
+        }
+        free(freed);
+    }
+    size_t occupied = 0;
+    for (size_t i = 0; ok && i < cell_count; ++i) {
+        if (!cells[i].occupied) continue;
+        ok = cells[i].atom < h.node_count && (!sparse || slots[i / GRID_SPARSE_AREA].tile >= 0);
+        occupied++;
+    }
+    // The active list names every occupied cell exactly once
+    ok = ok && occupied == h.active_count;
+    bool *listed = ok ? calloc(cell_count + 1, sizeof(*listed)) : NULL;
+    assert((!ok || listed != NULL) && "Buy more RAM lol");
+    for (size_t j = 0; ok && j < h.active_count; ++j) {
+        int idx = active[j];
+        ok = idx >= 0 && (size_t)idx < cell_count && cells[idx].occupied && !listed[idx];
+        if (ok) listed[idx] = true;
+    }
+    free(listed);
+    if (!ok) {
+        fprintf(stderr, "ERROR: %s: corrupt grid\n", path);
+        free(labels);
+        free(exprs);
+        checkpoint_unmap(&map);
+        return false;
+    }
+
+    grid_set_layout(g, blocked);
+    grid_set_sparse(g, sparse);
+    grid_set_kinetic(g, kinetic);
+    grid_init(g, ctx, (int)h.width, (int)h.height);
+
+    for (size_t i = 0; i < h.node_count; ++i) {
+        Grid_Checkpoint_Node node = nodes[i];
+        Symbol name = { .label = node.kind != EXPR_APP ? labels[node.label] : NULL, .tag = (size_t)node.tag };
+        switch (node.kind) {
+        case EXPR_VAR: exprs[i] = var(ctx, name); break;
+        case EXPR_MAG: exprs[i] = magic(ctx, name.label); break;
+        case EXPR_FUN: exprs[i] = fun(ctx, name, exprs[node.lhs]); break;
+        case EXPR_APP: exprs[i] = app(ctx, exprs[node.lhs], exprs[node.rhs]); break;
+        default: UNREACHABLE("Expr_Kind");
+        }
+        expr_slot(ctx, exprs[i]).hash = node.hash;
+    }
+
+    if (sparse) {
+        memcpy(g->tile_slot, tile_slot, (size_t)tiles * sizeof(int));
+        if (slot_count > 0) {
+            da_reserve(&g->slots, slot_count);
+            memcpy(g->slots.items, slots, slot_count * sizeof(*slots));
+            g->slots.count = slot_count;
+            for (size_t s = 0; s < slot_count; ++s) g->slots.items[s].population = 0;  // Recounted from the cells
+            g->slots_allocated = g->slots.capacity;
+            size_t allocated = g->slots_allocated * GRID_SPARSE_AREA;
+            g->cells = calloc(allocated, sizeof(Cell));
+            g->info = calloc(allocated, sizeof(Cell_Info));
+            g->active_slot = malloc(allocated * sizeof(int));
+            assert(g->cells != NULL && g->info != NULL && g->active_slot != NULL && "Buy more RAM lol");
+            for (size_t i = 0; i < allocated; ++i) g->active_slot[i] = -1;
+        }
+        if (h.free_count > 0) {
+            da_reserve(&g->free_slots, (size_t)h.free_count);
+            memcpy(g->free_slots.items, free_slots, (size_t)h.free_count * sizeof(int));
+            g->free_slots.count = (size_t)h.free_count;
+        }
+        g->cell_count = (int)cell_count;
+    }
+
+    for (size_t i = 0; i < cell_count; ++i) {
+        Grid_Checkpoint_Cell saved = cells[i];
+        if (!saved.occupied) continue;
+        Cell *cell = &g->cells[i];
+        cell_set_atom(cell, exprs[saved.atom]);
+        cell->age = saved.age;
+        cell->occupied = true;
+        gc_remember(ctx, cell_atom(cell));
+        g->info[i].generation = info[i].generation;
+        g->info[i].hash = expr_hash(ctx, cell_atom(cell));
+        histogram_add(&g->histogram, g->info[i].hash);
+        if (sparse) g->slots.items[i / GRID_SPARSE_AREA].population++;
+    }
+
+    // In the saved order, which decides the next sweep
+    da_reserve(&g->active, (size_t)h.active_count);
+    for (size_t j = 0; j < h.active_count; ++j) {
+        int idx = active[j];
+        g->active_slot[idx] = (int)j;
+        g->active.items[g->active.count++] = idx;
+        if (g->kinetic) grid_kinetic_touch(g, idx);
+    }
+
+    free(labels);
+    free(exprs);
+    checkpoint_unmap(&map);
+
+    for (size_t i = 0; i < 4; ++i) ctx->rng.s[i] = h.rng[i];
+    ctx->fresh_counter = (size_t)h.fresh;
+    g->population = (int)h.active_count;
+    g->steps = (long)h.steps;
+    g->time = h.time;
+    g->reactions_success = (long)h.reactions_success;
+    g->reactions_diverged = (long)h.reactions_diverged;
+    g->movements = (long)h.movements;
+    g->deaths_age = (long)h.deaths_age;
+    g->cosmic_spawns = (long)h.cosmic_spawns;
+    g->attacks = (long)h.attacks;
+    g->evasions = (long)h.evasions;
+    return true;
+}
+
 // ============================================================================
 // MAIN
 // ============================================================================
@@ -578,8 +2799,10 @@ int main(int argc, char **argv)
 {
     static char buffer[1024];
     static Commands commands = {0};
+    static Lamb_Context grid_ctx = {0};
     static Bindings bindings = {0};
     static Lexer l = {0};
+    Lamb_Context *ctx = &grid_ctx;
 
 #ifndef _WIN32
     struct sigaction act = {0};
@@ -587,23 +2810,32 @@ int main(int argc, char **argv)
     sigaction(SIGINT, &act, NULL);
 #endif // _WIN32
 
-    srand((unsigned)time(NULL));
-
     const char *editor  = getenv("LAMB_EDITOR");
     if (!editor) editor = getenv("EDITOR");
     if (!editor) editor = "vi";
 
     char *active_file_path = NULL;
-
-    if (argc == 2) {
-        active_file_path = copy_string(argv[1]);
-    } else if (argc > 2) {
-        fprintf(stderr, "ERROR: only a single active file is support right now\n");
-        return 1;
+    uint64_t seed = seed_from_time();
+    char *record_path = NULL;  // Event log of the next :grid runs
+    int colonies = 16, colony_radius = 24;  // Seeding of sparse worlds
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--seed") == 0) {
+            if (i + 1 >= argc || !parse_seed(argv[++i], &seed)) {
+                fprintf(stderr, "ERROR: --seed expects a number\n");
+                return 1;
+            }
+        } else if (active_file_path) {
+            fprintf(stderr, "ERROR: only a single active file is support right now\n");
+            return 1;
+        } else {
+            active_file_path = copy_string(argv[i]);
+        }
     }
+    rng_seed(&ctx->rng, seed);
 
     if (active_file_path) {
-        create_bindings_from_file(active_file_path, &bindings);
+        create_bindings_from_file(ctx, active_file_path, &bindings);
     }
 
     printf(",---@>\n");
@@ -636,7 +2868,7 @@ again:
                 }
 
                 bindings.count = 0;
-                create_bindings_from_file(active_file_path, &bindings);
+                create_bindings_from_file(ctx, active_file_path, &bindings);
                 goto again;
             }
             if (command(&commands, l.string.items, "save", "[path]", "Save current bindings to a file.")) {
@@ -651,7 +2883,7 @@ again:
                 for (size_t i = 0; i < bindings.count; ++i) {
                     assert(bindings.items[i].name.tag == 0);
                     sb_appendf(&sb, "%s = ", bindings.items[i].name.label);
-                    expr_display(bindings.items[i].body, &sb);
+                    expr_display(ctx, bindings.items[i].body, &sb);
                     sb_appendf(&sb, ";\n");
                 }
 
@@ -688,7 +2920,7 @@ again:
                 da_append(&cmd, active_file_path);
                 if (cmd_run(&cmd)) {
                     bindings.count = 0;
-                    create_bindings_from_file(active_file_path, &bindings);
+                    create_bindings_from_file(ctx, active_file_path, &bindings);
                 }
 #endif // _WIN32
                 goto again;
@@ -704,7 +2936,7 @@ again:
                 args.count = 0;
                 if (!lexer_next(&l)) goto again;
                 while (l.token == TOKEN_NAME) {
-                    da_append(&args, intern_label(l.string.items));
+                    da_append(&args, intern_label(ctx, l.string.items));
                     if (!lexer_next(&l)) goto again;
                 }
                 if (l.token != TOKEN_END) {
@@ -717,7 +2949,7 @@ again:
                         assert(bindings.items[i].name.tag == 0);
                         sb.count = 0;
                         sb_appendf(&sb, "%s = ", bindings.items[i].name.label);
-                        expr_display(bindings.items[i].body, &sb);
+                        expr_display(ctx, bindings.items[i].body, &sb);
                         sb_appendf(&sb, ";");
                         sb_append_null(&sb);
                         printf("%s\n", sb.items);
@@ -733,7 +2965,7 @@ again:
                         if (bindings.items[i].name.label == label) {
                             sb.count = 0;
                             sb_appendf(&sb, "%s = ", bindings.items[i].name.label);
-                            expr_display(bindings.items[i].body, &sb);
+                            expr_display(ctx, bindings.items[i].body, &sb);
                             sb_appendf(&sb, ";");
                             sb_append_null(&sb);
                             printf("%s\n", sb.items);
@@ -750,7 +2982,7 @@ again:
             }
             if (command(&commands, l.string.items, "delete", "<name>", "delete a binding by name")) {
                 if (!lexer_expect(&l, TOKEN_NAME)) goto again;
-                Symbol name = symbol(l.string.items);
+                Symbol name = symbol(ctx, l.string.items);
                 for (size_t i = 0; i < bindings.count; ++i) {
                     if (symbol_eq(bindings.items[i].name, name)) {
                         da_delete_at(&bindings, i);
@@ -763,10 +2995,10 @@ again:
             }
             if (command(&commands, l.string.items, "debug", "<expr>", "Step debug the evaluation of an expression")) {
                 Expr_Index expr;
-                if (!parse_expr(&l, &expr)) goto again;
+                if (!parse_expr(ctx, &l, &expr)) goto again;
                 if (!lexer_expect(&l, TOKEN_END)) goto again;
                 for (size_t i = bindings.count; i > 0; --i) {
-                    expr = replace(bindings.items[i-1].name, expr, bindings.items[i-1].body);
+                    expr = replace(ctx, bindings.items[i-1].name, expr, bindings.items[i-1].body);
                 }
 
                 ctrl_c = 0;
@@ -774,7 +3006,7 @@ again:
                     if (ctrl_c) goto again;
 
                     printf("DEBUG: ");
-                    trace_expr(expr);
+                    trace_expr(ctx, expr);
                     printf("\n");
 
                     printf("-> ");
@@ -792,10 +3024,10 @@ again:
                         if (strcmp(l.string.items, "quit") == 0) goto again;
                     }
 
-                    gc(expr, bindings);
+                    gc(ctx, expr, bindings);
 
                     Expr_Index expr1;
-                    if (!eval1(expr, &expr1)) goto again;
+                    if (!eval1(ctx, expr, &expr1)) goto again;
                     if (expr.unwrap == expr1.unwrap) break;
                     expr = expr1;
                 }
@@ -868,21 +3100,32 @@ again:
                 UNUSED(log_interval);
                 
                 // Initialize the grid
-                grid_init(&active_grid, w, h);
-                int count = (w * h * density) / 100;
+                grid_init(&active_grid, ctx, w, h);
+                int count = active_grid.sparse ? 0 : (w * h * density) / 100;
                 
                 printf("=== 2D SPATIAL SIMULATION ===\n");
                 printf("Grid:        %dx%d (toroidal)\n", w, h);
-                printf("Population:  %d cells (%d%% density)\n", count, density);
+                if (active_grid.sparse) {
+                    printf("Colonies:    %d of radius %d (%d%% density)\n", colonies, colony_radius, density);
+                } else {
+                    printf("Population:  %d cells (%d%% density)\n", count, density);
+                }
                 printf("Iterations:  %ld\n", iterations);
                 printf("Depth:       %d\n", depth);
                 printf("Max Steps:   %ld\n", max_steps);
+                printf("Threads:     %d\n", grid_threads(&active_grid));
+                printf("Layout:      %s\n", active_grid.sparse ? "sparse" : active_grid.blocked ? "blocks" : "rows");
+                printf("Engine:      %s\n", active_grid.kinetic ? "kinetic" : "sweep");
                 printf("Log file:    %s\n", log_filename);
                 printf("=============================\n\n");
                 fflush(stdout);
                 
                 printf("Seeding grid with rich combinators...\n");
-                grid_seed(&active_grid, count, depth);
+                if (active_grid.sparse) {
+                    grid_seed_colonies(&active_grid, colonies, colony_radius, density, depth);
+                } else {
+                    grid_seed(&active_grid, count, depth);
+                }
                 
                 // Initial analysis
                 printf("--- INITIAL STATE ---\n");
@@ -892,6 +3135,10 @@ again:
                 
                 // Initialize log file
                 grid_export_log(&active_grid, log_filename, false);
+
+                if (record_path && grid_record_start(&active_grid, record_path, seed, (size_t)max_steps, 2000)) {
+                    printf("Recording events to %s\n", record_path);
+                }
                 
                 printf("Running simulation (Ctrl+C to stop)...\n");
                 fflush(stdout);
@@ -914,6 +3161,7 @@ again:
                     }
                 }
                 
+                grid_record_stop(&active_grid);
                 if (ctrl_c) {
                     printf("\nSimulation interrupted by user.\n");
                 }
@@ -939,6 +3187,84 @@ again:
                 
                 goto again;
             }
+            if (command(&commands, l.string.items, "record", "[path|off]", "Log the events of the following :grid runs to a file for :replay")) {
+                while (l.cur.pos < l.count && isspace(l.content[l.cur.pos])) l.cur.pos++;
+                const char *path_start = &l.content[l.cur.pos];
+                size_t path_len = l.count - l.cur.pos;
+                while (path_len > 0 && isspace(path_start[path_len - 1])) path_len--;
+
+                if (path_len > 0) {
+                    free(record_path);
+                    record_path = NULL;
+                    if (!(path_len == 3 && strncmp(path_start, "off", 3) == 0)) {
+                        record_path = copy_string_sized(path_start, path_len);
+                    }
+                }
+                if (record_path) {
+                    printf("Recording :grid runs to %s\n", record_path);
+                } else {
+                    printf("Recording: off\n");
+                }
+                goto again;
+            }
+            if (command(&commands, l.string.items, "replay", "<path> [fast]", "Re-run a recorded :grid run; fast takes reaction results from the log instead of reducing")) {
+                while (l.cur.pos < l.count && isspace(l.content[l.cur.pos])) l.cur.pos++;
+                const char *path_start = &l.content[l.cur.pos];
+                size_t path_len = l.count - l.cur.pos;
+                while (path_len > 0 && isspace(path_start[path_len - 1])) path_len--;
+
+                bool fast = false;
+                if (path_len > 5 && strncmp(&path_start[path_len - 5], " fast", 5) == 0) {
+                    fast = true;
+                    path_len -= 5;
+                    while (path_len > 0 && isspace(path_start[path_len - 1])) path_len--;
+                }
+                if (path_len == 0) {
+                    fprintf(stderr, "ERROR: :replay requires a filename\n");
+                    goto again;
+                }
+
+                char *replay_path = copy_string_sized(path_start, path_len);
+                Grid_Record_Info info;
+                if (!grid_replay_start(&active_grid, ctx, replay_path, fast, &info)) {
+                    free(replay_path);
+                    goto again;
+                }
+                printf("=== REPLAY of %s ===\n", replay_path);
+                printf("Grid:        %dx%d (toroidal)\n", active_grid.width, active_grid.height);
+                printf("Population:  %d cells\n", grid_population(&active_grid));
+                printf("Seed:        %llu\n", (unsigned long long)info.seed);
+                printf("Max Steps:   %zu\n", info.eval_steps);
+                printf("Schedule:    %s\n", info.tiled ? "tiles" : "serial");
+                printf("Reductions:  %s\n", fast ? "from the log" : "re-run and checked");
+                printf("=============================\n\n");
+                fflush(stdout);
+
+                uint64_t start = time_now_us();
+                ctrl_c = 0;
+                while (!ctrl_c && grid_replay_pending(&active_grid)) {
+                    grid_step(&active_grid, bindings, info.eval_steps, info.max_mass);
+                    if (active_grid.steps % 100 == 0) {
+                        printf(".");
+                        fflush(stdout);
+                    }
+                }
+                long mismatches = grid_replay_mismatches(&active_grid);
+                grid_record_stop(&active_grid);
+                if (ctrl_c) printf("\nReplay interrupted by user.\n");
+
+                printf("\n=== REPLAY COMPLETE ===\n");
+                printf("Total steps: %ld in %.2fs\n", active_grid.steps, (double)(time_now_us() - start) / 1e6);
+                printf("Reactions:   %ld successful, %ld diverged\n",
+                       active_grid.reactions_success, active_grid.reactions_diverged);
+                printf("Mismatches:  %ld\n", mismatches);
+                printf("\n--- FINAL STATE ---\n");
+                grid_analyze(&active_grid, true);
+                printf("-------------------\n");
+                fflush(stdout);
+                free(replay_path);
+                goto again;
+            }
             if (command(&commands, l.string.items, "grid_view", "[steps]", "Continue grid animation (ASCII)")) {
                 long steps = 100;
                 
@@ -1019,12 +3345,16 @@ again:
                 }
                 
                 // Initialize the grid
-                grid_init(&active_grid, w, h);
-                int count = (w * h * density) / 100;
+                grid_init(&active_grid, ctx, w, h);
+                int count = active_grid.sparse ? 0 : (w * h * density) / 100;
                 
                 printf("=== 2D VISUAL SIMULATION ===\n");
                 printf("Grid:        %dx%d (toroidal)\n", w, h);
-                printf("Population:  %d cells (%d%% density)\n", count, density);
+                if (active_grid.sparse) {
+                    printf("Colonies:    %d of radius %d (%d%% density)\n", colonies, colony_radius, density);
+                } else {
+                    printf("Population:  %d cells (%d%% density)\n", count, density);
+                }
                 printf("Iterations:  %ld\n", iterations);
                 printf("Delay:       %d ms\n", delay_ms);
                 printf("Depth:       %d\n", depth);
@@ -1032,7 +3362,11 @@ again:
                 printf("Seeding grid with rich combinators...\n");
                 fflush(stdout);
                 
-                grid_seed(&active_grid, count, depth);
+                if (active_grid.sparse) {
+                    grid_seed_colonies(&active_grid, colonies, colony_radius, density, depth);
+                } else {
+                    grid_seed(&active_grid, count, depth);
+                }
                 
                 printf("Press Ctrl+C to stop...\n");
                 fflush(stdout);
@@ -1107,11 +3441,172 @@ again:
                 free(save_filename);
                 goto again;
             }
+            if (command(&commands, l.string.items, "checkpoint", "<path>", "Save the whole state of the current grid to a binary file for :restore")) {
+                while (l.cur.pos < l.count && isspace(l.content[l.cur.pos])) l.cur.pos++;
+                const char *path_start = &l.content[l.cur.pos];
+                size_t path_len = l.count - l.cur.pos;
+                while (path_len > 0 && isspace(path_start[path_len - 1])) path_len--;
+
+                if (path_len == 0) {
+                    fprintf(stderr, "ERROR: :checkpoint requires a filename\n");
+                    goto again;
+                }
+                if (active_grid.width == 0) {
+                    printf("ERROR: No active grid to checkpoint.\n");
+                    goto again;
+                }
+
+                char *checkpoint_path = copy_string_sized(path_start, path_len);
+                uint64_t start = time_now_us();
+                if (grid_save_checkpoint(&active_grid, checkpoint_path)) {
+                    printf("Checkpoint of step %ld saved to %s in %.2fs\n", active_grid.steps, checkpoint_path,
+                           (double)(time_now_us() - start) / 1e6);
+                }
+                free(checkpoint_path);
+                goto again;
+            }
+            if (command(&commands, l.string.items, "restore", "<path>", "Resume the grid of a :checkpoint file, random stream included")) {
+                while (l.cur.pos < l.count && isspace(l.content[l.cur.pos])) l.cur.pos++;
+                const char *path_start = &l.content[l.cur.pos];
+                size_t path_len = l.count - l.cur.pos;
+                while (path_len > 0 && isspace(path_start[path_len - 1])) path_len--;
+
+                if (path_len == 0) {
+                    fprintf(stderr, "ERROR: :restore requires a filename\n");
+                    goto again;
+                }
+
+                char *checkpoint_path = copy_string_sized(path_start, path_len);
+                uint64_t start = time_now_us();
+                if (grid_load_checkpoint(&active_grid, ctx, checkpoint_path)) {
+                    printf("Restored %s in %.2fs\n", checkpoint_path, (double)(time_now_us() - start) / 1e6);
+                    printf("Grid:        %dx%d (toroidal)\n", active_grid.width, active_grid.height);
+                    printf("Population:  %d cells\n", grid_population(&active_grid));
+                    printf("Step:        %ld\n", active_grid.steps);
+                    printf("Layout:      %s\n", active_grid.sparse ? "sparse" : active_grid.blocked ? "blocks" : "rows");
+                    printf("Engine:      %s\n", active_grid.kinetic ? "kinetic" : "sweep");
+                    printf("Use :grid_run or :grid_view to continue.\n");
+                }
+                free(checkpoint_path);
+                goto again;
+            }
+            if (command(&commands, l.string.items, "grid_run", "<iterations> [steps]", "Continue the current grid without rendering")) {
+                long iterations = 100;
+                long max_steps = 100;
+                if (lexer_next(&l) && l.token == TOKEN_NAME) {
+                    iterations = strtol(l.string.items, NULL, 10);
+                    if (iterations <= 0) iterations = 100;
+                    if (lexer_next(&l) && l.token == TOKEN_NAME) {
+                        max_steps = strtol(l.string.items, NULL, 10);
+                        if (max_steps <= 0) max_steps = 100;
+                    }
+                }
+
+                if (active_grid.width == 0 || grid_population(&active_grid) == 0) {
+                    printf("ERROR: No active grid. Run :grid or :restore first.\n");
+                    goto again;
+                }
+
+                ctrl_c = 0;
+                for (long it = 0; it < iterations && !ctrl_c; ++it) {
+                    grid_step(&active_grid, bindings, (size_t)max_steps, 2000);
+                    if ((it + 1) % 100 == 0) {
+                        printf(".");
+                        fflush(stdout);
+                    }
+                    if (grid_population(&active_grid) == 0) {
+                        printf("\nGrid is empty!\n");
+                        break;
+                    }
+                }
+                if (ctrl_c) printf("\nSimulation interrupted by user.\n");
+
+                printf("\nStep %ld: %ld reactions ok, %ld diverged, %ld age deaths, %ld cosmic spawns\n",
+                       active_grid.steps, active_grid.reactions_success, active_grid.reactions_diverged,
+                       active_grid.deaths_age, active_grid.cosmic_spawns);
+                grid_analyze(&active_grid, true);
+                fflush(stdout);
+                goto again;
+            }
+            if (command(&commands, l.string.items, "threads", "[n]", "Show or set the threads grid steps run on (1 = serial, 0 = all CPUs) and their load")) {
+                if (lexer_next(&l) && l.token == TOKEN_NAME) {
+                    grid_set_threads(&active_grid, atoi(l.string.items));
+                }
+                printf("Threads: %d\n", grid_threads(&active_grid));
+                if (active_grid.workers) pool_print_stats(active_grid.workers->pool);
+                goto again;
+            }
+            if (command(&commands, l.string.items, "layout", "[rows|blocks]", "Show or set how the next grids store their cells (blocks need both sides to be multiples of the block size)")) {
+                if (lexer_next(&l) && l.token == TOKEN_NAME) {
+                    if (strcmp(l.string.items, "rows") == 0) {
+                        grid_set_layout(&active_grid, false);
+                    } else if (strcmp(l.string.items, "blocks") == 0) {
+                        grid_set_layout(&active_grid, true);
+                    } else {
+                        fprintf(stderr, "ERROR: unknown layout %s, expected rows or blocks\n", l.string.items);
+                        goto again;
+                    }
+                }
+                printf("Layout: %s\n", active_grid.want_blocked ? "blocks" : "rows");
+                goto again;
+            }
+            if (command(&commands, l.string.items, "engine", "[sweep|kinetic]", "Show or set how the next dense grids advance: random-order sweeps or continuous-time events")) {
+                if (lexer_next(&l) && l.token == TOKEN_NAME) {
+                    if (strcmp(l.string.items, "sweep") == 0) {
+                        grid_set_kinetic(&active_grid, false);
+                    } else if (strcmp(l.string.items, "kinetic") == 0) {
+                        grid_set_kinetic(&active_grid, true);
+                    } else {
+                        fprintf(stderr, "ERROR: unknown engine %s, expected sweep or kinetic\n", l.string.items);
+                        goto again;
+                    }
+                }
+                printf("Engine: %s\n", active_grid.want_kinetic ? "kinetic" : "sweep");
+                goto again;
+            }
+            if (command(&commands, l.string.items, "sparse", "[off | <colonies> <radius>]", "Show or set whether the next grids are sparse worlds, seeded with discs of density% instead of all over")) {
+                if (lexer_next(&l) && l.token == TOKEN_NAME) {
+                    if (strcmp(l.string.items, "off") == 0) {
+                        grid_set_sparse(&active_grid, false);
+                    } else {
+                        int n = atoi(l.string.items);
+                        int radius = lexer_next(&l) && l.token == TOKEN_NAME ? atoi(l.string.items) : colony_radius;
+                        if (n <= 0 || radius <= 0) {
+                            fprintf(stderr, "ERROR: expected off or a positive colony count and radius\n");
+                            goto again;
+                        }
+                        colonies = n;
+                        colony_radius = radius;
+                        grid_set_sparse(&active_grid, true);
+                    }
+                }
+                if (active_grid.want_sparse) {
+                    printf("Sparse: %d colonies of radius %d\n", colonies, colony_radius);
+                } else {
+                    printf("Sparse: off\n");
+                }
+                goto again;
+            }
+            if (command(&commands, l.string.items, "seed", "[n]", "Show the seed of the random stream or restart it from n")) {
+                if (lexer_next(&l) && l.token == TOKEN_NAME) {
+                    if (!parse_seed(l.string.items, &seed)) {
+                        fprintf(stderr, "ERROR: seed must be a number\n");
+                        goto again;
+                    }
+                    rng_seed(&ctx->rng, seed);
+                }
+                printf("Seed: %llu\n", (unsigned long long)seed);
+                goto again;
+            }
+            if (command(&commands, l.string.items, "gc", "[mode] [budget_MB]", "Show heap stats, switch mode (tracing, refcount) or set a heap budget")) {
+                gc_command(ctx, &l);
+                goto again;
+            }
             if (command(&commands, l.string.items, "ast", "<expr>", "print the AST of the expression")) {
                 Expr_Index expr;
-                if (!parse_expr(&l, &expr)) goto again;
+                if (!parse_expr(ctx, &l, &expr)) goto again;
                 if (!lexer_expect(&l, TOKEN_END)) goto again;
-                dump_expr_ast(expr);
+                dump_expr_ast(ctx, expr);
                 goto again;
             }
             if (command(&commands, l.string.items, "quit", "", "quit the REPL")) goto quit;
@@ -1134,20 +3629,20 @@ again:
 
         if (a == TOKEN_NAME && b == TOKEN_EQUALS) {
             if (!lexer_expect(&l, TOKEN_NAME)) goto again;
-            Symbol name = symbol(l.string.items);
+            Symbol name = symbol(ctx, l.string.items);
             if (!lexer_expect(&l, TOKEN_EQUALS)) goto again;
             Expr_Index body;
-            if (!parse_expr(&l, &body)) goto again;
+            if (!parse_expr(ctx, &l, &body)) goto again;
             if (!lexer_expect(&l, TOKEN_END)) goto again;
             create_binding(&bindings, name, body);
             goto again;
         }
 
         Expr_Index expr;
-        if (!parse_expr(&l, &expr)) goto again;
+        if (!parse_expr(ctx, &l, &expr)) goto again;
         if (!lexer_expect(&l, TOKEN_END)) goto again;
         for (size_t i = bindings.count; i > 0; --i) {
-            expr = replace(bindings.items[i-1].name, expr, bindings.items[i-1].body);
+            expr = replace(ctx, bindings.items[i-1].name, expr, bindings.items[i-1].body);
         }
 
         ctrl_c = 0;
@@ -1157,19 +3652,20 @@ again:
                 goto again;
             }
 
-            gc(expr, bindings);
+            gc(ctx, expr, bindings);
 
             Expr_Index expr1;
-            if (!eval1(expr, &expr1)) goto again;
+            if (!eval1(ctx, expr, &expr1)) goto again;
             if (expr.unwrap == expr1.unwrap) break;
             expr = expr1;
         }
 
         printf("RESULT: ");
-        trace_expr(expr);
+        trace_expr(ctx, expr);
         printf("\n");
     }
 quit:
+    free(record_path);
 
     return 0;
 }
@@ -8,14 +8,6 @@
 // GLOBAL VARIABLES
 // ============================================================================
 
-GC_Context GC = {0};
-
-static struct {
-    const char **items;
-    size_t count;
-    size_t capacity;
-} labels = {0};
-
 volatile sig_atomic_t ctrl_c = 0;
 
 // ============================================================================
@@ -113,6 +105,29 @@ int sb_appendf(String_Builder *sb, const char *fmt, ...)
     return n;
 }
 
+void bytes_put_varint(Bytes *b, uint64_t value)
+{
+    while (value >= 0x80) {
+        da_append(b, (uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    da_append(b, (uint8_t)value);
+}
+
+bool bytes_get_varint(const uint8_t **p, const uint8_t *end, uint64_t *value)
+{
+    uint64_t result = 0;
+    for (int shift = 0; *p < end && shift < 64; shift += 7) {
+        uint8_t byte = *(*p)++;
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
 // RETURNS:
 //  0 - file does not exists
 //  1 - file exists
@@ -134,6 +149,24 @@ int file_exists(const char *file_path)
 #endif
 }
 
+// Monotonic clock in microseconds (for time budgets and diagnostics)
+uint64_t time_now_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    // Whole seconds and remainder apart: freq need not be a multiple of 1MHz,
+    // and counter * 1000000 alone overflows after a few weeks of uptime
+    uint64_t ticks = (uint64_t)counter.QuadPart, hz = (uint64_t)freq.QuadPart;
+    return ticks / hz * 1000000 + ticks % hz * 1000000 / hz;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+#endif
+}
+
 bool read_entire_file(const char *path, String_Builder *sb)
 {
     FILE *f = fopen(path, "rb");
@@ -208,15 +241,15 @@ fail:
 // SYMBOL FUNCTIONS
 // ============================================================================
 
-const char *intern_label(const char *label)
+const char *intern_label(Lamb_Context *ctx, const char *label)
 {
-    for (size_t i = 0; i < labels.count; ++i) {
-        if (strcmp(labels.items[i], label) == 0) {
-            return labels.items[i];
+    for (size_t i = 0; i < ctx->labels.count; ++i) {
+        if (strcmp(ctx->labels.items[i], label) == 0) {
+            return ctx->labels.items[i];
         }
     }
     char *result = copy_string(label);
-    da_append(&labels, result);
+    da_append(&ctx->labels, result);
     return result;
 }
 
@@ -226,16 +259,15 @@ bool symbol_eq(Symbol a, Symbol b)
     return a.label == b.label && a.tag == b.tag;
 }
 
-Symbol symbol(const char *label)
+Symbol symbol(Lamb_Context *ctx, const char *label)
 {
-    Symbol s = { .label = intern_label(label), .tag = 0 };
+    Symbol s = { .label = intern_label(ctx, label), .tag = 0 };
     return s;
 }
 
-Symbol symbol_fresh(Symbol s)
+Symbol symbol_fresh(Lamb_Context *ctx, Symbol s)
 {
-    static size_t global_counter = 0;
-    s.tag = ++global_counter;
+    s.tag = ++ctx->fresh_counter;
     return s;
 }
 
@@ -243,161 +275,396 @@ Symbol symbol_fresh(Symbol s)
 // EXPRESSION MANAGEMENT
 // ============================================================================
 
-Expr_Index alloc_expr(void)
+static void gc_shade(Lamb_Context *ctx, Expr_Index expr);
+
+// Write barrier for every new reference to expr. Reference counting counts
+// it; an incremental cycle that is marking shades expr so the referrer never
+// ends up black with a white child.
+static void gc_write_barrier(Lamb_Context *ctx, Expr_Index expr)
+{
+    if (ctx->gc.mode == GC_MODE_REFCOUNT) {
+        expr_slot(ctx, expr).rc += 1;
+    } else if (ctx->gc.phase == GC_PHASE_MARK) {
+        gc_shade(ctx, expr);
+    }
+}
+
+static size_t gc_page_size(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+// Reserve the slot arena on first use, then commit it one chunk at a time
+static void gc_arena_grow(Lamb_Context *ctx)
+{
+    if (ctx->gc.slots.items == NULL) {
+        size_t bytes = GC_ARENA_RESERVE_BYTES;
+        void *base = NULL;
+        while (base == NULL && bytes >= GC_ARENA_COMMIT_BYTES) {
+#ifdef _WIN32
+            base = VirtualAlloc(NULL, bytes, MEM_RESERVE, PAGE_NOACCESS);
+#else
+            base = mmap(NULL, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (base == MAP_FAILED) base = NULL;
+#endif
+            if (base == NULL) bytes /= 2;
+        }
+        if (base == NULL) {
+            fprintf(stderr, "ERROR: could not reserve address space for the node heap\n");
+            abort();
+        }
+        ctx->gc.slots.items = base;
+        ctx->gc.slots.reserved = bytes / sizeof(Expr);
+    }
+
+    size_t committed = ctx->gc.slots.capacity * sizeof(Expr);
+    size_t chunk = GC_ARENA_COMMIT_BYTES;
+    size_t limit = ctx->gc.slots.reserved * sizeof(Expr);
+    if (committed + chunk > limit) chunk = limit - committed;
+    // Commit whole pages only; a node may straddle the old boundary
+    size_t page = gc_page_size();
+    size_t start = committed / page * page;
+    size_t end = (committed + chunk) / page * page;
+    if (end <= committed) {
+        fprintf(stderr, "ERROR: node heap is full (%zu nodes)\n", ctx->gc.slots.capacity);
+        abort();
+    }
+#ifdef _WIN32
+    bool ok = VirtualAlloc((char*)ctx->gc.slots.items + start, end - start, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+    bool ok = mprotect((char*)ctx->gc.slots.items + start, end - start, PROT_READ | PROT_WRITE) == 0;
+#endif
+    if (!ok) {
+        fprintf(stderr, "ERROR: could not commit memory for the node heap: %s\n", strerror(errno));
+        abort();
+    }
+    ctx->gc.slots.capacity = end / sizeof(Expr);
+}
+
+void gc_arena_trim(Lamb_Context *ctx)
+{
+    if (ctx->gc.slots.items == NULL) return;
+    size_t page = gc_page_size();
+    size_t keep = (ctx->gc.slots.count * sizeof(Expr) + page - 1) / page * page;
+    size_t committed = (ctx->gc.slots.capacity * sizeof(Expr) + page - 1) / page * page;
+    if (keep >= committed) return;
+#ifdef _WIN32
+    VirtualFree((char*)ctx->gc.slots.items + keep, committed - keep, MEM_DECOMMIT);
+    ctx->gc.slots.capacity = keep / sizeof(Expr);
+#else
+    // The pages stay mapped and come back zeroed on the next touch
+    madvise((char*)ctx->gc.slots.items + keep, committed - keep, MADV_DONTNEED);
+#endif
+}
+
+Expr_Index alloc_expr(Lamb_Context *ctx)
 {
     Expr_Index result;
-    if (GC.dead.count > 0) {
-        result = GC.dead.items[--GC.dead.count];
+    if (ctx->gc.dead.count > 0) {
+        result = ctx->gc.dead.items[--ctx->gc.dead.count];
     } else {
-        result.unwrap = GC.slots.count;
-        Expr expr = {0};
-        da_append(&GC.slots, expr);
+        if (ctx->gc.slots.count == ctx->gc.slots.capacity) gc_arena_grow(ctx);
+        result.unwrap = ctx->gc.slots.count++;
+        expr_slot_unsafe(ctx, result) = (Expr){0};
     }
-    assert(!expr_slot_unsafe(result).live);
-    expr_slot_unsafe(result).live = true;
-    da_append(&GC.gens[GC.gen_cur], result);
+    assert(!expr_slot_unsafe(ctx, result).live);
+    expr_slot_unsafe(ctx, result).live = true;
+    expr_slot_unsafe(ctx, result).visited = false;
+    expr_slot_unsafe(ctx, result).old = false;
+    expr_slot_unsafe(ctx, result).age = 0;
+    expr_slot_unsafe(ctx, result).rc = 0;
+    expr_slot_unsafe(ctx, result).hash = 0;
+    da_append(&ctx->gc.young, result);
+    ctx->gc.allocated += 1;
     return result;
 }
 
-void free_expr(Expr_Index expr)
+void free_expr(Lamb_Context *ctx, Expr_Index expr)
 {
-    expr_slot(expr).live = false;
-    da_append(&GC.dead, expr);
+    expr_slot(ctx, expr).live = false;
+    da_append(&ctx->gc.dead, expr);
 }
 
-Expr_Index var(Symbol name)
+Expr_Index var(Lamb_Context *ctx, Symbol name)
 {
-    Expr_Index expr = alloc_expr();
-    expr_slot(expr).kind = EXPR_VAR;
-    expr_slot(expr).as.var = name;
+    Expr_Index expr = alloc_expr(ctx);
+    expr_slot(ctx, expr).kind = EXPR_VAR;
+    expr_slot(ctx, expr).as.var = name;
     return expr;
 }
 
-Expr_Index magic(const char *label)
+Expr_Index magic(Lamb_Context *ctx, const char *label)
 {
-    Expr_Index expr = alloc_expr();
-    expr_slot(expr).kind = EXPR_MAG;
-    expr_slot(expr).as.mag = intern_label(label);
+    Expr_Index expr = alloc_expr(ctx);
+    expr_slot(ctx, expr).kind = EXPR_MAG;
+    expr_slot(ctx, expr).as.mag = intern_label(ctx, label);
     return expr;
 }
 
-Expr_Index fun(Symbol param, Expr_Index body)
+Expr_Index fun(Lamb_Context *ctx, Symbol param, Expr_Index body)
 {
-    Expr_Index expr = alloc_expr();
-    expr_slot(expr).kind = EXPR_FUN;
-    expr_slot(expr).as.fun.param = param;
-    expr_slot(expr).as.fun.body = body;
+    gc_write_barrier(ctx, body);
+    Expr_Index expr = alloc_expr(ctx);
+    expr_slot(ctx, expr).kind = EXPR_FUN;
+    expr_slot(ctx, expr).as.fun.param = param;
+    expr_slot(ctx, expr).as.fun.body = body;
     return expr;
 }
 
-Expr_Index app(Expr_Index lhs, Expr_Index rhs)
+Expr_Index app(Lamb_Context *ctx, Expr_Index lhs, Expr_Index rhs)
 {
-    Expr_Index expr = alloc_expr();
-    expr_slot(expr).kind = EXPR_APP;
-    expr_slot(expr).as.app.lhs = lhs;
-    expr_slot(expr).as.app.rhs = rhs;
+    gc_write_barrier(ctx, lhs);
+    gc_write_barrier(ctx, rhs);
+    Expr_Index expr = alloc_expr(ctx);
+    expr_slot(ctx, expr).kind = EXPR_APP;
+    expr_slot(ctx, expr).as.app.lhs = lhs;
+    expr_slot(ctx, expr).as.app.rhs = rhs;
     return expr;
 }
 
+static Symbol symbol_copy(Lamb_Context *dst, Symbol s, size_t fresh_from)
+{
+    Symbol result = { .label = intern_label(dst, s.label), .tag = s.tag };
+    if (s.tag < fresh_from) return result;
+    for (size_t i = 0; i < dst->copy_tags.count; i += 2) {
+        if (dst->copy_tags.items[i] == s.tag) {
+            result.tag = dst->copy_tags.items[i + 1];
+            return result;
+        }
+    }
+    result.tag = ++dst->fresh_counter;
+    da_append(&dst->copy_tags, s.tag);
+    da_append(&dst->copy_tags, result.tag);
+    return result;
+}
+
+static Expr_Index expr_copy_rec(Lamb_Context *dst, Lamb_Context *src, Expr_Index expr, size_t fresh_from)
+{
+    Expr *e = &expr_slot(src, expr);
+    Expr_Index result;
+    switch (e->kind) {
+    case EXPR_VAR:
+        result = var(dst, symbol_copy(dst, e->as.var, fresh_from));
+        break;
+    case EXPR_MAG:
+        result = magic(dst, e->as.mag);
+        break;
+    case EXPR_FUN: {
+        Symbol param = symbol_copy(dst, e->as.fun.param, fresh_from);
+        result = fun(dst, param, expr_copy_rec(dst, src, e->as.fun.body, fresh_from));
+        break;
+    }
+    case EXPR_APP: {
+        Expr_Index lhs = expr_copy_rec(dst, src, e->as.app.lhs, fresh_from);
+        Expr_Index rhs = expr_copy_rec(dst, src, e->as.app.rhs, fresh_from);
+        result = app(dst, lhs, rhs);
+        break;
+    }
+    default: UNREACHABLE("Expr_Kind");
+    }
+    // Only closed terms carry a hash, and renaming their tags keeps them
+    // alpha-equivalent
+    expr_slot(dst, result).hash = e->hash;
+    return result;
+}
+
+// Labels are interned again in dst. Tags from fresh_from up are replaced by
+// fresh dst tags in the order they are met, the others are kept. Only reads
+// src, so several threads may copy out of the same context as long as nobody
+// allocates in it meanwhile.
+Expr_Index expr_copy(Lamb_Context *dst, Lamb_Context *src, Expr_Index expr, size_t fresh_from)
+{
+    assert(dst != src);
+    dst->copy_tags.count = 0;
+    return expr_copy_rec(dst, src, expr, fresh_from);
+}
+
+// Prefix form: a kind byte, then for a VAR its label (NUL terminated) and
+// tag, for a MAG its label, for a FUN its parameter and body, for an APP both
+// sides. Decoding gives back the same labels and tags.
+static void encode_symbol(Bytes *out, const char *label, size_t tag)
+{
+    for (const char *c = label; *c; ++c) da_append(out, (uint8_t)*c);
+    da_append(out, 0);
+    bytes_put_varint(out, tag);
+}
+
+void expr_encode(Lamb_Context *ctx, Expr_Index expr, Bytes *out)
+{
+    Expr *e = &expr_slot(ctx, expr);
+    da_append(out, (uint8_t)e->kind);
+    switch (e->kind) {
+    case EXPR_VAR:
+        encode_symbol(out, e->as.var.label, e->as.var.tag);
+        break;
+    case EXPR_MAG:
+        for (const char *c = e->as.mag; *c; ++c) da_append(out, (uint8_t)*c);
+        da_append(out, 0);
+        break;
+    case EXPR_FUN:
+        encode_symbol(out, e->as.fun.param.label, e->as.fun.param.tag);
+        expr_encode(ctx, e->as.fun.body, out);
+        break;
+    case EXPR_APP:
+        expr_encode(ctx, e->as.app.lhs, out);
+        expr_encode(ctx, e->as.app.rhs, out);
+        break;
+    default: UNREACHABLE("Expr_Kind");
+    }
+}
+
+static bool decode_label(const uint8_t **p, const uint8_t *end, const char **label)
+{
+    const uint8_t *nul = memchr(*p, 0, (size_t)(end - *p));
+    if (!nul) return false;
+    *label = (const char *)*p;
+    *p = nul + 1;
+    return true;
+}
+
+static bool decode_symbol(Lamb_Context *ctx, const uint8_t **p, const uint8_t *end, Symbol *s)
+{
+    const char *label;
+    uint64_t tag;
+    if (!decode_label(p, end, &label) || !bytes_get_varint(p, end, &tag)) return false;
+    *s = symbol(ctx, label);
+    s->tag = (size_t)tag;
+    return true;
+}
+
+bool expr_decode(Lamb_Context *ctx, const uint8_t **p, const uint8_t *end, Expr_Index *expr)
+{
+    if (*p >= end) return false;
+    switch (*(*p)++) {
+    case EXPR_VAR: {
+        Symbol name;
+        if (!decode_symbol(ctx, p, end, &name)) return false;
+        *expr = var(ctx, name);
+        return true;
+    }
+    case EXPR_MAG: {
+        const char *label;
+        if (!decode_label(p, end, &label)) return false;
+        *expr = magic(ctx, label);
+        return true;
+    }
+    case EXPR_FUN: {
+        Symbol param;
+        Expr_Index body;
+        if (!decode_symbol(ctx, p, end, &param) || !expr_decode(ctx, p, end, &body)) return false;
+        *expr = fun(ctx, param, body);
+        return true;
+    }
+    case EXPR_APP: {
+        Expr_Index lhs, rhs;
+        if (!expr_decode(ctx, p, end, &lhs) || !expr_decode(ctx, p, end, &rhs)) return false;
+        *expr = app(ctx, lhs, rhs);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
 // ============================================================================
 // EXPRESSION DISPLAY
 // ============================================================================
 
-void expr_display(Expr_Index expr, String_Builder *sb)
+void expr_display(Lamb_Context *ctx, Expr_Index expr, String_Builder *sb)
 {
-    switch (expr_slot(expr).kind) {
+    switch (expr_slot(ctx, expr).kind) {
     case EXPR_VAR:
-        sb_appendf(sb, "%s", expr_slot(expr).as.var.label);
-        if (expr_slot(expr).as.var.tag) {
-            sb_appendf(sb, ":%zu", expr_slot(expr).as.var.tag);
+        sb_appendf(sb, "%s", expr_slot(ctx, expr).as.var.label);
+        if (expr_slot(ctx, expr).as.var.tag) {
+            sb_appendf(sb, ":%zu", expr_slot(ctx, expr).as.var.tag);
         }
         break;
     case EXPR_FUN:
         sb_appendf(sb, "\\");
-        while (expr_slot(expr).kind == EXPR_FUN) {
-            if (expr_slot(expr).as.fun.param.tag) {
-                sb_appendf(sb, "%s:%zu.", expr_slot(expr).as.fun.param.label, expr_slot(expr).as.fun.param.tag);
+        while (expr_slot(ctx, expr).kind == EXPR_FUN) {
+            if (expr_slot(ctx, expr).as.fun.param.tag) {
+                sb_appendf(sb, "%s:%zu.", expr_slot(ctx, expr).as.fun.param.label, expr_slot(ctx, expr).as.fun.param.tag);
             } else {
-                sb_appendf(sb, "%s.", expr_slot(expr).as.fun.param.label);
+                sb_appendf(sb, "%s.", expr_slot(ctx, expr).as.fun.param.label);
             }
-            expr = expr_slot(expr).as.fun.body;
+            expr = expr_slot(ctx, expr).as.fun.body;
         }
-        expr_display(expr, sb);
+        expr_display(ctx, expr, sb);
         break;
     case EXPR_APP: {
-        Expr_Index lhs = expr_slot(expr).as.app.lhs;
-        bool lhs_paren = expr_slot(lhs).kind == EXPR_FUN;
+        Expr_Index lhs = expr_slot(ctx, expr).as.app.lhs;
+        bool lhs_paren = expr_slot(ctx, lhs).kind == EXPR_FUN;
         if (lhs_paren) sb_appendf(sb, "(");
-        expr_display(lhs, sb);
+        expr_display(ctx, lhs, sb);
         if (lhs_paren) sb_appendf(sb, ")");
 
         sb_appendf(sb, " ");
 
-        Expr_Index rhs = expr_slot(expr).as.app.rhs;
-        bool rhs_paren = expr_slot(rhs).kind != EXPR_VAR && expr_slot(rhs).kind != EXPR_MAG;
+        Expr_Index rhs = expr_slot(ctx, expr).as.app.rhs;
+        bool rhs_paren = expr_slot(ctx, rhs).kind != EXPR_VAR && expr_slot(ctx, rhs).kind != EXPR_MAG;
         if (rhs_paren) sb_appendf(sb, "(");
-        expr_display(rhs, sb);
+        expr_display(ctx, rhs, sb);
         if (rhs_paren) sb_appendf(sb, ")");
     } break;
     case EXPR_MAG: {
-        sb_appendf(sb, "#%s", expr_slot(expr).as.mag);
+        sb_appendf(sb, "#%s", expr_slot(ctx, expr).as.mag);
     } break;
     default: UNREACHABLE("Expr_Kind");
     }
 }
 
 // Display expression without tags (for serialization)
-void expr_display_no_tags(Expr_Index expr, String_Builder *sb)
+void expr_display_no_tags(Lamb_Context *ctx, Expr_Index expr, String_Builder *sb)
 {
-    switch (expr_slot(expr).kind) {
+    switch (expr_slot(ctx, expr).kind) {
     case EXPR_VAR:
-        sb_appendf(sb, "%s", expr_slot(expr).as.var.label);
+        sb_appendf(sb, "%s", expr_slot(ctx, expr).as.var.label);
         // Skip tag output
         break;
     case EXPR_FUN:
         sb_appendf(sb, "\\");
-        while (expr_slot(expr).kind == EXPR_FUN) {
-            sb_appendf(sb, "%s.", expr_slot(expr).as.fun.param.label);
+        while (expr_slot(ctx, expr).kind == EXPR_FUN) {
+            sb_appendf(sb, "%s.", expr_slot(ctx, expr).as.fun.param.label);
             // Skip tag output
-            expr = expr_slot(expr).as.fun.body;
+            expr = expr_slot(ctx, expr).as.fun.body;
         }
-        expr_display_no_tags(expr, sb);
+        expr_display_no_tags(ctx, expr, sb);
         break;
     case EXPR_APP: {
-        Expr_Index lhs = expr_slot(expr).as.app.lhs;
-        bool lhs_paren = expr_slot(lhs).kind == EXPR_FUN;
+        Expr_Index lhs = expr_slot(ctx, expr).as.app.lhs;
+        bool lhs_paren = expr_slot(ctx, lhs).kind == EXPR_FUN;
         if (lhs_paren) sb_appendf(sb, "(");
-        expr_display_no_tags(lhs, sb);
+        expr_display_no_tags(ctx, lhs, sb);
         if (lhs_paren) sb_appendf(sb, ")");
 
         sb_appendf(sb, " ");
 
-        Expr_Index rhs = expr_slot(expr).as.app.rhs;
-        bool rhs_paren = expr_slot(rhs).kind != EXPR_VAR && expr_slot(rhs).kind != EXPR_MAG;
+        Expr_Index rhs = expr_slot(ctx, expr).as.app.rhs;
+        bool rhs_paren = expr_slot(ctx, rhs).kind != EXPR_VAR && expr_slot(ctx, rhs).kind != EXPR_MAG;
         if (rhs_paren) sb_appendf(sb, "(");
-        expr_display_no_tags(rhs, sb);
+        expr_display_no_tags(ctx, rhs, sb);
         if (rhs_paren) sb_appendf(sb, ")");
     } break;
     case EXPR_MAG: {
-        sb_appendf(sb, "#%s", expr_slot(expr).as.mag);
+        sb_appendf(sb, "#%s", expr_slot(ctx, expr).as.mag);
     } break;
     default: UNREACHABLE("Expr_Kind");
     }
 }
 
-void dump_expr_ast(Expr_Index expr)
+void dump_expr_ast(Lamb_Context *ctx, Expr_Index expr)
 {
-    static struct {
-        bool *items;
-        size_t count;
-        size_t capacity;
-    } stack = {0};
-
-    for (size_t i = 0; i < stack.count; ++i) {
-        if (i + 1 == stack.count) {
+    for (size_t i = 0; i < ctx->ast_stack.count; ++i) {
+        if (i + 1 == ctx->ast_stack.count) {
             printf("+--");
         } else {
-            if (stack.items[i]) {
+            if (ctx->ast_stack.items[i]) {
                 printf("|  ");
             } else {
                 printf("   ");
@@ -405,86 +672,177 @@ void dump_expr_ast(Expr_Index expr)
         }
     }
 
-    switch (expr_slot(expr).kind) {
+    switch (expr_slot(ctx, expr).kind) {
     case EXPR_VAR:
-        if (expr_slot(expr).as.var.tag == 0) {
-            printf("[VAR] %s\n", expr_slot(expr).as.var.label);
+        if (expr_slot(ctx, expr).as.var.tag == 0) {
+            printf("[VAR] %s\n", expr_slot(ctx, expr).as.var.label);
         } else {
-            printf("[VAR] %s:%zu\n", expr_slot(expr).as.var.label, expr_slot(expr).as.var.tag);
+            printf("[VAR] %s:%zu\n", expr_slot(ctx, expr).as.var.label, expr_slot(ctx, expr).as.var.tag);
         }
         break;
     case EXPR_FUN:
-        if (expr_slot(expr).as.fun.param.tag == 0) {
-            printf("[FUN] \\%s\n", expr_slot(expr).as.fun.param.label);
+        if (expr_slot(ctx, expr).as.fun.param.tag == 0) {
+            printf("[FUN] \\%s\n", expr_slot(ctx, expr).as.fun.param.label);
         } else {
-            printf("[FUN] \\%s:%zu\n", expr_slot(expr).as.fun.param.label, expr_slot(expr).as.fun.param.tag);
+            printf("[FUN] \\%s:%zu\n", expr_slot(ctx, expr).as.fun.param.label, expr_slot(ctx, expr).as.fun.param.tag);
         }
-        da_append(&stack, false); {
-            dump_expr_ast(expr_slot(expr).as.fun.body);
-        } stack.count -= 1;
+        da_append(&ctx->ast_stack, false); {
+            dump_expr_ast(ctx, expr_slot(ctx, expr).as.fun.body);
+        } ctx->ast_stack.count -= 1;
         break;
     case EXPR_APP:
         printf("[APP]\n");
-        da_append(&stack, true); {
-            dump_expr_ast(expr_slot(expr).as.app.lhs);
-        } stack.count -= 1;
-        da_append(&stack, false); {
-            dump_expr_ast(expr_slot(expr).as.app.rhs);
-        } stack.count -= 1;
+        da_append(&ctx->ast_stack, true); {
+            dump_expr_ast(ctx, expr_slot(ctx, expr).as.app.lhs);
+        } ctx->ast_stack.count -= 1;
+        da_append(&ctx->ast_stack, false); {
+            dump_expr_ast(ctx, expr_slot(ctx, expr).as.app.rhs);
+        } ctx->ast_stack.count -= 1;
         break;
     case EXPR_MAG:
-        printf("[MAG] #%s\n", expr_slot(expr).as.mag);
+        printf("[MAG] #%s\n", expr_slot(ctx, expr).as.mag);
         break;
     default:
         UNREACHABLE("Expr_Index");
     }
 }
 
-void trace_expr(Expr_Index expr)
+void trace_expr(Lamb_Context *ctx, Expr_Index expr)
 {
-    static String_Builder sb = {0};
-    sb.count = 0;
-    expr_display(expr, &sb);
-    sb_append_null(&sb);
-    printf("%s", sb.items);
+    ctx->trace_sb.count = 0;
+    expr_display(ctx, expr, &ctx->trace_sb);
+    sb_append_null(&ctx->trace_sb);
+    printf("%s", ctx->trace_sb.items);
 }
 
 // Helper: Convert expression to malloc'd string
-char *expr_to_string(Expr_Index expr) {
+char *expr_to_string(Lamb_Context *ctx, Expr_Index expr) {
     String_Builder sb = {0};
-    expr_display(expr, &sb);
+    expr_display(ctx, expr, &sb);
     sb_append_null(&sb);
     return sb.items; // Ownership transferred to caller
 }
 
 // Calculate the "mass" or complexity of an expression (number of AST nodes)
-size_t expr_mass(Expr_Index expr) {
-    if (!expr_slot(expr).live) return 0;
-    switch (expr_slot(expr).kind) {
+size_t expr_mass(Lamb_Context *ctx, Expr_Index expr) {
+    if (!expr_slot(ctx, expr).live) return 0;
+    switch (expr_slot(ctx, expr).kind) {
         case EXPR_VAR: return 1;
         case EXPR_MAG: return 1;
-        case EXPR_FUN: return 1 + expr_mass(expr_slot(expr).as.fun.body);
-        case EXPR_APP: return 1 + expr_mass(expr_slot(expr).as.app.lhs) + 
-                                  expr_mass(expr_slot(expr).as.app.rhs);
+        case EXPR_FUN: return 1 + expr_mass(ctx, expr_slot(ctx, expr).as.fun.body);
+        case EXPR_APP: return 1 + expr_mass(ctx, expr_slot(ctx, expr).as.app.lhs) + 
+                                  expr_mass(ctx, expr_slot(ctx, expr).as.app.rhs);
         default: return 0;
     }
 }
 
+static uint64_t hash_mix(uint64_t h)
+{
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    return h ^ (h >> 31);
+}
+
+static uint64_t hash_combine(uint64_t h, uint64_t v)
+{
+    return hash_mix(h ^ (v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2)));
+}
+
+static uint64_t hash_label(const char *label)
+{
+    uint64_t h = 0xcbf29ce484222325ull;  // FNV-1a
+    for (const char *c = label; *c; ++c) h = (h ^ (uint8_t)*c) * 0x100000001b3ull;
+    return h;
+}
+
+typedef struct {
+    Symbol *items;
+    size_t count;
+    size_t capacity;
+} Binders;
+
+// Seeds of the node kinds
+enum { HASH_BOUND = 1, HASH_FREE, HASH_MAG, HASH_FUN, HASH_APP };
+
+// Hash of the de Bruijn form: bound variables by how many binders up they
+// point, free ones by name. *lowest gets the outermost binder the subterm
+// points at (1 + its place in binders, 0 for a free variable, SIZE_MAX for
+// none), so a subterm is closed when that binder is its own.
+static uint64_t expr_hash_rec(Lamb_Context *ctx, Expr_Index expr, Binders *binders, size_t *lowest)
+{
+    Expr *e = &expr_slot(ctx, expr);
+    *lowest = SIZE_MAX;
+    if (e->hash) return e->hash;
+    size_t depth = binders->count;
+    uint64_t h = 0;
+    switch (e->kind) {
+    case EXPR_VAR: {
+        size_t i = depth;
+        while (i > 0 && !symbol_eq(binders->items[i - 1], e->as.var)) --i;
+        if (i > 0) {
+            *lowest = i;
+            return hash_combine(HASH_BOUND, depth - i);
+        }
+        *lowest = 0;
+        return hash_combine(hash_combine(HASH_FREE, hash_label(e->as.var.label)), e->as.var.tag);
+    }
+    case EXPR_MAG:
+        h = hash_combine(HASH_MAG, hash_label(e->as.mag));
+        break;
+    case EXPR_FUN:
+        da_append(binders, e->as.fun.param);
+        h = hash_combine(HASH_FUN, expr_hash_rec(ctx, e->as.fun.body, binders, lowest));
+        binders->count--;
+        break;
+    case EXPR_APP: {
+        size_t lhs_lowest, rhs_lowest;
+        uint64_t lhs = expr_hash_rec(ctx, e->as.app.lhs, binders, &lhs_lowest);
+        uint64_t rhs = expr_hash_rec(ctx, e->as.app.rhs, binders, &rhs_lowest);
+        h = hash_combine(hash_combine(HASH_APP, lhs), rhs);
+        *lowest = lhs_lowest < rhs_lowest ? lhs_lowest : rhs_lowest;
+        break;
+    }
+    default: UNREACHABLE("Expr_Kind");
+    }
+    if (*lowest <= depth) return h;
+
+    // Closed: the same wherever it occurs, so keep it with the node
+    if (h == 0) h = 1;
+    e->hash = h;
+    *lowest = SIZE_MAX;
+    return h;
+}
+
+// Alpha-equivalent terms hash the same. Nodes never change after
+// construction, so closed subterms keep their hash and the next call on
+// them is O(1). Only writes nodes that have no hash yet.
+uint64_t expr_hash(Lamb_Context *ctx, Expr_Index expr)
+{
+    if (expr_slot(ctx, expr).hash) return expr_slot(ctx, expr).hash;
+    Binders binders = {0};
+    size_t lowest;
+    uint64_t h = expr_hash_rec(ctx, expr, &binders, &lowest);
+    free(binders.items);
+    return h ? h : 1;
+}
+
 // ============================================================================
 // EVALUATION
 // ============================================================================
 
-bool is_var_free_there(Symbol name, Expr_Index there)
+bool is_var_free_there(Lamb_Context *ctx, Symbol name, Expr_Index there)
 {
-    switch (expr_slot(there).kind) {
+    switch (expr_slot(ctx, there).kind) {
     case EXPR_VAR:
-        return symbol_eq(expr_slot(there).as.var, name);
+        return symbol_eq(expr_slot(ctx, there).as.var, name);
     case EXPR_FUN:
-        if (symbol_eq(expr_slot(there).as.fun.param, name)) return false;
-        return is_var_free_there(name, expr_slot(there).as.fun.body);
+        if (symbol_eq(expr_slot(ctx, there).as.fun.param, name)) return false;
+        return is_var_free_there(ctx, name, expr_slot(ctx, there).as.fun.body);
     case EXPR_APP:
-        if (is_var_free_there(name, expr_slot(there).as.app.lhs)) return true;
-        if (is_var_free_there(name, expr_slot(there).as.app.rhs)) return true;
+        if (is_var_free_there(ctx, name, expr_slot(ctx, there).as.app.lhs)) return true;
+        if (is_var_free_there(ctx, name, expr_slot(ctx, there).as.app.rhs)) return true;
         return false;
     case EXPR_MAG:
         return false;
@@ -492,105 +850,105 @@ bool is_var_free_there(Symbol name, Expr_Index there)
     }
 }
 
-Expr_Index replace(Symbol param, Expr_Index body, Expr_Index arg)
+Expr_Index replace(Lamb_Context *ctx, Symbol param, Expr_Index body, Expr_Index arg)
 {
-    switch (expr_slot(body).kind) {
+    switch (expr_slot(ctx, body).kind) {
     case EXPR_MAG:
         return body;
     case EXPR_VAR:
-        if (symbol_eq(expr_slot(body).as.var, param)) {
+        if (symbol_eq(expr_slot(ctx, body).as.var, param)) {
             return arg;
         } else {
             return body;
         }
     case EXPR_FUN:
-        if (symbol_eq(expr_slot(body).as.fun.param, param)) return body;
-        if (!is_var_free_there(expr_slot(body).as.fun.param, arg)) {
-            return fun(expr_slot(body).as.fun.param, replace(param, expr_slot(body).as.fun.body, arg));
+        if (symbol_eq(expr_slot(ctx, body).as.fun.param, param)) return body;
+        if (!is_var_free_there(ctx, expr_slot(ctx, body).as.fun.param, arg)) {
+            return fun(ctx, expr_slot(ctx, body).as.fun.param, replace(ctx, param, expr_slot(ctx, body).as.fun.body, arg));
         }
-        Symbol fresh_param_name = symbol_fresh(expr_slot(body).as.fun.param);
-        Expr_Index fresh_param = var(fresh_param_name);
-        return fun(
+        Symbol fresh_param_name = symbol_fresh(ctx, expr_slot(ctx, body).as.fun.param);
+        Expr_Index fresh_param = var(ctx, fresh_param_name);
+        return fun(ctx, 
             fresh_param_name,
-            replace(param,
-                replace(
-                    expr_slot(body).as.fun.param,
-                    expr_slot(body).as.fun.body,
+            replace(ctx, param,
+                replace(ctx, 
+                    expr_slot(ctx, body).as.fun.param,
+                    expr_slot(ctx, body).as.fun.body,
                     fresh_param),
                 arg));
     case EXPR_APP:
-        return app(
-            replace(param, expr_slot(body).as.app.lhs, arg),
-            replace(param, expr_slot(body).as.app.rhs, arg));
+        return app(ctx, 
+            replace(ctx, param, expr_slot(ctx, body).as.app.lhs, arg),
+            replace(ctx, param, expr_slot(ctx, body).as.app.rhs, arg));
     default: UNREACHABLE("Expr_Kind");
     }
 }
 
-bool eval1(Expr_Index expr, Expr_Index *expr1)
+bool eval1(Lamb_Context *ctx, Expr_Index expr, Expr_Index *expr1)
 {
-    switch (expr_slot(expr).kind) {
+    switch (expr_slot(ctx, expr).kind) {
     case EXPR_VAR:
         *expr1 = expr;
         return true;
     case EXPR_FUN: {
         Expr_Index body;
-        if (!eval1(expr_slot(expr).as.fun.body, &body)) return false;
-        if (body.unwrap != expr_slot(expr).as.fun.body.unwrap) {
-            *expr1 = fun(expr_slot(expr).as.fun.param, body);
+        if (!eval1(ctx, expr_slot(ctx, expr).as.fun.body, &body)) return false;
+        if (body.unwrap != expr_slot(ctx, expr).as.fun.body.unwrap) {
+            *expr1 = fun(ctx, expr_slot(ctx, expr).as.fun.param, body);
         } else {
             *expr1 = expr;
         }
         return true;
     }
     case EXPR_APP: {
-        Expr_Index lhs = expr_slot(expr).as.app.lhs;
-        Expr_Index rhs = expr_slot(expr).as.app.rhs;
+        Expr_Index lhs = expr_slot(ctx, expr).as.app.lhs;
+        Expr_Index rhs = expr_slot(ctx, expr).as.app.rhs;
 
-        if (expr_slot(lhs).kind == EXPR_FUN) {
-            *expr1 = replace(
-                expr_slot(lhs).as.fun.param,
-                expr_slot(lhs).as.fun.body,
+        if (expr_slot(ctx, lhs).kind == EXPR_FUN) {
+            *expr1 = replace(ctx, 
+                expr_slot(ctx, lhs).as.fun.param,
+                expr_slot(ctx, lhs).as.fun.body,
                 rhs);
             return true;
-        } else if (expr_slot(lhs).kind == EXPR_MAG) {
-            if (expr_slot(lhs).as.mag == intern_label("trace")) {
+        } else if (expr_slot(ctx, lhs).kind == EXPR_MAG) {
+            if (expr_slot(ctx, lhs).as.mag == intern_label(ctx, "trace")) {
                 Expr_Index new_rhs;
-                if (!eval1(rhs, &new_rhs)) return false;
+                if (!eval1(ctx, rhs, &new_rhs)) return false;
                 if (new_rhs.unwrap == rhs.unwrap) {
                     printf("TRACE: ");
-                    trace_expr(rhs);
+                    trace_expr(ctx, rhs);
                     printf("\n");
                     *expr1 = rhs;
                 } else {
-                    *expr1 = app(lhs, new_rhs);
+                    *expr1 = app(ctx, lhs, new_rhs);
                 }
                 return true;
-            } else if (expr_slot(lhs).as.mag == intern_label("void")) {
+            } else if (expr_slot(ctx, lhs).as.mag == intern_label(ctx, "void")) {
                 Expr_Index new_rhs;
-                if (!eval1(rhs, &new_rhs)) return false;
+                if (!eval1(ctx, rhs, &new_rhs)) return false;
                 if (new_rhs.unwrap == rhs.unwrap) {
                     *expr1 = lhs;
                 } else {
-                    *expr1 = app(lhs, new_rhs);
+                    *expr1 = app(ctx, lhs, new_rhs);
                 }
                 return true;
             } else {
-                printf("ERROR: unknown magic #%s\n", expr_slot(lhs).as.mag);
+                printf("ERROR: unknown magic #%s\n", expr_slot(ctx, lhs).as.mag);
                 return false;
             }
         }
 
         Expr_Index new_lhs;
-        if (!eval1(lhs, &new_lhs)) return false;
+        if (!eval1(ctx, lhs, &new_lhs)) return false;
         if (lhs.unwrap != new_lhs.unwrap) {
-            *expr1 = app(new_lhs, rhs);
+            *expr1 = app(ctx, new_lhs, rhs);
             return true;
         }
 
         Expr_Index new_rhs;
-        if (!eval1(rhs, &new_rhs)) return false;
+        if (!eval1(ctx, rhs, &new_rhs)) return false;
         if (rhs.unwrap != new_rhs.unwrap) {
-            *expr1 = app(lhs, new_rhs);
+            *expr1 = app(ctx, lhs, new_rhs);
             return true;
         }
 
@@ -604,15 +962,15 @@ bool eval1(Expr_Index expr, Expr_Index *expr1)
     }
 }
 
-Eval_Result eval_bounded(Expr_Index start, Expr_Index *out, size_t limit, size_t max_mass) {
+Eval_Result eval_bounded(Lamb_Context *ctx, Expr_Index start, Expr_Index *out, size_t limit, size_t max_mass) {
     Expr_Index curr = start;
     for (size_t i = 0; i < limit; ++i) {
         // SAFETY CHECK: If the molecule gets too big, it's "unstable" -> kill it.
         // Prevents eval1() from choking on massive substitutions / deep copies.
-        if (max_mass > 0 && expr_mass(curr) > max_mass) return EVAL_LIMIT;
+        if (max_mass > 0 && expr_mass(ctx, curr) > max_mass) return EVAL_LIMIT;
 
         Expr_Index next;
-        if (!eval1(curr, &next)) return EVAL_ERROR;
+        if (!eval1(ctx, curr, &next)) return EVAL_ERROR;
         if (curr.unwrap == next.unwrap) {
             *out = curr;
             return EVAL_DONE;
@@ -782,10 +1140,10 @@ bool lexer_expect(Lexer *l, Token_Kind expected)
     return true;
 }
 
-bool parse_fun(Lexer *l, Expr_Index *expr)
+bool parse_fun(Lamb_Context *ctx, Lexer *l, Expr_Index *expr)
 {
     if (!lexer_expect(l, TOKEN_NAME)) return false;
-    Symbol arg = symbol(l->string.items);
+    Symbol arg = symbol(ctx, l->string.items);
     if (!lexer_expect(l, TOKEN_DOT)) return false;
 
     Token_Kind a, b;
@@ -798,29 +1156,29 @@ bool parse_fun(Lexer *l, Expr_Index *expr)
 
     Expr_Index body;
     if (a == TOKEN_NAME && b == TOKEN_DOT) {
-        if (!parse_fun(l, &body)) return false;
+        if (!parse_fun(ctx, l, &body)) return false;
     } else {
-        if (!parse_expr(l, &body)) return false;
+        if (!parse_expr(ctx, l, &body)) return false;
     }
-    *expr = fun(arg, body);
+    *expr = fun(ctx, arg, body);
     return true;
 }
 
-bool parse_primary(Lexer *l, Expr_Index *expr)
+bool parse_primary(Lamb_Context *ctx, Lexer *l, Expr_Index *expr)
 {
     if (!lexer_next(l)) return NULL;
     switch ((int)l->token) {
     case TOKEN_OPAREN: {
-        if (!parse_expr(l, expr)) return false;
+        if (!parse_expr(ctx, l, expr)) return false;
         if (!lexer_expect(l, TOKEN_CPAREN)) return false;
         return true;
     }
-    case TOKEN_LAMBDA: return parse_fun(l, expr);
+    case TOKEN_LAMBDA: return parse_fun(ctx, l, expr);
     case TOKEN_MAGIC:
-        *expr = magic(l->string.items);
+        *expr = magic(ctx, l->string.items);
         return true;
     case TOKEN_NAME:
-        *expr = var(symbol(l->string.items));
+        *expr = var(ctx, symbol(ctx, l->string.items));
         return true;
     default:
         lexer_print_loc(l, stderr);
@@ -829,9 +1187,9 @@ bool parse_primary(Lexer *l, Expr_Index *expr)
     }
 }
 
-bool parse_expr(Lexer *l, Expr_Index *expr)
+bool parse_expr(Lamb_Context *ctx, Lexer *l, Expr_Index *expr)
 {
-    if (!parse_primary(l, expr)) return false;
+    if (!parse_primary(ctx, l, expr)) return false;
 
     if (!lexer_peek(l)) return false;
     while (
@@ -840,8 +1198,8 @@ bool parse_expr(Lexer *l, Expr_Index *expr)
         l->token != TOKEN_SEMICOLON
     ) {
         Expr_Index rhs;
-        if (!parse_primary(l, &rhs)) return false;
-        *expr = app(*expr, rhs);
+        if (!parse_primary(ctx, l, &rhs)) return false;
+        *expr = app(ctx, *expr, rhs);
         if (!lexer_peek(l)) return false;
     }
     return true;
@@ -902,28 +1260,33 @@ void create_binding(Bindings *bindings, Symbol name, Expr_Index body)
     da_append(bindings, binding);
 }
 
-bool create_bindings_from_file(const char *file_path, Bindings *bindings)
+bool create_bindings_from_file(Lamb_Context *ctx, const char *file_path, Bindings *bindings)
 {
-    static String_Builder sb = {0};
-    static Lexer l = {0};
+    bool result = false;
+    String_Builder sb = {0};
+    Lexer l = {0};
 
-    sb.count = 0;
-    if (!read_entire_file(file_path, &sb)) return false;
+    if (!read_entire_file(file_path, &sb)) goto defer;
 
     lexer_init(&l, sb.items, sb.count, file_path);
 
-    if (!lexer_peek(&l)) return false;
+    if (!lexer_peek(&l)) goto defer;
     while (l.token != TOKEN_END) {
-        if (!lexer_expect(&l, TOKEN_NAME)) return false;
-        Symbol name = symbol(l.string.items);
-        if (!lexer_expect(&l, TOKEN_EQUALS)) return false;
+        if (!lexer_expect(&l, TOKEN_NAME)) goto defer;
+        Symbol name = symbol(ctx, l.string.items);
+        if (!lexer_expect(&l, TOKEN_EQUALS)) goto defer;
         Expr_Index body;
-        if (!parse_expr(&l, &body)) return false;
-        if (!lexer_expect(&l, TOKEN_SEMICOLON)) return false;
+        if (!parse_expr(ctx, &l, &body)) goto defer;
+        if (!lexer_expect(&l, TOKEN_SEMICOLON)) goto defer;
         create_binding(bindings, name, body);
-        if (!lexer_peek(&l)) return false;
+        if (!lexer_peek(&l)) goto defer;
     }
-    return true;
+    result = true;
+
+defer:
+    free(sb.items);
+    free(l.string.items);
+    return result;
 }
 
 void ctrl_c_handler(int signum)
@@ -950,33 +1313,1015 @@ void replace_active_file_path_from_lexer_if_not_empty(Lexer l, char **active_fil
     }
 }
 
+// `:gc [mode] [budget_MB]` shared by the CLI apps
+void gc_command(Lamb_Context *ctx, Lexer *l)
+{
+    if (!lexer_next(l)) return;
+    while (l->token == TOKEN_NAME) {
+        if (isdigit(*l->string.items)) {
+            gc_set_heap_budget(ctx, (size_t)strtoull(l->string.items, NULL, 10) << 20);
+        } else {
+            Gc_Mode mode;
+            if (!gc_mode_by_name(l->string.items, &mode) || mode == GC_MODE_INCREMENTAL) {
+                // Incremental mode needs a frame loop driving gc_step()
+                fprintf(stderr, "ERROR: unknown heap mode `%s`, expected tracing or refcount\n", l->string.items);
+                return;
+            }
+            gc_set_mode(ctx, mode);
+        }
+        if (!lexer_next(l)) return;
+    }
+    if (l->token != TOKEN_END) {
+        report_unexpected(l, TOKEN_NAME);
+        return;
+    }
+
+    Gc_Stats stats = gc_stats(ctx);
+    printf("Heap mode:   %s\n", gc_mode_name(ctx->gc.mode));
+    printf("Slots:       %zu (%zu live, %zu free, peak %zu)\n", stats.slots, stats.live, stats.dead, stats.peak_slots);
+    printf("Last GC:     %zu live, %.1f MB allocated since\n", stats.live_after_gc, stats.bytes_allocated / 1048576.0);
+    printf("Promoted:    %.1f MB\n", stats.bytes_promoted / 1048576.0);
+    printf("Committed:   %.1f MB\n", stats.bytes_committed / 1048576.0);
+    if (stats.heap_budget > 0) {
+        printf("Budget:      %zu MB\n", stats.heap_budget >> 20);
+    } else {
+        printf("Budget:      unlimited\n");
+    }
+    printf("Collections: %zu minor, %zu major\n", stats.minor_collections, stats.major_collections);
+}
+
 // ============================================================================
 // GC
 // ============================================================================
 
-void gc_mark(Expr_Index root)
+void gc_mark(Lamb_Context *ctx, Expr_Index root)
 {
-    if (expr_slot(root).visited) return;
-    expr_slot(root).visited = true;
-    switch (expr_slot(root).kind) {
+    if (ctx->gc.mode == GC_MODE_REFCOUNT) {
+        expr_slot(ctx, root).rc += 1;
+        da_append(&ctx->gc.pinned, root);
+        return;
+    }
+    // Old nodes only point to old nodes, so a minor collection stops here.
+    if (!ctx->gc.major && expr_slot(ctx, root).old) return;
+    if (expr_slot(ctx, root).visited) return;
+    expr_slot(ctx, root).visited = true;
+    switch (expr_slot(ctx, root).kind) {
     case EXPR_MAG:
     case EXPR_VAR:
         break;
     case EXPR_FUN:
-        gc_mark(expr_slot(root).as.fun.body);
+        gc_mark(ctx, expr_slot(ctx, root).as.fun.body);
         break;
     case EXPR_APP:
-        gc_mark(expr_slot(root).as.app.lhs);
-        gc_mark(expr_slot(root).as.app.rhs);
+        gc_mark(ctx, expr_slot(ctx, root).as.app.lhs);
+        gc_mark(ctx, expr_slot(ctx, root).as.app.rhs);
         break;
     default: UNREACHABLE("Expr_Kind");
     }
 }
 
-// Note: The gc() function needs access to gas_pool and active_grid for marking.
-// These are defined in the app-specific files. We provide a basic gc() here
-// that can be extended or replaced in the apps.
-// For now, the apps will need to implement their own gc() that also marks their pools.
+static bool gc_over_budget(Lamb_Context *ctx)
+{
+    return ctx->gc.heap_budget > 0 &&
+           (ctx->gc.slots.count - ctx->gc.dead.count) * sizeof(Expr) >= ctx->gc.heap_budget;
+}
+
+static bool gc_major_due(Lamb_Context *ctx)
+{
+    if (gc_over_budget(ctx)) return true;
+    return ctx->gc.old.count >= GC_MAJOR_MIN_OLD &&
+           ctx->gc.old.count >= ctx->gc.old_after_major * GC_MAJOR_GROWTH;
+}
+
+// Book-keeping shared by every kind of collection, once the garbage is gone
+static void gc_collected(Lamb_Context *ctx)
+{
+    if (ctx->gc.slots.count > ctx->gc.peak_slots) ctx->gc.peak_slots = ctx->gc.slots.count;
+    ctx->gc.live_after_gc = ctx->gc.slots.count - ctx->gc.dead.count;
+    ctx->gc.allocated = 0;
+}
+
+void gc_begin(Lamb_Context *ctx)
+{
+    // In incremental mode the old space is only ever collected by gc_step()
+    ctx->gc.major = ctx->gc.mode == GC_MODE_STOP_THE_WORLD && gc_major_due(ctx);
+    if (ctx->gc.mode == GC_MODE_REFCOUNT) return;
+
+    for (size_t i = 0; i < ctx->gc.young.count; ++i) {
+        expr_slot(ctx, ctx->gc.young.items[i]).visited = false;
+    }
+
+    if (ctx->gc.major) {
+        for (size_t i = 0; i < ctx->gc.old.count; ++i) {
+            expr_slot(ctx, ctx->gc.old.items[i]).visited = false;
+        }
+    } else {
+        for (size_t i = 0; i < ctx->gc.remembered.count; ++i) {
+            gc_mark(ctx, ctx->gc.remembered.items[i]);
+        }
+    }
+}
+
+// Apply the deferred decrements, cascading into the children of freed nodes
+static void gc_rc_drain(Lamb_Context *ctx)
+{
+    while (ctx->gc.released.count > 0) {
+        Expr_Index expr = ctx->gc.released.items[--ctx->gc.released.count];
+        assert(expr_slot(ctx, expr).rc > 0);
+        if (--expr_slot(ctx, expr).rc > 0) continue;
+        switch (expr_slot(ctx, expr).kind) {
+        case EXPR_FUN:
+            da_append(&ctx->gc.released, expr_slot(ctx, expr).as.fun.body);
+            break;
+        case EXPR_APP:
+            da_append(&ctx->gc.released, expr_slot(ctx, expr).as.app.lhs);
+            da_append(&ctx->gc.released, expr_slot(ctx, expr).as.app.rhs);
+            break;
+        default:
+            break;
+        }
+        free_expr(ctx, expr);
+    }
+}
+
+static void gc_rc_sweep(Lamb_Context *ctx)
+{
+    gc_rc_drain(ctx);
+
+    // Nursery nodes nobody picked up. Nothing is allocated until we return,
+    // so entries freed by an earlier cascade are simply not live anymore.
+    for (size_t i = 0; i < ctx->gc.young.count; ++i) {
+        Expr_Index expr = ctx->gc.young.items[i];
+        if (!expr_slot_unsafe(ctx, expr).live || expr_slot(ctx, expr).rc > 0) continue;
+        expr_slot(ctx, expr).rc = 1;
+        da_append(&ctx->gc.released, expr);
+        gc_rc_drain(ctx);
+    }
+    ctx->gc.young.count = 0;
+
+    // Unpinned roots that dropped back to zero get another chance next time
+    for (size_t i = 0; i < ctx->gc.pinned.count; ++i) {
+        Expr_Index expr = ctx->gc.pinned.items[i];
+        if (--expr_slot(ctx, expr).rc == 0) da_append(&ctx->gc.young, expr);
+    }
+    ctx->gc.pinned.count = 0;
+
+    ctx->gc.minor_collections += 1;
+    gc_collected(ctx);
+}
+
+void gc_sweep(Lamb_Context *ctx)
+{
+    if (ctx->gc.mode == GC_MODE_REFCOUNT) {
+        gc_rc_sweep(ctx);
+        return;
+    }
+
+    if (ctx->gc.major) {
+        size_t kept = 0;
+        for (size_t i = 0; i < ctx->gc.old.count; ++i) {
+            Expr_Index expr = ctx->gc.old.items[i];
+            if (expr_slot(ctx, expr).visited) {
+                ctx->gc.old.items[kept++] = expr;
+            } else {
+                free_expr(ctx, expr);
+            }
+        }
+        ctx->gc.old.count = kept;
+    }
+
+    // Survivors are promoted once they are GC_PROMOTE_AGE collections old.
+    // Children are never younger than their parents, so old nodes still only
+    // point to old nodes.
+    size_t kept = 0;
+    for (size_t i = 0; i < ctx->gc.young.count; ++i) {
+        Expr_Index expr = ctx->gc.young.items[i];
+        if (expr_slot(ctx, expr).visited && ++expr_slot(ctx, expr).age < GC_PROMOTE_AGE) {
+            expr_slot(ctx, expr).visited = false;  // White again, or gc_shade() would not walk it
+            ctx->gc.young.items[kept++] = expr;
+        } else if (expr_slot(ctx, expr).visited) {
+            expr_slot(ctx, expr).old = true;
+            da_append(&ctx->gc.old, expr);
+            ctx->gc.promoted += 1;
+            // Promoted nodes are black; keep the tri-color invariant for their
+            // children in case they were built before the cycle started marking.
+            if (ctx->gc.phase == GC_PHASE_MARK) {
+                switch (expr_slot(ctx, expr).kind) {
+                case EXPR_FUN:
+                    gc_shade(ctx, expr_slot(ctx, expr).as.fun.body);
+                    break;
+                case EXPR_APP:
+                    gc_shade(ctx, expr_slot(ctx, expr).as.app.lhs);
+                    gc_shade(ctx, expr_slot(ctx, expr).as.app.rhs);
+                    break;
+                default:
+                    break;
+                }
+            }
+        } else {
+            free_expr(ctx, expr);
+        }
+    }
+    ctx->gc.young.count = kept;
+
+    // Roots into the survivors left in the nursery are traced again next time
+    kept = 0;
+    for (size_t i = 0; i < ctx->gc.remembered.count; ++i) {
+        Expr_Index expr = ctx->gc.remembered.items[i];
+        if (expr_slot_unsafe(ctx, expr).live && !expr_slot(ctx, expr).old) ctx->gc.remembered.items[kept++] = expr;
+    }
+    ctx->gc.remembered.count = kept;
+
+    if (ctx->gc.major) {
+        ctx->gc.old_after_major = ctx->gc.old.count;
+        ctx->gc.major_collections += 1;
+    } else {
+        ctx->gc.minor_collections += 1;
+    }
+    gc_collected(ctx);
+}
+
+void gc_remember(Lamb_Context *ctx, Expr_Index expr)
+{
+    if (ctx->gc.mode != GC_MODE_REFCOUNT && !expr_slot(ctx, expr).old) da_append(&ctx->gc.remembered, expr);
+    gc_write_barrier(ctx, expr);
+}
+
+void gc_forget(Lamb_Context *ctx, Expr_Index expr)
+{
+    if (ctx->gc.mode == GC_MODE_REFCOUNT) da_append(&ctx->gc.released, expr);
+}
+
+// Gray an old node, or walk a young one down to the old nodes it references.
+// The nursery is handled by minor collections, so the gray stack only ever
+// holds old nodes and survives them untouched.
+static void gc_shade(Lamb_Context *ctx, Expr_Index expr)
+{
+    if (expr_slot(ctx, expr).visited) return;
+    expr_slot(ctx, expr).visited = true;
+    if (expr_slot(ctx, expr).old) {
+        da_append(&ctx->gc.gray, expr);
+        return;
+    }
+    switch (expr_slot(ctx, expr).kind) {
+    case EXPR_MAG:
+    case EXPR_VAR:
+        break;
+    case EXPR_FUN:
+        gc_shade(ctx, expr_slot(ctx, expr).as.fun.body);
+        break;
+    case EXPR_APP:
+        gc_shade(ctx, expr_slot(ctx, expr).as.app.lhs);
+        gc_shade(ctx, expr_slot(ctx, expr).as.app.rhs);
+        break;
+    default: UNREACHABLE("Expr_Kind");
+    }
+}
+
+static void gc_shade_root(Lamb_Context *ctx, Expr_Index *root)
+{
+    gc_shade(ctx, *root);
+}
+
+static void gc_rc_retain(Lamb_Context *ctx, Expr_Index expr)
+{
+    expr_slot(ctx, expr).rc += 1;
+}
+
+// The tracing modes do not maintain counts, so recount every edge and root
+static void gc_rc_retain_root(Lamb_Context *ctx, Expr_Index *root)
+{
+    gc_rc_retain(ctx, *root);
+}
+
+static bool gc_has_dead_child(Lamb_Context *ctx, Expr *expr)
+{
+    switch (expr->kind) {
+    case EXPR_FUN:
+        return !ctx->gc.slots.items[expr->as.fun.body.unwrap].live;
+    case EXPR_APP:
+        return !ctx->gc.slots.items[expr->as.app.lhs.unwrap].live
+            || !ctx->gc.slots.items[expr->as.app.rhs.unwrap].live;
+    default:
+        return false;
+    }
+}
+
+static void gc_rc_enter(Lamb_Context *ctx)
+{
+    // Floating garbage of the tracing modes may still point at nodes a major
+    // sweep already freed. It is unreachable, so drop it before counting.
+    for (bool pruned = true; pruned;) {
+        pruned = false;
+        for (size_t i = 0; i < ctx->gc.slots.count; ++i) {
+            Expr *expr = &ctx->gc.slots.items[i];
+            if (expr->live && gc_has_dead_child(ctx, expr)) {
+                free_expr(ctx, (Expr_Index){i});
+                pruned = true;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < ctx->gc.slots.count; ++i) {
+        ctx->gc.slots.items[i].rc = 0;
+        ctx->gc.slots.items[i].old = false;
+    }
+    for (size_t i = 0; i < ctx->gc.slots.count; ++i) {
+        Expr *expr = &ctx->gc.slots.items[i];
+        if (!expr->live) continue;
+        switch (expr->kind) {
+        case EXPR_FUN:
+            gc_rc_retain(ctx, expr->as.fun.body);
+            break;
+        case EXPR_APP:
+            gc_rc_retain(ctx, expr->as.app.lhs);
+            gc_rc_retain(ctx, expr->as.app.rhs);
+            break;
+        default:
+            break;
+        }
+    }
+    gc_visit_roots(ctx, gc_rc_retain_root);
+
+    ctx->gc.young.count = 0;
+    ctx->gc.old.count = 0;
+    ctx->gc.remembered.count = 0;
+    for (size_t i = 0; i < ctx->gc.slots.count; ++i) {
+        if (ctx->gc.slots.items[i].live && ctx->gc.slots.items[i].rc == 0) {
+            da_append(&ctx->gc.young, ((Expr_Index){i}));
+        }
+    }
+}
+
+// Hand the whole heap over to the tracing collector as old space
+static void gc_rc_leave(Lamb_Context *ctx)
+{
+    ctx->gc.released.count = 0;  // Whatever they would have freed gets traced away
+    ctx->gc.young.count = 0;
+    ctx->gc.old.count = 0;
+    ctx->gc.remembered.count = 0;
+    for (size_t i = 0; i < ctx->gc.slots.count; ++i) {
+        if (!ctx->gc.slots.items[i].live) continue;
+        ctx->gc.slots.items[i].old = true;
+        da_append(&ctx->gc.old, ((Expr_Index){i}));
+    }
+    ctx->gc.old_after_major = ctx->gc.old.count;
+}
+
+void gc_set_mode(Lamb_Context *ctx, Gc_Mode mode)
+{
+    if (mode == ctx->gc.mode) return;
+    if (ctx->gc.phase == GC_PHASE_SWEEP) {
+        // Close the gap between the kept and the unswept part of the old space
+        while (ctx->gc.cursor < ctx->gc.old.count) {
+            Expr_Index expr = ctx->gc.old.items[ctx->gc.cursor++];
+            if (expr_slot(ctx, expr).visited) {
+                ctx->gc.old.items[ctx->gc.swept++] = expr;
+            } else {
+                free_expr(ctx, expr);
+            }
+        }
+        ctx->gc.old.count = ctx->gc.swept;
+    }
+    // Abandoning CLEAR or MARK is fine: major collections whiten everything anyway
+    ctx->gc.gray.count = 0;
+    ctx->gc.phase = GC_PHASE_IDLE;
+    if (ctx->gc.mode == GC_MODE_REFCOUNT) gc_rc_leave(ctx);
+    ctx->gc.mode = mode;
+    if (ctx->gc.mode == GC_MODE_REFCOUNT) gc_rc_enter(ctx);
+}
+
+static const char *gc_mode_names[] = {
+    [GC_MODE_STOP_THE_WORLD] = "tracing",
+    [GC_MODE_INCREMENTAL]    = "incremental",
+    [GC_MODE_REFCOUNT]       = "refcount",
+};
+
+const char *gc_mode_name(Gc_Mode mode)
+{
+    assert((size_t)mode < (sizeof(gc_mode_names) / sizeof(gc_mode_names[0])));
+    return gc_mode_names[mode];
+}
+
+bool gc_mode_by_name(const char *name, Gc_Mode *mode)
+{
+    for (size_t i = 0; i < (sizeof(gc_mode_names) / sizeof(gc_mode_names[0])); ++i) {
+        if (strcmp(gc_mode_names[i], name) == 0) {
+            *mode = (Gc_Mode)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Number of nodes processed between two looks at the clock
+#define GC_STEP_CHUNK 256
+
+bool gc_step(Lamb_Context *ctx, Bindings bindings, uint64_t budget_us)
+{
+    if (ctx->gc.mode != GC_MODE_INCREMENTAL) return true;
+
+    uint64_t deadline = time_now_us() + budget_us;
+    size_t work = 0;
+    for (;;) {
+        if (++work % GC_STEP_CHUNK == 0 && time_now_us() >= deadline) break;
+
+        switch (ctx->gc.phase) {
+        case GC_PHASE_IDLE:
+            if (!gc_major_due(ctx)) return true;
+            ctx->gc.cursor = 0;
+            ctx->gc.phase = GC_PHASE_CLEAR;
+            break;
+
+        case GC_PHASE_CLEAR:
+            // Nodes promoted meanwhile are appended, so the cursor reaches them too
+            if (ctx->gc.cursor < ctx->gc.old.count) {
+                Expr_Index expr = ctx->gc.old.items[ctx->gc.cursor++];
+                expr_slot(ctx, expr).visited = false;
+                break;
+            }
+            ctx->gc.phase = GC_PHASE_MARK;
+            // Snapshot of the roots: everything reachable from here on is either
+            // reachable now or newly built, and the barriers cover the latter.
+            for (size_t i = 0; i < bindings.count; ++i) {
+                gc_shade(ctx, bindings.items[i].body);
+            }
+            gc_visit_roots(ctx, gc_shade_root);
+            // The next minor collection traces these even if they were dropped
+            for (size_t i = 0; i < ctx->gc.remembered.count; ++i) {
+                gc_shade(ctx, ctx->gc.remembered.items[i]);
+            }
+            // The nursery may outlive the cycle (explicit roots of gc(), survivors
+            // waiting for promotion), so whatever old nodes it points at stay too
+            for (size_t i = 0; i < ctx->gc.young.count; ++i) {
+                gc_shade(ctx, ctx->gc.young.items[i]);
+            }
+            break;
+
+        case GC_PHASE_MARK:
+            if (ctx->gc.gray.count > 0) {
+                Expr_Index expr = ctx->gc.gray.items[--ctx->gc.gray.count];
+                switch (expr_slot(ctx, expr).kind) {
+                case EXPR_MAG:
+                case EXPR_VAR:
+                    break;
+                case EXPR_FUN:
+                    gc_shade(ctx, expr_slot(ctx, expr).as.fun.body);
+                    break;
+                case EXPR_APP:
+                    gc_shade(ctx, expr_slot(ctx, expr).as.app.lhs);
+                    gc_shade(ctx, expr_slot(ctx, expr).as.app.rhs);
+                    break;
+                default: UNREACHABLE("Expr_Kind");
+                }
+                break;
+            }
+            ctx->gc.cursor = 0;
+            ctx->gc.swept = 0;
+            ctx->gc.phase = GC_PHASE_SWEEP;
+            break;
+
+        case GC_PHASE_SWEEP:
+            // Promotions append behind the cursor and are black, so they are kept
+            if (ctx->gc.cursor < ctx->gc.old.count) {
+                Expr_Index expr = ctx->gc.old.items[ctx->gc.cursor++];
+                if (expr_slot(ctx, expr).visited) {
+                    ctx->gc.old.items[ctx->gc.swept++] = expr;
+                } else {
+                    free_expr(ctx, expr);
+                }
+                break;
+            }
+            ctx->gc.old.count = ctx->gc.swept;
+            ctx->gc.old_after_major = ctx->gc.old.count;
+            ctx->gc.major_collections += 1;
+            ctx->gc.live_after_gc = ctx->gc.slots.count - ctx->gc.dead.count;
+            ctx->gc.phase = GC_PHASE_IDLE;
+            return true;
+
+        default: UNREACHABLE("Gc_Phase");
+        }
+    }
+    return false;
+}
+
+void gc_mark_root(Lamb_Context *ctx, Expr_Index *root)
+{
+    gc_mark(ctx, *root);
+}
+
+// The app roots live in the app (gas pool, grid cells), which hands them to
+// the collector through ctx->roots. Apps must call gc_remember() whenever
+// they store an expression into one of those roots.
+void gc_visit_roots(Lamb_Context *ctx, Gc_Visit visit)
+{
+    if (ctx->roots) ctx->roots(ctx, visit);
+}
+
+void gc(Lamb_Context *ctx, Expr_Index root, Bindings bindings)
+{
+    gc_begin(ctx);
+
+    gc_mark(ctx, root);
+    for (size_t i = 0; i < bindings.count; ++i) {
+        gc_mark(ctx, bindings.items[i].body);
+    }
+
+    // Minor collections only trace the app roots written since the last
+    // cycle, which gc_remember() has already marked.
+    if (ctx->gc.major) gc_visit_roots(ctx, gc_mark_root);
+
+    gc_sweep(ctx);
+}
+
+static void gc_remap_root(Lamb_Context *ctx, Expr_Index *root)
+{
+    if (ctx->gc.remap[root->unwrap] != (size_t)-1) {
+        root->unwrap = ctx->gc.remap[root->unwrap];
+    }
+}
+
+// Compact GC slots to reclaim memory and improve cache locality
+// Call this periodically when slot fragmentation is high
+void gc_compact(Lamb_Context *ctx, Bindings *bindings) {
+    if (ctx->gc.slots.count == 0) return;
+    // Gray stack and sweep cursors hold raw indices; wait for the cycle to end
+    if (ctx->gc.phase != GC_PHASE_IDLE) return;
+    
+    // Only compact if fragmentation is significant (>50% dead space)
+    size_t live_count = ctx->gc.slots.count - ctx->gc.dead.count;
+    if (ctx->gc.dead.count < ctx->gc.slots.count / 2) return;
+    
+    // Build remapping table: old_index -> new_index
+    size_t *remap = malloc(ctx->gc.slots.count * sizeof(size_t));
+    for (size_t i = 0; i < ctx->gc.slots.count; ++i) {
+        remap[i] = (size_t)-1;  // Mark as unmapped
+    }
+    
+    // Slide live expressions down in place (new index never exceeds the old one)
+    Expr *new_slots = ctx->gc.slots.items;
+    size_t new_idx = 0;
+    
+    for (size_t i = 0; i < ctx->gc.slots.count; ++i) {
+        if (ctx->gc.slots.items[i].live) {
+            new_slots[new_idx] = ctx->gc.slots.items[i];
+            remap[i] = new_idx;
+            new_idx++;
+        }
+    }
+    assert(new_idx == live_count);
+    
+    // Update all internal expression references
+    for (size_t i = 0; i < new_idx; ++i) {
+        Expr *e = &new_slots[i];
+        switch (e->kind) {
+        case EXPR_FUN:
+            if (remap[e->as.fun.body.unwrap] != (size_t)-1) {
+                e->as.fun.body.unwrap = remap[e->as.fun.body.unwrap];
+            }
+            break;
+        case EXPR_APP:
+            if (remap[e->as.app.lhs.unwrap] != (size_t)-1) {
+                e->as.app.lhs.unwrap = remap[e->as.app.lhs.unwrap];
+            }
+            if (remap[e->as.app.rhs.unwrap] != (size_t)-1) {
+                e->as.app.rhs.unwrap = remap[e->as.app.rhs.unwrap];
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    
+    // Update app roots (grid cells, gas pool)
+    ctx->gc.remap = remap;
+    gc_visit_roots(ctx, gc_remap_root);
+    ctx->gc.remap = NULL;
+    
+    // Update bindings references
+    if (bindings) {
+        for (size_t i = 0; i < bindings->count; ++i) {
+            size_t old_idx = bindings->items[i].body.unwrap;
+            if (remap[old_idx] != (size_t)-1) {
+                bindings->items[i].body.unwrap = remap[old_idx];
+            }
+        }
+    }
+    
+    // Update GC generation arrays
+    for (size_t i = 0; i < ctx->gc.young.count; ++i) {
+        ctx->gc.young.items[i].unwrap = remap[ctx->gc.young.items[i].unwrap];
+    }
+    for (size_t i = 0; i < ctx->gc.old.count; ++i) {
+        ctx->gc.old.items[i].unwrap = remap[ctx->gc.old.items[i].unwrap];
+    }
+    for (size_t i = 0; i < ctx->gc.remembered.count; ++i) {
+        ctx->gc.remembered.items[i].unwrap = remap[ctx->gc.remembered.items[i].unwrap];
+    }
+    for (size_t i = 0; i < ctx->gc.released.count; ++i) {
+        ctx->gc.released.items[i].unwrap = remap[ctx->gc.released.items[i].unwrap];
+    }
+    
+    ctx->gc.slots.count = new_idx;
+    
+    // Clear dead list (all slots are now live and compact)
+    ctx->gc.dead.count = 0;
+    
+    // Hand the freed tail back to the OS
+    gc_arena_trim(ctx);
+    
+    free(remap);
+}
+
+void lamb_context_free(Lamb_Context *ctx)
+{
+    if (ctx->gc.slots.items) {
+#ifdef _WIN32
+        VirtualFree(ctx->gc.slots.items, 0, MEM_RELEASE);
+#else
+        munmap(ctx->gc.slots.items, ctx->gc.slots.reserved * sizeof(Expr));
+#endif
+    }
+    free(ctx->gc.dead.items);
+    free(ctx->gc.young.items);
+    free(ctx->gc.old.items);
+    free(ctx->gc.remembered.items);
+    free(ctx->gc.gray.items);
+    free(ctx->gc.released.items);
+    free(ctx->gc.pinned.items);
+    for (size_t i = 0; i < ctx->labels.count; ++i) {
+        free((char*)ctx->labels.items[i]);
+    }
+    free(ctx->labels.items);
+    free(ctx->copy_tags.items);
+    free(ctx->trace_sb.items);
+    free(ctx->ast_stack.items);
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+// ============================================================================
+// RANDOMNESS AND THREADS
+// ============================================================================
+
+static uint64_t splitmix64(uint64_t *x)
+{
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// xoshiro256** by Blackman and Vigna (https://prng.di.unimi.it/), the state
+// filled from splitmix64 so that any seed, 0 included, gives a good stream
+void rng_seed(Lamb_Rng *rng, uint64_t seed)
+{
+    for (size_t i = 0; i < 4; ++i) rng->s[i] = splitmix64(&seed);
+}
+
+static inline uint64_t rotl64(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+uint64_t rng_next(Lamb_Rng *rng)
+{
+    uint64_t *s = rng->s;
+    if ((s[0] | s[1] | s[2] | s[3]) == 0) rng_seed(rng, 0);
+    uint64_t result = rotl64(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+    return result;
+}
+
+// Lemire's multiply-and-reject: no modulo bias and, most of the time, no division
+uint32_t rng_below(Lamb_Rng *rng, uint32_t n)
+{
+    uint64_t m = (rng_next(rng) >> 32) * n;
+    uint32_t low = (uint32_t)m;
+    if (low < n) {
+        uint32_t threshold = (uint32_t)(-n) % n;
+        while (low < threshold) {
+            m = (rng_next(rng) >> 32) * n;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+double rng_double(Lamb_Rng *rng)
+{
+    return (double)(rng_next(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+void rng_jump(Lamb_Rng *rng)
+{
+    static const uint64_t jump[4] = {
+        0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull,
+        0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull,
+    };
+    uint64_t s[4] = {0};
+    for (size_t i = 0; i < 4; ++i) {
+        for (int b = 0; b < 64; ++b) {
+            if (jump[i] & (1ull << b)) {
+                for (size_t k = 0; k < 4; ++k) s[k] ^= rng->s[k];
+            }
+            rng_next(rng);
+        }
+    }
+    memcpy(rng->s, s, sizeof(s));
+}
+
+Lamb_Rng rng_split(Lamb_Rng *rng)
+{
+    if ((rng->s[0] | rng->s[1] | rng->s[2] | rng->s[3]) == 0) rng_seed(rng, 0);
+    Lamb_Rng stream = *rng;
+    rng_jump(rng);
+    return stream;
+}
+
+uint64_t seed_from_time(void)
+{
+    uint64_t x = (uint64_t)time(NULL) ^ time_now_us() << 20;
+    return splitmix64(&x);
+}
+
+bool parse_seed(const char *text, uint64_t *seed)
+{
+    char *end;
+    errno = 0;
+    unsigned long long value = strtoull(text, &end, 0);
+    if (errno != 0 || end == text || *end != '\0') return false;
+    *seed = (uint64_t)value;
+    return true;
+}
+
+size_t cpu_count(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (size_t)info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (size_t)n : 1;
+#endif // _WIN32
+}
+
+// Work stealing. pool_run() deals the indices out to the workers in equal
+// contiguous ranges. A worker takes tasks from the bottom of its own range,
+// and once that is empty it takes the top half of the first non-empty range
+// of another worker. Reaction costs are heavy-tailed, so a worker stuck on
+// one long task keeps little queued behind it.
+typedef struct {
+#ifndef _WIN32
+    pthread_mutex_t lock;
+    Thread_Pool *pool;
+#endif // _WIN32
+    size_t id;
+    size_t lo, hi;               // Indices still queued
+    uint64_t busy_us;            // Time spent in tasks during the current batch
+    Pool_Stats stats;
+} Pool_Worker;
+
+struct Thread_Pool {
+    size_t workers;
+    Pool_Worker *items;
+#ifndef _WIN32
+    pthread_t *threads;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;         // A batch was posted, or the pool is going away
+    pthread_cond_t done;         // The batch finished and every worker left it
+    size_t generation;           // Batches posted so far
+    bool quit;
+
+    // Current batch
+    Pool_Task task;
+    void *data;
+    size_t count;
+    size_t finished;             // Tasks done
+    size_t active;               // Workers inside pool_drain()
+#endif // _WIN32
+};
+
+#ifndef _WIN32
+static bool pool_take(Pool_Worker *w, size_t *index)
+{
+    bool ok = false;
+    pthread_mutex_lock(&w->lock);
+    if (w->lo < w->hi) {
+        *index = w->lo++;
+        ok = true;
+    }
+    pthread_mutex_unlock(&w->lock);
+    return ok;
+}
+
+// Moves the top half of some other worker's range into self's (empty) range
+static bool pool_steal(Thread_Pool *pool, Pool_Worker *self)
+{
+    for (size_t i = 1; i < pool->workers; ++i) {
+        Pool_Worker *victim = &pool->items[(self->id + i) % pool->workers];
+        size_t lo = 0, hi = 0;
+        pthread_mutex_lock(&victim->lock);
+        if (victim->lo < victim->hi) {
+            size_t half = (victim->hi - victim->lo + 1) / 2;
+            hi = victim->hi;
+            lo = victim->hi -= half;
+        }
+        pthread_mutex_unlock(&victim->lock);
+        if (lo == hi) continue;
+
+        pthread_mutex_lock(&self->lock);
+        self->lo = lo;
+        self->hi = hi;
+        pthread_mutex_unlock(&self->lock);
+        self->stats.steals += 1;
+        self->stats.stolen += hi - lo;
+        return true;
+    }
+    return false;
+}
+
+// Runs tasks of the current batch until no worker has any queued. Called
+// without the pool lock.
+static void pool_drain(Thread_Pool *pool, Pool_Worker *self, Pool_Task task, void *data)
+{
+    size_t done = 0;
+    for (;;) {
+        size_t index;
+        if (!pool_take(self, &index)) {
+            if (!pool_steal(pool, self)) break;
+            continue;
+        }
+        uint64_t start = time_now_us();
+        task(data, self->id, index);
+        self->busy_us += time_now_us() - start;
+        self->stats.tasks += 1;
+        done += 1;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->finished += done;
+    pool->active -= 1;
+    if (pool->active == 0 && pool->finished == pool->count) pthread_cond_signal(&pool->done);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void *pool_thread(void *arg)
+{
+    Pool_Worker *self = arg;
+    Thread_Pool *pool = self->pool;
+    size_t seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->quit && pool->generation == seen) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->quit) break;
+        seen = pool->generation;
+        if (pool->finished == pool->count) continue;  // Woke up too late for it
+        Pool_Task task = pool->task;
+        void *data = pool->data;
+        pool->active += 1;
+        pthread_mutex_unlock(&pool->lock);
+        pool_drain(pool, self, task, data);
+        pthread_mutex_lock(&pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+#endif // _WIN32
+
+Thread_Pool *pool_create(size_t workers)
+{
+    Thread_Pool *pool = calloc(1, sizeof(*pool));
+    assert(pool != NULL && "Buy more RAM lol");
+    if (workers == 0) workers = cpu_count();
+#ifdef _WIN32
+    workers = 1;
+#endif // _WIN32
+    pool->workers = 1;
+    pool->items = calloc(workers, sizeof(*pool->items));
+    assert(pool->items != NULL && "Buy more RAM lol");
+#ifndef _WIN32
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->threads = calloc(workers, sizeof(*pool->threads));
+    assert(pool->threads != NULL && "Buy more RAM lol");
+    for (size_t i = 0; i < workers; ++i) {
+        pool->items[i].pool = pool;
+        pool->items[i].id = i;
+        pthread_mutex_init(&pool->items[i].lock, NULL);
+    }
+    for (size_t i = 1; i < workers; ++i) {
+        int err = pthread_create(&pool->threads[i], NULL, pool_thread, &pool->items[i]);
+        if (err != 0) {
+            fprintf(stderr, "ERROR: could not start worker thread: %s\n", strerror(err));
+            break;
+        }
+        pool->workers += 1;
+    }
+#endif // _WIN32
+    return pool;
+}
+
+void pool_free(Thread_Pool *pool)
+{
+    if (!pool) return;
+#ifndef _WIN32
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (size_t i = 1; i < pool->workers; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    for (size_t i = 0; i < pool->workers; ++i) {
+        pthread_mutex_destroy(&pool->items[i].lock);
+    }
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+#endif // _WIN32
+    free(pool->items);
+    free(pool);
+}
+
+size_t pool_workers(Thread_Pool *pool)
+{
+    return pool->workers;
+}
+
+Pool_Stats pool_stats(Thread_Pool *pool, size_t worker)
+{
+    assert(worker < pool->workers);
+    return pool->items[worker].stats;
+}
+
+void pool_print_stats(Thread_Pool *pool)
+{
+    printf("Worker  Tasks       Steals    Stolen      Busy s    Idle s\n");
+    for (size_t i = 0; i < pool->workers; ++i) {
+        Pool_Stats *s = &pool->items[i].stats;
+        printf("%-6zu  %-10zu  %-8zu  %-10zu  %-8.2f  %.2f\n", i, s->tasks, s->steals, s->stolen,
+               s->busy_us / 1e6, s->idle_us / 1e6);
+    }
+}
+
+void pool_run(Thread_Pool *pool, size_t count, Pool_Task task, void *data)
+{
+    if (count == 0) return;
+    uint64_t start = time_now_us();
+    for (size_t i = 0; i < pool->workers; ++i) pool->items[i].busy_us = 0;
+
+    if (pool->workers == 1 || count == 1) {
+        Pool_Worker *self = &pool->items[0];
+        for (size_t i = 0; i < count; ++i) task(data, 0, i);
+        self->stats.tasks += count;
+        self->busy_us = time_now_us() - start;
+    } else {
+#ifndef _WIN32
+        pthread_mutex_lock(&pool->lock);
+        for (size_t i = 0; i < pool->workers; ++i) {
+            Pool_Worker *w = &pool->items[i];
+            pthread_mutex_lock(&w->lock);
+            w->lo = count * i / pool->workers;
+            w->hi = count * (i + 1) / pool->workers;
+            pthread_mutex_unlock(&w->lock);
+        }
+        pool->task = task;
+        pool->data = data;
+        pool->count = count;
+        pool->finished = 0;
+        pool->active = 1;
+        pool->generation += 1;
+        pthread_cond_broadcast(&pool->wake);
+        pthread_mutex_unlock(&pool->lock);
+
+        pool_drain(pool, &pool->items[0], task, data);
+
+        pthread_mutex_lock(&pool->lock);
+        while (pool->active > 0 || pool->finished < pool->count) {
+            pthread_cond_wait(&pool->done, &pool->lock);
+        }
+        pthread_mutex_unlock(&pool->lock);
+#endif // _WIN32
+    }
+
+    uint64_t elapsed = time_now_us() - start;
+    for (size_t i = 0; i < pool->workers; ++i) {
+        Pool_Worker *w = &pool->items[i];
+        w->stats.busy_us += w->busy_us;
+        w->stats.idle_us += elapsed > w->busy_us ? elapsed - w->busy_us : 0;
+    }
+}
 
 // ============================================================================
 // COMBINATOR GENERATION
@@ -985,14 +2330,14 @@ void gc_mark(Expr_Index root)
 // Generates a "Closed" expression (no free variables).
 // This ensures every molecule is a valid function, not just data.
 // Based on AlChemy paper's probabilistic grammar approach.
-Expr_Index generate_rich_combinator(int current_depth, int max_depth, const char **env, int env_count) {
+Expr_Index generate_rich_combinator(Lamb_Context *ctx, int current_depth, int max_depth, const char **env, int env_count) {
     // 1. HARD STOP: If we hit depth limit, we MUST pick a variable.
     if (current_depth >= max_depth) {
         if (env_count > 0) {
-            return var(symbol(env[rand() % env_count]));
+            return var(ctx, symbol(ctx, env[rng_below(&ctx->rng, (uint32_t)env_count)]));
         } else {
             // Emergency fallback if depth hit but no variables exist (unlikely if logic is right)
-            return fun(symbol("x"), var(symbol("x")));
+            return fun(ctx, symbol(ctx, "x"), var(ctx, symbol(ctx, "x")));
         }
     }
 
@@ -1010,7 +2355,7 @@ Expr_Index generate_rich_combinator(int current_depth, int max_depth, const char
     // Otherwise, roll dice. 
     // Bias: Application (50%), Abstraction (30%), Variable (20%)
     else {
-        int r = rand() % 100;
+        int r = (int)rng_below(&ctx->rng, 100);
         
         if (force_growth) {
             // Early game: 60% App, 40% Abs, 0% Var
@@ -1020,7 +2365,7 @@ Expr_Index generate_rich_combinator(int current_depth, int max_depth, const char
             // Late game: 50% App, 30% Abs, 20% Var
             if (r < 50) goto do_app;
             if (r < 80) goto do_abs;
-            return var(symbol(env[rand() % env_count]));
+            return var(ctx, symbol(ctx, env[rng_below(&ctx->rng, (uint32_t)env_count)]));
         }
     }
 
@@ -1028,34 +2373,34 @@ do_abs:;
     // Abstraction: \new_param. Body
     char buf[32];
     snprintf(buf, sizeof(buf), "v%d", env_count);
-    const char *param_name = intern_label(buf);
+    const char *param_name = intern_label(ctx, buf);
 
     const char *new_env[64];
-    if (env_count >= 63) return fun(symbol("x"), var(symbol("x"))); // Safety
+    if (env_count >= 63) return fun(ctx, symbol(ctx, "x"), var(ctx, symbol(ctx, "x"))); // Safety
     
     for(int i=0; i<env_count; ++i) new_env[i] = env[i];
     new_env[env_count] = param_name;
 
-    return fun(
-        symbol(param_name),
-        generate_rich_combinator(current_depth + 1, max_depth, new_env, env_count + 1)
+    return fun(ctx, 
+        symbol(ctx, param_name),
+        generate_rich_combinator(ctx, current_depth + 1, max_depth, new_env, env_count + 1)
     );
 
 do_app:;
     // Application: (A B)
-    return app(
-        generate_rich_combinator(current_depth + 1, max_depth, env, env_count),
-        generate_rich_combinator(current_depth + 1, max_depth, env, env_count)
+    return app(ctx, 
+        generate_rich_combinator(ctx, current_depth + 1, max_depth, env, env_count),
+        generate_rich_combinator(ctx, current_depth + 1, max_depth, env, env_count)
     );
 }
 
 // Helper to detect identity function \x.x
-bool is_identity(Expr_Index expr) {
-    if (expr_slot(expr).kind == EXPR_FUN) {
-        Symbol p = expr_slot(expr).as.fun.param;
-        Expr_Index body = expr_slot(expr).as.fun.body;
-        if (expr_slot(body).kind == EXPR_VAR) {
-            return symbol_eq(p, expr_slot(body).as.var);
+bool is_identity(Lamb_Context *ctx, Expr_Index expr) {
+    if (expr_slot(ctx, expr).kind == EXPR_FUN) {
+        Symbol p = expr_slot(ctx, expr).as.fun.param;
+        Expr_Index body = expr_slot(ctx, expr).as.fun.body;
+        if (expr_slot(ctx, body).kind == EXPR_VAR) {
+            return symbol_eq(p, expr_slot(ctx, body).as.var);
         }
     }
     return false;
@@ -1063,40 +2408,40 @@ bool is_identity(Expr_Index expr) {
 
 // Detect Church True: λx.λy.x (selects first argument)
 // Structure: FUN(x, FUN(y, VAR(x)))
-bool is_church_true(Expr_Index expr) {
-    if (expr_slot(expr).kind != EXPR_FUN) return false;
+bool is_church_true(Lamb_Context *ctx, Expr_Index expr) {
+    if (expr_slot(ctx, expr).kind != EXPR_FUN) return false;
     
-    Symbol x = expr_slot(expr).as.fun.param;
-    Expr_Index inner = expr_slot(expr).as.fun.body;
+    Symbol x = expr_slot(ctx, expr).as.fun.param;
+    Expr_Index inner = expr_slot(ctx, expr).as.fun.body;
     
-    if (expr_slot(inner).kind != EXPR_FUN) return false;
+    if (expr_slot(ctx, inner).kind != EXPR_FUN) return false;
     
     // Symbol y = expr_slot(inner).as.fun.param;  // Not needed for check
-    Expr_Index body = expr_slot(inner).as.fun.body;
+    Expr_Index body = expr_slot(ctx, inner).as.fun.body;
     
     // Body should be VAR(x)
-    if (expr_slot(body).kind != EXPR_VAR) return false;
+    if (expr_slot(ctx, body).kind != EXPR_VAR) return false;
     
-    return symbol_eq(expr_slot(body).as.var, x);
+    return symbol_eq(expr_slot(ctx, body).as.var, x);
 }
 
 // Detect Church False: λx.λy.y (selects second argument)
 // Structure: FUN(x, FUN(y, VAR(y)))
-bool is_church_false(Expr_Index expr) {
-    if (expr_slot(expr).kind != EXPR_FUN) return false;
+bool is_church_false(Lamb_Context *ctx, Expr_Index expr) {
+    if (expr_slot(ctx, expr).kind != EXPR_FUN) return false;
     
     // Symbol x = expr_slot(expr).as.fun.param;  // Not needed for check
-    Expr_Index inner = expr_slot(expr).as.fun.body;
+    Expr_Index inner = expr_slot(ctx, expr).as.fun.body;
     
-    if (expr_slot(inner).kind != EXPR_FUN) return false;
+    if (expr_slot(ctx, inner).kind != EXPR_FUN) return false;
     
-    Symbol y = expr_slot(inner).as.fun.param;
-    Expr_Index body = expr_slot(inner).as.fun.body;
+    Symbol y = expr_slot(ctx, inner).as.fun.param;
+    Expr_Index body = expr_slot(ctx, inner).as.fun.body;
     
     // Body should be VAR(y)
-    if (expr_slot(body).kind != EXPR_VAR) return false;
+    if (expr_slot(ctx, body).kind != EXPR_VAR) return false;
     
-    return symbol_eq(expr_slot(body).as.var, y);
+    return symbol_eq(expr_slot(ctx, body).as.var, y);
 }
 
 // ============================================================================
@@ -1112,12 +2457,73 @@ int compare_strings(const void *a, const void *b) {
 // GC DIAGNOSTICS
 // ============================================================================
 
-size_t gc_slot_count(void) {
-    return GC.slots.count;
+size_t gc_slot_count(Lamb_Context *ctx) {
+    return ctx->gc.slots.count;
+}
+
+size_t gc_dead_count(Lamb_Context *ctx) {
+    return ctx->gc.dead.count;
+}
+
+Gc_Stats gc_stats(Lamb_Context *ctx) {
+    Gc_Stats stats = {0};
+    stats.slots = ctx->gc.slots.count;
+    stats.dead = ctx->gc.dead.count;
+    stats.live = ctx->gc.slots.count - ctx->gc.dead.count;
+    stats.live_after_gc = ctx->gc.live_after_gc;
+    stats.peak_slots = ctx->gc.slots.count > ctx->gc.peak_slots ? ctx->gc.slots.count : ctx->gc.peak_slots;
+    stats.bytes_allocated = ctx->gc.allocated * sizeof(Expr);
+    stats.bytes_promoted = ctx->gc.promoted * sizeof(Expr);
+    stats.bytes_committed = ctx->gc.slots.capacity * sizeof(Expr);
+    stats.heap_budget = ctx->gc.heap_budget;
+    stats.minor_collections = ctx->gc.minor_collections;
+    stats.major_collections = ctx->gc.major_collections;
+    return stats;
+}
+
+bool gc_should_collect(Lamb_Context *ctx) {
+    // Reference counting only touches what changed since the last gc()
+    if (ctx->gc.mode == GC_MODE_REFCOUNT) return true;
+
+    size_t allocated = ctx->gc.allocated * sizeof(Expr);
+    size_t trigger = ctx->gc.live_after_gc * sizeof(Expr);
+    if (trigger < GC_TRIGGER_MIN_BYTES) trigger = GC_TRIGGER_MIN_BYTES;
+    if (ctx->gc.heap_budget > 0) {
+        size_t live = ctx->gc.live_after_gc * sizeof(Expr);
+        size_t headroom = ctx->gc.heap_budget > live ? ctx->gc.heap_budget - live : 0;
+        // Over (or near) the budget: keep collecting, but not on every step
+        if (headroom < GC_TRIGGER_MIN_BYTES / 16) headroom = GC_TRIGGER_MIN_BYTES / 16;
+        if (trigger > headroom) trigger = headroom;
+    }
+    return allocated >= trigger;
+}
+
+// Never in incremental mode: compaction rewrites the whole arena in one go,
+// which is the very pause the frame budget is there to avoid. Dead slots are
+// reused by alloc_expr() anyway.
+bool gc_should_compact(Lamb_Context *ctx) {
+    if (ctx->gc.mode == GC_MODE_INCREMENTAL) return false;
+    return ctx->gc.slots.count * sizeof(Expr) >= GC_COMPACT_MIN_BYTES &&
+           ctx->gc.dead.count >= ctx->gc.slots.count / 2;
+}
+
+void gc_set_heap_budget(Lamb_Context *ctx, size_t bytes) {
+    ctx->gc.heap_budget = bytes;
 }
 
-size_t gc_dead_count(void) {
-    return GC.dead.count;
+// Only for scratch heaps: app roots are not forgotten and nothing is traced
+void gc_reset(Lamb_Context *ctx) {
+    ctx->gc.slots.count = 0;
+    ctx->gc.dead.count = 0;
+    ctx->gc.young.count = 0;
+    ctx->gc.old.count = 0;
+    ctx->gc.remembered.count = 0;
+    ctx->gc.gray.count = 0;
+    ctx->gc.released.count = 0;
+    ctx->gc.pinned.count = 0;
+    ctx->gc.phase = GC_PHASE_IDLE;
+    ctx->gc.allocated = 0;
+    ctx->gc.old_after_major = 0;
 }
 
 // Copyright 2025 Alexey Kutepov <reximkut@gmail.com>
@@ -4,7 +4,7 @@
 // Build: make view (requires raylib)
 // 
 // Visual encoding:
-//   HUE:        Identity (structural hash of expression)
+//   HUE:        Identity (alpha-invariant hash of expression)
 //   SATURATION: Complexity (mass of AST)
 //   ALPHA:      Dominance (frequency in population)
 //
@@ -34,8 +34,7 @@
 #define DEFAULT_DEPTH 5
 #define DEFAULT_EVAL_STEPS 100
 #define DEFAULT_MAX_MASS 2000
-
-#define MAX_SPECIES_TRACKED 2048
+#define DEFAULT_GC_BUDGET_US 2000
 
 // Runtime configuration (set from CLI or defaults)
 static int config_grid_w = DEFAULT_GRID_W;
@@ -45,171 +44,38 @@ static int config_density = DEFAULT_SEED_DENSITY;
 static int config_depth = DEFAULT_DEPTH;
 static int config_eval_steps = DEFAULT_EVAL_STEPS;
 static int config_max_mass = DEFAULT_MAX_MASS;
-
-// ============================================================================
-// HASHING UTILITIES
-// ============================================================================
-
-// DJB2 Hash function variant
-static uint32_t hash_string(const char *str) {
-    uint32_t hash = 5381;
-    int c;
-    while ((c = *str++)) {
-        hash = ((hash << 5) + hash) + (uint32_t)c;
-    }
-    return hash;
-}
-
-// Recursive AST Hasher (No allocation)
-// Walks the GC slots directly to compute a structural ID
-// Uses expr_slot_unsafe to avoid assertions on potentially dead slots
-static uint32_t hash_expr(Expr_Index expr) {
-    // Safety check: ensure index is valid and expression is live
-    if (expr.unwrap >= GC.slots.count) return 0;
-    Expr *e = &expr_slot_unsafe(expr);
-    if (!e->live) return 0;
-    
-    uint32_t h = 0;
-    
-    switch (e->kind) {
-    case EXPR_VAR:
-        h = hash_string(e->as.var.label);
-        h = h ^ ((uint32_t)e->as.var.tag * 33);
-        return h;
-    case EXPR_MAG:
-        return hash_string(e->as.mag) ^ 0xAAAAAAAA;
-    case EXPR_FUN:
-        h = hash_string(e->as.fun.param.label);
-        // Combine with body hash
-        return (h << 3) ^ hash_expr(e->as.fun.body);
-    case EXPR_APP:
-        // Combine LHS and RHS
-        return (hash_expr(e->as.app.lhs) * 33) ^ 
-               hash_expr(e->as.app.rhs);
-    default: 
-        return 0;
-    }
-}
+static int config_gc_budget_us = DEFAULT_GC_BUDGET_US;  // 0 = stop-the-world
+static bool config_refcount = false;
+static int config_heap_budget_mb = 0;  // 0 = unlimited
+static int config_threads = 1;         // 0 = one per CPU
+static bool config_blocks = false;     // Blocked cell layout
+static uint64_t config_seed = 0;
+static bool config_seed_set = false;   // Seeded from the clock otherwise
 
 // ============================================================================
 // SPECIES STATISTICS
 // ============================================================================
 
-typedef struct {
-    uint32_t hash;
-    int count;
-} SpeciesInfo;
-
-static SpeciesInfo species_stats[MAX_SPECIES_TRACKED];
-static int species_count = 0;
-static int max_frequency = 1;
-
-// Pre-allocated sort buffer to avoid per-frame malloc/free
-static uint32_t *sort_buf = NULL;
-static size_t sort_buf_capacity = 0;
-
-// Comparator for qsort
-static int compare_hashes(const void *a, const void *b) {
-    uint32_t h1 = *(const uint32_t*)a;
-    uint32_t h2 = *(const uint32_t*)b;
-    if (h1 < h2) return -1;
-    if (h1 > h2) return 1;
-    return 0;
-}
-
-// Analyze frame: compute hashes and species frequencies (with caching)
-static void analyze_frame(Grid *g, uint32_t *cell_hashes) {
-    species_count = 0;
-    max_frequency = 1;
-    
-    int total_cells = g->width * g->height;
-    
-    // Ensure sort buffer is large enough (reuse allocation)
-    if (sort_buf_capacity < (size_t)total_cells) {
-        free(sort_buf);
-        sort_buf_capacity = (size_t)total_cells;
-        sort_buf = malloc(sort_buf_capacity * sizeof(uint32_t));
-    }
-    
-    int occupied_count = 0;
-
-    // 1. Compute hashes for occupied cells (use cache when valid)
-    for (int i = 0; i < total_cells; ++i) {
-        if (g->cells[i].occupied) {
-            // Use cached hash if valid, otherwise compute and cache
-            if (!g->cells[i].cache_valid) {
-                g->cells[i].cached_hash = hash_expr(g->cells[i].atom);
-                g->cells[i].cached_mass = expr_mass(g->cells[i].atom);
-                g->cells[i].cache_valid = true;
-            }
-            uint32_t h = g->cells[i].cached_hash;
-            cell_hashes[i] = h;
-            sort_buf[occupied_count++] = h;
-        } else {
-            cell_hashes[i] = 0;
-        }
-    }
-
-    if (occupied_count == 0) {
-        return;
+// Species counts come straight from the grid's histogram. Only the masses of
+// cells whose atom changed since the last frame get computed.
+static void analyze_frame(Grid *g) {
+    for (int i = 0; i < g->cell_count; ++i) {
+        Cell_Info *info = &g->info[i];
+        if (!g->cells[i].occupied || info->cache_valid) continue;
+        info->cached_mass = expr_mass(g->ctx, cell_atom(&g->cells[i]));
+        info->cache_valid = true;
     }
-
-    // 2. Sort to group identical hashes
-    qsort(sort_buf, (size_t)occupied_count, sizeof(uint32_t), compare_hashes);
-
-    // 3. Run Length Encoding to get counts
-    uint32_t current_hash = sort_buf[0];
-    int current_count = 1;
-
-    for (int i = 1; i < occupied_count; ++i) {
-        if (sort_buf[i] == current_hash) {
-            current_count++;
-        } else {
-            // Commit previous species
-            if (species_count < MAX_SPECIES_TRACKED) {
-                species_stats[species_count].hash = current_hash;
-                species_stats[species_count].count = current_count;
-                species_count++;
-                if (current_count > max_frequency) {
-                    max_frequency = current_count;
-                }
-            }
-            // Reset for next species
-            current_hash = sort_buf[i];
-            current_count = 1;
-        }
-    }
-    
-    // Commit last species
-    if (species_count < MAX_SPECIES_TRACKED) {
-        species_stats[species_count].hash = current_hash;
-        species_stats[species_count].count = current_count;
-        species_count++;
-        if (current_count > max_frequency) {
-            max_frequency = current_count;
-        }
-    }
-}
-
-// Look up frequency for a given hash (linear scan - acceptable for <2K species)
-static int get_species_freq(uint32_t hash) {
-    for (int i = 0; i < species_count; ++i) {
-        if (species_stats[i].hash == hash) {
-            return species_stats[i].count;
-        }
-    }
-    return 1;
 }
 
 // ============================================================================
 // COLORING LOGIC
 // ============================================================================
 
-static Color get_cell_color_dynamic(Cell *c, uint32_t hash, int freq, int max_freq) {
+static Color get_cell_color_dynamic(Cell *c, Cell_Info *info, uint64_t hash, int freq, int max_freq) {
     if (!c->occupied) return BLACK;
 
     // Use cached mass (computed during analyze_frame)
-    size_t mass = c->cached_mass;
+    size_t mass = info->cached_mass;
     
     // 1. HUE: Identity (Deterministic based on structure)
     // Map hash to 0..360 degrees
@@ -258,8 +124,8 @@ typedef enum {
 
 // Use the shared active_grid from lamb_grid.c (non-static when LAMB_LIBRARY_MODE)
 extern Grid active_grid;
+static Lamb_Context view_ctx = {0};
 static Bindings bindings = {0};
-static uint32_t *frame_hashes = NULL;
 
 static SimState sim_state = STATE_PAUSED;
 static int sim_speed = 1;  // Steps per frame
@@ -279,6 +145,12 @@ static void print_usage(const char *program_name) {
     printf("  --depth <n>          Max expression depth for seeding (default: %d)\n", DEFAULT_DEPTH);
     printf("  --eval-steps, -e <n> Max evaluation steps per reaction (default: %d)\n", DEFAULT_EVAL_STEPS);
     printf("  --max-mass, -m <n>   Max allowed AST mass (default: %d)\n", DEFAULT_MAX_MASS);
+    printf("  --gc-budget, -g <us> Old-space GC time per frame, 0 for stop-the-world (default: %d)\n", DEFAULT_GC_BUDGET_US);
+    printf("  --refcount, -r       Free molecules as soon as they die (overrides --gc-budget)\n");
+    printf("  --heap-budget, -b <MB> Collect harder to keep live nodes under this size (default: unlimited)\n");
+    printf("  --threads, -t <n>    Threads updating the grid, 0 for one per CPU (default: 1)\n");
+    printf("  --seed, -s <n>       Seed of the random stream (default: from the clock)\n");
+    printf("  --blocks, -B         Store the cells in %dx%d blocks (sides must be multiples of %d)\n", GRID_BLOCK, GRID_BLOCK, GRID_BLOCK);
     printf("  --help, -h           Show this help message\n");
     printf("\nControls:\n");
     printf("  SPACE     Start/Pause simulation\n");
@@ -299,6 +171,12 @@ static void parse_args(int argc, char **argv) {
         {"depth",      required_argument, 0, 'D'},
         {"eval-steps", required_argument, 0, 'e'},
         {"max-mass",   required_argument, 0, 'm'},
+        {"gc-budget",  required_argument, 0, 'g'},
+        {"refcount",   no_argument,       0, 'r'},
+        {"heap-budget", required_argument, 0, 'b'},
+        {"threads",    required_argument, 0, 't'},
+        {"seed",       required_argument, 0, 's'},
+        {"blocks",     no_argument,       0, 'B'},
         {"help",       no_argument,       0, 'h'},
         {0, 0, 0, 0}
     };
@@ -306,7 +184,7 @@ static void parse_args(int argc, char **argv) {
     int opt;
     int option_index = 0;
     
-    while ((opt = getopt_long(argc, argv, "W:H:c:d:D:e:m:h", long_options, &option_index)) != -1) {
+    while ((opt = getopt_long(argc, argv, "W:H:c:d:D:e:m:g:rb:t:s:Bh", long_options, &option_index)) != -1) {
         switch (opt) {
             case 'W':
                 config_grid_w = atoi(optarg);
@@ -336,6 +214,31 @@ static void parse_args(int argc, char **argv) {
                 config_max_mass = atoi(optarg);
                 if (config_max_mass <= 0) config_max_mass = DEFAULT_MAX_MASS;
                 break;
+            case 'g':
+                config_gc_budget_us = atoi(optarg);
+                if (config_gc_budget_us < 0) config_gc_budget_us = DEFAULT_GC_BUDGET_US;
+                break;
+            case 'r':
+                config_refcount = true;
+                break;
+            case 'b':
+                config_heap_budget_mb = atoi(optarg);
+                if (config_heap_budget_mb < 0) config_heap_budget_mb = 0;
+                break;
+            case 't':
+                config_threads = atoi(optarg);
+                if (config_threads < 0) config_threads = 1;
+                break;
+            case 's':
+                if (!parse_seed(optarg, &config_seed)) {
+                    fprintf(stderr, "ERROR: --seed expects a number\n");
+                    exit(1);
+                }
+                config_seed_set = true;
+                break;
+            case 'B':
+                config_blocks = true;
+                break;
             case 'h':
                 print_usage(argv[0]);
                 exit(0);
@@ -351,11 +254,15 @@ static void parse_args(int argc, char **argv) {
 // ============================================================================
 
 int main(int argc, char **argv) {
+    Lamb_Context *ctx = &view_ctx;
+
     // Parse command-line arguments
     parse_args(argc, argv);
     
     // Initialize random seed
-    srand((unsigned)time(NULL));
+    if (!config_seed_set) config_seed = seed_from_time();
+    rng_seed(&ctx->rng, config_seed);
+    printf("Seed: %llu\n", (unsigned long long)config_seed);
     
     // Calculate initial window dimensions from config
     int init_window_w = config_grid_w * config_cell_size;
@@ -367,16 +274,23 @@ int main(int argc, char **argv) {
     SetWindowMinSize(200, 160);  // Minimum size for tiling WMs
     SetTargetFPS(60);
     
+    // Spread major collections over frames instead of stalling one of them
+    gc_set_heap_budget(ctx, (size_t)config_heap_budget_mb << 20);
+    if (config_refcount) {
+        gc_set_mode(ctx, GC_MODE_REFCOUNT);
+    } else if (config_gc_budget_us > 0) {
+        gc_set_mode(ctx, GC_MODE_INCREMENTAL);
+    }
+
     // Initialize grid
-    grid_init(&active_grid, config_grid_w, config_grid_h);
+    grid_set_layout(&active_grid, config_blocks);
+    grid_init(&active_grid, ctx, config_grid_w, config_grid_h);
+    grid_set_threads(&active_grid, config_threads);
     
     // Seed with combinators
     int count = (config_grid_w * config_grid_h * config_density) / 100;
     grid_seed(&active_grid, count, config_depth);
     
-    // Allocate hash buffer
-    frame_hashes = malloc((size_t)(config_grid_w * config_grid_h) * sizeof(uint32_t));
-    
     printf("LAMB VIEW starting with:\n");
     printf("  Grid:       %dx%d (%d cells)\n", config_grid_w, config_grid_h, config_grid_w * config_grid_h);
     printf("  Cell size:  %d px\n", config_cell_size);
@@ -384,6 +298,11 @@ int main(int argc, char **argv) {
     printf("  Depth:      %d\n", config_depth);
     printf("  Eval steps: %d\n", config_eval_steps);
     printf("  Max mass:   %d\n", config_max_mass);
+    printf("  Threads:    %d\n", grid_threads(&active_grid));
+    printf("  GC:         %s", gc_mode_name(ctx->gc.mode));
+    if (ctx->gc.mode == GC_MODE_INCREMENTAL) printf(" (%d us/frame)", config_gc_budget_us);
+    if (config_heap_budget_mb > 0) printf(", %d MB heap budget", config_heap_budget_mb);
+    printf("\n");
     
     // Colors for UI
     Color bg_color = (Color){ 10, 10, 15, 255 };       // Near-black with slight blue
@@ -414,7 +333,7 @@ int main(int argc, char **argv) {
         // Reset with R
         if (IsKeyPressed(KEY_R)) {
             grid_free(&active_grid);
-            grid_init(&active_grid, config_grid_w, config_grid_h);
+            grid_init(&active_grid, ctx, config_grid_w, config_grid_h);
             grid_seed(&active_grid, count, config_depth);
             sim_state = STATE_PAUSED;
         }
@@ -435,8 +354,12 @@ int main(int argc, char **argv) {
             sim_state = STATE_PAUSED;
         }
         
+        // Advance the incremental collector by at most one budget slice
+        gc_step(ctx, bindings, (uint64_t)config_gc_budget_us);
+        
         // Analyze frame for species frequencies
-        analyze_frame(&active_grid, frame_hashes);
+        analyze_frame(&active_grid);
+        int max_frequency = active_grid.histogram.max_freq > 0 ? (int)active_grid.histogram.max_freq : 1;
         
         // ==================== RENDERING ====================
         
@@ -469,14 +392,14 @@ int main(int argc, char **argv) {
         // Draw grid cells
         for (int y = 0; y < active_grid.height; y++) {
             for (int x = 0; x < active_grid.width; x++) {
-                int idx = y * active_grid.width + x;
+                int idx = grid_idx(&active_grid, x, y);
                 Cell *c = &active_grid.cells[idx];
                 
                 if (c->occupied) {
-                    uint32_t h = frame_hashes[idx];
-                    int freq = get_species_freq(h);
+                    uint64_t h = active_grid.info[idx].hash;
+                    int freq = (int)grid_species_count(&active_grid, h);
                     
-                    Color cell_color = get_cell_color_dynamic(c, h, freq, max_frequency);
+                    Color cell_color = get_cell_color_dynamic(c, &active_grid.info[idx], h, freq, max_frequency);
                     
                     DrawRectangle(
                         offset_x + x * dynamic_cell_size, 
@@ -497,13 +420,15 @@ int main(int argc, char **argv) {
         const char *state_str = (sim_state == STATE_RUNNING) ? "RUNNING" : "PAUSED";
         int pop = grid_population(&active_grid);
         
-        DrawText(TextFormat("Step: %ld | Pop: %d | Species: %d | %s | Speed: %dx", 
-                           active_grid.steps, pop, species_count, state_str, sim_speed),
+        DrawText(TextFormat("Step: %ld | Pop: %d | Species: %zu | %s | Speed: %dx", 
+                           active_grid.steps, pop, active_grid.histogram.unique, state_str, sim_speed),
                  10, ui_y + 8, 18, text_color);
         
-        DrawText(TextFormat("React: %ld OK / %ld Div | Deaths: %ld | Moves: %ld",
+        Gc_Stats heap = gc_stats(ctx);
+        DrawText(TextFormat("React: %ld OK / %ld Div | Deaths: %ld | Moves: %ld | Heap: %.1f MB",
                            active_grid.reactions_success, active_grid.reactions_diverged,
-                           active_grid.deaths_age, active_grid.movements),
+                           active_grid.deaths_age, active_grid.movements,
+                           heap.live * sizeof(Expr) / 1048576.0),
                  10, ui_y + 30, 16, (Color){ 150, 150, 170, 255 });
         
         // Mini help
@@ -543,10 +468,6 @@ int main(int argc, char **argv) {
     }
     
     // Cleanup
-    free(frame_hashes);
-    free(sort_buf);
-    sort_buf = NULL;
-    sort_buf_capacity = 0;
     grid_free(&active_grid);
     CloseWindow();
     
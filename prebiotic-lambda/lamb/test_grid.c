@@ -0,0 +1,556 @@
+#define LAMB_LIBRARY_MODE
+#include "lamb_grid.c"
+
+// -----------------------------------------------------------------------------
+// TEST UTILITIES
+// -----------------------------------------------------------------------------
+
+int tests_run = 0;
+int tests_passed = 0;
+
+#define ASSERT_STR_EQ(actual, expected) \
+    do { \
+        if (strcmp((actual), (expected)) != 0) { \
+            fprintf(stderr, "[FAIL] %s:%d:\n  Expected: '%s'\n  Actual:   '%s'\n", \
+                    __FILE__, __LINE__, (expected), (actual)); \
+            return false; \
+        } \
+    } while(0)
+
+#define ASSERT_TRUE(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "[FAIL] %s:%d: Assertion failed: %s\n", \
+                    __FILE__, __LINE__, #condition); \
+            return false; \
+        } \
+    } while(0)
+
+#define TEST_CHECKPOINT_PATH "test_grid.ckpt"
+#define TEST_RECORD_PATH "test_grid.rec"
+
+typedef enum {
+    TEST_ROWS,
+    TEST_BLOCKS,
+    TEST_TILED,           // Rows stepped by the checkerboard schedule on 4 threads
+    TEST_SPARSE,
+    TEST_KINETIC,
+} Test_Layout;
+
+static const char *test_layout_names[] = {"rows", "blocks", "tiled", "sparse", "kinetic"};
+
+// A seeded grid of the layout, run for a few steps so that reactions,
+// moves and deaths have all happened
+void test_grid_run(Grid *g, Lamb_Context *ctx, Test_Layout layout, int w, int h, int steps) {
+    Bindings bindings = {0};
+    memset(g, 0, sizeof(*g));
+    rng_seed(&ctx->rng, 42);
+    grid_set_layout(g, layout == TEST_BLOCKS);
+    grid_set_sparse(g, layout == TEST_SPARSE);
+    grid_set_kinetic(g, layout == TEST_KINETIC);
+    grid_init(g, ctx, w, h);
+    grid_set_threads(g, layout == TEST_TILED ? 4 : 1);
+    if (layout == TEST_SPARSE) {
+        grid_seed_colonies(g, 4, 10, 60, 3);
+    } else {
+        grid_seed(g, w*h/2, 3);
+    }
+    for (int i = 0; i < steps; ++i) grid_step(g, bindings, 60, 2000);
+}
+
+// Also stops the worker threads of a tiled grid
+void test_grid_free(Grid *g) {
+    grid_set_threads(g, 1);
+    grid_free(g);
+}
+
+// Cell at (x, y) without allocating the tile of a sparse world, NULL = empty
+Cell_Info *test_cell_at(Grid *g, int x, int y) {
+    x = (x % g->width + g->width) % g->width;
+    y = (y % g->height + g->height) % g->height;
+    int idx;
+    if (g->sparse) {
+        int slot = g->tile_slot[y/GRID_SPARSE_TILE*g->tiles_x + x/GRID_SPARSE_TILE];
+        if (slot < 0) return NULL;
+        idx = slot*GRID_SPARSE_TILE*GRID_SPARSE_TILE + y%GRID_SPARSE_TILE*GRID_SPARSE_TILE + x%GRID_SPARSE_TILE;
+    } else {
+        idx = grid_idx(g, x, y);
+    }
+    return g->cells[idx].occupied ? &g->info[idx] : NULL;
+}
+
+int test_compare_hashes(const void *a, const void *b) {
+    uint64_t ha = *(const uint64_t*)a, hb = *(const uint64_t*)b;
+    return ha < hb ? -1 : ha > hb;
+}
+
+bool test_files_equal(const char *a, const char *b) {
+    String_Builder sa = {0}, sb = {0};
+    bool equal = read_entire_file(a, &sa) && read_entire_file(b, &sb) &&
+                 sa.count == sb.count && memcmp(sa.items, sb.items, sa.count) == 0;
+    free(sa.items);
+    free(sb.items);
+    return equal;
+}
+
+// -----------------------------------------------------------------------------
+// TERM TESTS
+// -----------------------------------------------------------------------------
+
+bool test_encode_decode() {
+    Lamb_Context a = {0}, b = {0};
+    rng_seed(&a.rng, 7);
+    Symbol x = symbol(&a, "x");
+    Symbol x1 = symbol_fresh(&a, x);
+    Expr_Index terms[64];
+    terms[0] = fun(&a, x1, app(&a, var(&a, x1), fun(&a, x, var(&a, x))));
+    terms[1] = app(&a, magic(&a, "void"), var(&a, symbol(&a, "free")));
+    for (size_t i = 2; i < 64; ++i) terms[i] = generate_rich_combinator(&a, 0, 5, NULL, 0);
+
+    Bytes bytes = {0};
+    for (size_t i = 0; i < 64; ++i) {
+        bytes.count = 0;
+        expr_encode(&a, terms[i], &bytes);
+        const uint8_t *p = bytes.items;
+        Expr_Index decoded;
+        ASSERT_TRUE(expr_decode(&b, &p, bytes.items + bytes.count, &decoded));
+        ASSERT_TRUE(p == bytes.items + bytes.count);
+        char *expected = expr_to_string(&a, terms[i]);
+        char *actual = expr_to_string(&b, decoded);
+        ASSERT_STR_EQ(actual, expected);
+        ASSERT_TRUE(expr_hash(&a, terms[i]) == expr_hash(&b, decoded));
+        free(expected);
+        free(actual);
+
+        // Any cut short is refused instead of read past the end
+        p = bytes.items;
+        ASSERT_TRUE(!expr_decode(&b, &p, bytes.items + bytes.count - 1, &decoded));
+    }
+    free(bytes.items);
+    lamb_context_free(&a);
+    lamb_context_free(&b);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// GRID TESTS
+// -----------------------------------------------------------------------------
+
+bool test_sweep_permutation() {
+    Lamb_Rng rng;
+    rng_seed(&rng, 1);
+    size_t sizes[] = {1, 2, 3, 7, 64, 1000, 4097, 65536};
+    for (size_t s = 0; s < sizeof(sizes)/sizeof(sizes[0]); ++s) {
+        size_t n = sizes[s];
+        Grid_Sweep sweep;
+        grid_sweep_init(&sweep, n, &rng);
+        bool *seen = calloc(n, sizeof(*seen));
+        assert(seen != NULL && "Buy more RAM lol");
+        for (uint32_t i = 0; i < n; ++i) {
+            uint32_t j = grid_sweep_at(&sweep, i);
+            ASSERT_TRUE(j < n);
+            ASSERT_TRUE(!seen[j]);
+            seen[j] = true;
+        }
+        free(seen);
+    }
+    return true;
+}
+
+bool test_histogram_matches_census() {
+    for (Test_Layout layout = TEST_ROWS; layout <= TEST_KINETIC; ++layout) {
+        Lamb_Context ctx = {0};
+        Grid g;
+        test_grid_run(&g, &ctx, layout, 96, 80, 30);
+
+        // Recount every species from scratch
+        uint64_t *hashes = malloc(sizeof(*hashes)*(size_t)g.cell_count);
+        assert(hashes != NULL && "Buy more RAM lol");
+        size_t n = 0;
+        for (int i = 0; i < g.cell_count; ++i) {
+            if (g.cells[i].occupied) hashes[n++] = g.info[i].hash;
+        }
+        qsort(hashes, n, sizeof(*hashes), test_compare_hashes);
+        size_t unique = 0, max_freq = 0;
+        for (size_t i = 0; i < n;) {
+            size_t j = i;
+            while (j < n && hashes[j] == hashes[i]) ++j;
+            if (grid_species_count(&g, hashes[i]) != j - i) {
+                fprintf(stderr, "[FAIL] %s: species %016llx has %zu cells, histogram says %zu\n",
+                        test_layout_names[layout], (unsigned long long)hashes[i], j - i,
+                        grid_species_count(&g, hashes[i]));
+                return false;
+            }
+            if (j - i > max_freq) max_freq = j - i;
+            unique += 1;
+            i = j;
+        }
+        ASSERT_TRUE((int)n == grid_population(&g));
+        ASSERT_TRUE(g.histogram.unique == unique);
+        ASSERT_TRUE(g.histogram.max_freq == max_freq);
+        ASSERT_TRUE(n == 0 || grid_species_count(&g, grid_dominant(&g)) == max_freq);
+        free(hashes);
+        test_grid_free(&g);
+        lamb_context_free(&ctx);
+    }
+    return true;
+}
+
+// A step updates every creature once, wherever it moves meanwhile. Ages are
+// zeroed before every step, so a creature updated twice shows up aged 2
+// (unless its second update was a reaction, which rejuvenates it).
+bool test_one_update_per_step() {
+    Test_Layout layouts[] = {TEST_ROWS, TEST_BLOCKS, TEST_TILED};
+    for (size_t l = 0; l < sizeof(layouts)/sizeof(layouts[0]); ++l) {
+        Lamb_Context ctx = {0};
+        Grid g;
+        Bindings bindings = {0};
+        test_grid_run(&g, &ctx, layouts[l], 96, 80, 0);
+        for (int step = 0; step < 50; ++step) {
+            for (int i = 0; i < g.cell_count; ++i) g.cells[i].age = 0;
+            grid_step(&g, bindings, 60, 2000);
+            for (int i = 0; i < g.cell_count; ++i) {
+                if (g.cells[i].occupied && g.cells[i].age > 1) {
+                    fprintf(stderr, "[FAIL] %s: creature updated %d times in step %ld\n",
+                            test_layout_names[layouts[l]], g.cells[i].age, g.steps);
+                    return false;
+                }
+            }
+        }
+        ASSERT_TRUE(grid_population(&g) > 0);
+        test_grid_free(&g);
+        lamb_context_free(&ctx);
+    }
+    return true;
+}
+
+bool test_clusters_match_flood_fill() {
+    static const int dx[4] = {0, 1, 0, -1}, dy[4] = {-1, 0, 1, 0};
+    for (Test_Layout layout = TEST_ROWS; layout <= TEST_SPARSE; ++layout) {
+        Lamb_Context ctx = {0};
+        Grid g;
+        test_grid_run(&g, &ctx, layout, layout == TEST_SPARSE ? 200 : 96, layout == TEST_SPARSE ? 150 : 80, 20);
+        int w = g.width, h = g.height;
+
+        Grid_Clusters clusters = {0};
+        grid_clusters(&g, &clusters);
+
+        bool *seen = calloc((size_t)w*h, sizeof(*seen));
+        int *stack = malloc(sizeof(*stack)*(size_t)w*h);
+        assert(seen != NULL && stack != NULL && "Buy more RAM lol");
+        size_t count = 0, largest = 0, boundary = 0, sizes[GRID_CLUSTER_BINS] = {0};
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                Cell_Info *cell = test_cell_at(&g, x, y);
+                if (cell == NULL) continue;
+                for (int d = 0; d < 4; ++d) {
+                    Cell_Info *other = test_cell_at(&g, x + dx[d], y + dy[d]);
+                    if (other == NULL || other->hash != cell->hash) boundary += 1;
+                }
+                if (seen[y*w + x]) continue;
+
+                size_t size = 0, top = 0;
+                stack[top++] = y*w + x;
+                seen[y*w + x] = true;
+                while (top > 0) {
+                    int p = stack[--top];
+                    size += 1;
+                    for (int d = 0; d < 4; ++d) {
+                        int nx = ((p%w + dx[d]) % w + w) % w, ny = ((p/w + dy[d]) % h + h) % h;
+                        Cell_Info *other = test_cell_at(&g, nx, ny);
+                        if (other && other->hash == cell->hash && !seen[ny*w + nx]) {
+                            seen[ny*w + nx] = true;
+                            stack[top++] = ny*w + nx;
+                        }
+                    }
+                }
+                size_t bin = 0;
+                while (bin + 1 < GRID_CLUSTER_BINS && size >> (bin + 1)) bin += 1;
+                sizes[bin] += 1;
+                count += 1;
+                if (size > largest) largest = size;
+            }
+        }
+        ASSERT_TRUE(count > 0);
+        ASSERT_TRUE(clusters.clusters == count);
+        ASSERT_TRUE(clusters.largest == largest);
+        ASSERT_TRUE(clusters.boundary == boundary);
+        ASSERT_TRUE(memcmp(clusters.sizes, sizes, sizeof(sizes)) == 0);
+
+        free(seen);
+        free(stack);
+        grid_clusters_free(&clusters);
+        test_grid_free(&g);
+        lamb_context_free(&ctx);
+    }
+    return true;
+}
+
+bool test_checkpoint_round_trip() {
+    for (Test_Layout layout = TEST_ROWS; layout <= TEST_KINETIC; ++layout) {
+        Lamb_Context ctx = {0}, restored_ctx = {0};
+        Grid g, restored = {0};
+        test_grid_run(&g, &ctx, layout, 96, 80, 25);
+        ASSERT_TRUE(grid_save_checkpoint(&g, TEST_CHECKPOINT_PATH ".a"));
+        ASSERT_TRUE(grid_load_checkpoint(&restored, &restored_ctx, TEST_CHECKPOINT_PATH ".a"));
+        grid_set_threads(&restored, layout == TEST_TILED ? 4 : 1);
+        ASSERT_TRUE(grid_save_checkpoint(&restored, TEST_CHECKPOINT_PATH ".b"));
+        if (!test_files_equal(TEST_CHECKPOINT_PATH ".a", TEST_CHECKPOINT_PATH ".b")) {
+            fprintf(stderr, "[FAIL] %s: restored checkpoint saves differently\n", test_layout_names[layout]);
+            return false;
+        }
+
+        // Both resume the same run
+        Bindings bindings = {0};
+        for (int i = 0; i < 10; ++i) {
+            grid_step(&g, bindings, 60, 2000);
+            grid_step(&restored, bindings, 60, 2000);
+        }
+        ASSERT_TRUE(grid_save_checkpoint(&g, TEST_CHECKPOINT_PATH ".a"));
+        ASSERT_TRUE(grid_save_checkpoint(&restored, TEST_CHECKPOINT_PATH ".b"));
+        ASSERT_TRUE(test_files_equal(TEST_CHECKPOINT_PATH ".a", TEST_CHECKPOINT_PATH ".b"));
+
+        test_grid_free(&g);
+        test_grid_free(&restored);
+        lamb_context_free(&ctx);
+        lamb_context_free(&restored_ctx);
+    }
+    remove(TEST_CHECKPOINT_PATH ".a");
+    remove(TEST_CHECKPOINT_PATH ".b");
+    return true;
+}
+
+// A checkpoint that fails validation is refused without touching the grid
+bool test_checkpoint_rejected() {
+    Lamb_Context ctx = {0};
+    Grid g;
+    test_grid_run(&g, &ctx, TEST_ROWS, 64, 48, 10);
+    ASSERT_TRUE(grid_save_checkpoint(&g, TEST_CHECKPOINT_PATH ".a"));
+    String_Builder good = {0};
+    ASSERT_TRUE(read_entire_file(TEST_CHECKPOINT_PATH ".a", &good));
+    Grid_Checkpoint_Header h;
+    memcpy(&h, good.items, sizeof(h));
+    ASSERT_TRUE(h.node_count > 1 && h.active_count > 1);
+
+    String_Builder bad = {0};
+    for (int corruption = 0; corruption < 2; ++corruption) {
+        bad.count = 0;
+        for (size_t i = 0; i < good.count; ++i) da_append(&bad, good.items[i]);
+        if (corruption == 0) {
+            // The first node with children points at the last node instead
+            Grid_Checkpoint_Node *nodes = (void *)(bad.items + sizeof(h));
+            size_t i = 0;
+            while (i < h.node_count && nodes[i].kind != EXPR_FUN && nodes[i].kind != EXPR_APP) ++i;
+            ASSERT_TRUE(i + 1 < h.node_count);
+            nodes[i].lhs = (uint32_t)(h.node_count - 1);
+        } else {
+            // The last active cell is listed twice
+            int *active = (void *)(bad.items + sizeof(h) + h.node_count*sizeof(Grid_Checkpoint_Node) +
+                                   h.cell_count*(sizeof(Grid_Checkpoint_Info) + sizeof(Grid_Checkpoint_Cell)));
+            active[h.active_count - 1] = active[0];
+        }
+        ASSERT_TRUE(write_entire_file(TEST_CHECKPOINT_PATH ".bad", bad.items, bad.count));
+        ASSERT_TRUE(!grid_load_checkpoint(&g, &ctx, TEST_CHECKPOINT_PATH ".bad"));
+        ASSERT_TRUE(grid_save_checkpoint(&g, TEST_CHECKPOINT_PATH ".b"));
+        ASSERT_TRUE(test_files_equal(TEST_CHECKPOINT_PATH ".a", TEST_CHECKPOINT_PATH ".b"));
+    }
+
+    free(good.items);
+    free(bad.items);
+    test_grid_free(&g);
+    lamb_context_free(&ctx);
+    remove(TEST_CHECKPOINT_PATH ".a");
+    remove(TEST_CHECKPOINT_PATH ".b");
+    remove(TEST_CHECKPOINT_PATH ".bad");
+    return true;
+}
+
+// A sparse checkpoint's slot populations and cell hashes are taken from its
+// cells, and a free list that repeats or misses a free slot is refused
+bool test_checkpoint_slots() {
+    Lamb_Context ctx = {0}, restored_ctx = {0};
+    Grid g, restored = {0};
+    test_grid_run(&g, &ctx, TEST_SPARSE, 256, 256, 10);
+    // Two free slots, of tiles that got one and gave it back empty
+    for (int t = 0, freed = 0; freed < 2; ++t) {
+        ASSERT_TRUE(t < g.tiles_x*g.tiles_y);
+        if (g.tile_slot[t] >= 0) continue;
+        grid_idx(&g, (t % g.tiles_x)*GRID_SPARSE_TILE, (t / g.tiles_x)*GRID_SPARSE_TILE);
+        freed++;
+    }
+    grid_tiles_release(&g);
+    ASSERT_TRUE(g.free_slots.count == 2);
+    ASSERT_TRUE(grid_save_checkpoint(&g, TEST_CHECKPOINT_PATH ".a"));
+    String_Builder good = {0};
+    ASSERT_TRUE(read_entire_file(TEST_CHECKPOINT_PATH ".a", &good));
+    Grid_Checkpoint_Header h;
+    memcpy(&h, good.items, sizeof(h));
+    size_t info_at = sizeof(h) + h.node_count*sizeof(Grid_Checkpoint_Node);
+    size_t cells_at = info_at + h.cell_count*sizeof(Grid_Checkpoint_Info);
+    size_t slots_at = cells_at + h.cell_count*sizeof(Grid_Checkpoint_Cell) +
+                      (h.active_count + (size_t)(g.tiles_x*g.tiles_y))*sizeof(int);
+    size_t free_at = slots_at + h.slot_count*sizeof(Grid_Slot);
+    ASSERT_TRUE(h.free_count == 2);
+
+    String_Builder bad = {0};
+    for (int corruption = 0; corruption < 3; ++corruption) {
+        bad.count = 0;
+        for (size_t i = 0; i < good.count; ++i) da_append(&bad, good.items[i]);
+        Grid_Checkpoint_Header *bad_h = (void *)bad.items;
+        Grid_Slot *slots = (void *)(bad.items + slots_at);
+        int *free_slots = (void *)(bad.items + free_at);
+        if (corruption == 0) {
+            // Wrong populations and a missing hash are rebuilt
+            Grid_Checkpoint_Info *info = (void *)(bad.items + info_at);
+            Grid_Checkpoint_Cell *cells = (void *)(bad.items + cells_at);
+            size_t i = 0;
+            while (!cells[i].occupied) ++i;
+            info[i].hash = 0;
+            for (size_t s = 0; s < h.slot_count; ++s) slots[s].population = 0;
+            ASSERT_TRUE(write_entire_file(TEST_CHECKPOINT_PATH ".bad", bad.items, bad.count));
+            ASSERT_TRUE(grid_load_checkpoint(&restored, &restored_ctx, TEST_CHECKPOINT_PATH ".bad"));
+            ASSERT_TRUE(grid_save_checkpoint(&restored, TEST_CHECKPOINT_PATH ".b"));
+            ASSERT_TRUE(test_files_equal(TEST_CHECKPOINT_PATH ".a", TEST_CHECKPOINT_PATH ".b"));
+            continue;
+        }
+        if (corruption == 1) {
+            free_slots[1] = free_slots[0];
+        } else {
+            // The last free slot is left out
+            bad_h->free_count--;
+            memmove(&free_slots[1], &free_slots[2], bad.count - free_at - 2*sizeof(int));
+            bad.count -= sizeof(int);
+        }
+        ASSERT_TRUE(write_entire_file(TEST_CHECKPOINT_PATH ".bad", bad.items, bad.count));
+        ASSERT_TRUE(!grid_load_checkpoint(&g, &ctx, TEST_CHECKPOINT_PATH ".bad"));
+        ASSERT_TRUE(grid_save_checkpoint(&g, TEST_CHECKPOINT_PATH ".b"));
+        ASSERT_TRUE(test_files_equal(TEST_CHECKPOINT_PATH ".a", TEST_CHECKPOINT_PATH ".b"));
+    }
+
+    free(good.items);
+    free(bad.items);
+    test_grid_free(&g);
+    test_grid_free(&restored);
+    lamb_context_free(&ctx);
+    lamb_context_free(&restored_ctx);
+    remove(TEST_CHECKPOINT_PATH ".a");
+    remove(TEST_CHECKPOINT_PATH ".b");
+    remove(TEST_CHECKPOINT_PATH ".bad");
+    return true;
+}
+
+bool test_replay_matches_record() {
+    for (Test_Layout layout = TEST_ROWS; layout <= TEST_TILED; ++layout) {
+        Lamb_Context ctx = {0}, replay_ctx = {0};
+        Grid g, replay = {0};
+        Bindings bindings = {0};
+        test_grid_run(&g, &ctx, layout, 96, 80, 0);
+        // Whichever schedule the log asks for, the replaying grid gets its own workers back
+        grid_set_threads(&replay, 3);
+        Grid_Workers *workers = replay.workers;
+        ASSERT_TRUE(grid_record_start(&g, TEST_RECORD_PATH, 42, 60, 2000));
+        for (int i = 0; i < 40; ++i) grid_step(&g, bindings, 60, 2000);
+        grid_record_stop(&g);
+
+        Grid_Record_Info info;
+        ASSERT_TRUE(grid_replay_start(&replay, &replay_ctx, TEST_RECORD_PATH, false, &info));
+        ASSERT_TRUE(info.seed == 42);
+        ASSERT_TRUE(info.tiled == (layout == TEST_TILED));
+        while (grid_replay_pending(&replay)) grid_step(&replay, bindings, info.eval_steps, info.max_mass);
+        ASSERT_TRUE(grid_replay_mismatches(&replay) == 0);
+        grid_record_stop(&replay);
+        ASSERT_TRUE(replay.workers == workers);
+        ASSERT_TRUE(replay.steps == g.steps);
+        ASSERT_TRUE(replay.reactions_success == g.reactions_success);
+        ASSERT_TRUE(grid_population(&replay) == grid_population(&g));
+
+        test_grid_free(&g);
+        test_grid_free(&replay);
+        lamb_context_free(&ctx);
+        lamb_context_free(&replay_ctx);
+    }
+    remove(TEST_RECORD_PATH);
+    return true;
+}
+
+// A corrupt log is refused without touching the grid: one cut short in its
+// starting cells, and ones whose first term claims more bytes than are left
+bool test_replay_rejected() {
+    Lamb_Context ctx = {0};
+    Grid g;
+    test_grid_run(&g, &ctx, TEST_TILED, 64, 48, 10);
+    Grid_Workers *workers = g.workers;
+    ASSERT_TRUE(grid_save_checkpoint(&g, TEST_CHECKPOINT_PATH ".a"));
+    ASSERT_TRUE(grid_record_start(&g, TEST_RECORD_PATH, 42, 60, 2000));
+    grid_record_stop(&g);
+    String_Builder good = {0};
+    ASSERT_TRUE(read_entire_file(TEST_RECORD_PATH, &good));
+
+    uint64_t codes[] = {2*(uint64_t)1000000 + 2, UINT64_MAX - 1};
+    Bytes bad = {0};
+    for (int corruption = 0; corruption < 3; ++corruption) {
+        bad.count = 0;
+        if (corruption == 0) {
+            for (size_t i = 0; i < good.count/2; ++i) da_append(&bad, (uint8_t)good.items[i]);
+        } else {
+            for (const char *m = GRID_RECORD_MAGIC; *m; ++m) da_append(&bad, (uint8_t)*m);
+            uint64_t header[] = {42, 1, 2, 3, 4, 0, 8, 8, 0, 60, 2000, 1};
+            for (size_t i = 0; i < sizeof(header)/sizeof(header[0]); ++i) bytes_put_varint(&bad, header[i]);
+            bytes_put_varint(&bad, 0);  // position
+            bytes_put_varint(&bad, 0);  // age
+            bytes_put_varint(&bad, 0);  // generation
+            bytes_put_varint(&bad, codes[corruption - 1]);
+            da_append(&bad, 0);
+        }
+        ASSERT_TRUE(write_entire_file(TEST_RECORD_PATH, bad.items, bad.count));
+        ASSERT_TRUE(!grid_replay_start(&g, &ctx, TEST_RECORD_PATH, false, NULL));
+        ASSERT_TRUE(g.record == NULL && g.workers == workers);
+        ASSERT_TRUE(grid_save_checkpoint(&g, TEST_CHECKPOINT_PATH ".b"));
+        ASSERT_TRUE(test_files_equal(TEST_CHECKPOINT_PATH ".a", TEST_CHECKPOINT_PATH ".b"));
+    }
+
+    free(good.items);
+    free(bad.items);
+    test_grid_free(&g);
+    lamb_context_free(&ctx);
+    remove(TEST_CHECKPOINT_PATH ".a");
+    remove(TEST_CHECKPOINT_PATH ".b");
+    remove(TEST_RECORD_PATH);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// RUNNER
+// -----------------------------------------------------------------------------
+
+void run_test(bool (*func)(), const char* name) {
+    tests_run++;
+    printf("Running %-30s ... ", name);
+    fflush(stdout);
+    if (func()) {
+        printf("PASS\n");
+        tests_passed++;
+    } else {
+        // FAIL is printed inside macro
+    }
+}
+
+int main(void) {
+    printf("=== Lamb Grid Tests ===\n");
+
+    run_test(test_encode_decode, "Term Encode/Decode");
+    run_test(test_sweep_permutation, "Feistel Sweep Permutation");
+    run_test(test_histogram_matches_census, "Histogram vs Census");
+    run_test(test_one_update_per_step, "One Update per Step");
+    run_test(test_clusters_match_flood_fill, "Clusters vs Flood Fill");
+    run_test(test_checkpoint_round_trip, "Checkpoint Round Trip");
+    run_test(test_checkpoint_rejected, "Corrupt Checkpoint Refused");
+    run_test(test_checkpoint_slots, "Checkpoint Slots Checked");
+    run_test(test_replay_matches_record, "Replay of a Record");
+    run_test(test_replay_rejected, "Corrupt Log Refused");
+
+    printf("\nResults: %d/%d passed.\n", tests_passed, tests_run);
+
+    if (tests_passed == tests_run) return 0;
+    return 1;
+}